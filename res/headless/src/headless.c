@@ -0,0 +1,376 @@
+#include "platform.h"
+
+#include "building/building.h"
+#include "building/model.h"
+#include "building/properties.h"
+#include "core/file.h"
+#include "core/config.h"
+#include "core/random.h"
+#include "game/file.h"
+#include "game/file_io.h"
+#include "game/game.h"
+#include "game/profiler.h"
+#include "game/resource.h"
+#include "game/settings.h"
+#include "game/state.h"
+#include "game/system.h"
+#include "game/tick.h"
+#include "game/time.h"
+#include "graphics/window.h"
+#include "platform/file_manager.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_TICKS 9600 // one game year: 50 ticks * 16 days * 12 months
+#define DEFAULT_SEED 1
+#define DEFAULT_BENCHMARK_FILE "benchmark.svx"
+
+static struct {
+    const char *data_directory;
+    const char *savegame;
+    const char *output;
+    const char *profile;
+    int save_rounds;
+    int scan_rounds;
+    int fast_save_format;
+    int ticks;
+    int warmup_ticks;
+    unsigned int seed;
+    int threads;
+    int quiet;
+} args;
+
+static void print_usage(void)
+{
+    printf("Usage: augustus_headless [OPTIONS] SAVEGAME\n\n"
+        "Loads SAVEGAME (.sav or .svx), runs the simulation without rendering and\n"
+        "reports the tick throughput and a checksum of the resulting game state.\n\n"
+        "Options:\n"
+        "  --data-dir DIR   Caesar 3 data directory (default: current directory)\n"
+        "  --ticks N        Number of ticks to measure (default: %d, one game year)\n"
+        "  --warmup N       Number of ticks to run before measuring (default: 0)\n"
+        "  --seed N         Seed for the non-simulation random generator (default: %d)\n"
+        "  --output FILE    Save the game state after the run to FILE\n"
+        "  --profile NAME   Profile the tick slots and write NAME.csv and NAME.json\n"
+        "  --threads N      Number of worker threads (default: one per processor)\n"
+        "  --benchmark-save N\n"
+        "                   After the run, save and load the game N times and report\n"
+        "                   the latencies, using the --output file or %s\n"
+        "  --fast-save      Save in the fast save format\n"
+        "  --benchmark-scans N\n"
+        "                   After the run, scan the buildings for houses in use N times,\n"
+        "                   once through the building records and once through the\n"
+        "                   copied building fields, and report the latencies\n"
+        "  --quiet          Do not print info log messages\n",
+        DEFAULT_TICKS, DEFAULT_SEED, DEFAULT_BENCHMARK_FILE);
+}
+
+static int parse_int_argument(const char *value, int *result)
+{
+    char *end;
+    long number = strtol(value, &end, 10);
+    if (!*value || *end || number < 0) {
+        return 0;
+    }
+    *result = (int) number;
+    return 1;
+}
+
+static int parse_arguments(int argc, char **argv)
+{
+    args.ticks = DEFAULT_TICKS;
+    args.seed = DEFAULT_SEED;
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        int has_value = i + 1 < argc;
+        int seed = 0;
+        if (strcmp(arg, "--data-dir") == 0 && has_value) {
+            args.data_directory = argv[++i];
+        } else if (strcmp(arg, "--ticks") == 0 && has_value) {
+            if (!parse_int_argument(argv[++i], &args.ticks) || !args.ticks) {
+                return 0;
+            }
+        } else if (strcmp(arg, "--warmup") == 0 && has_value) {
+            if (!parse_int_argument(argv[++i], &args.warmup_ticks)) {
+                return 0;
+            }
+        } else if (strcmp(arg, "--seed") == 0 && has_value) {
+            if (!parse_int_argument(argv[++i], &seed)) {
+                return 0;
+            }
+            args.seed = (unsigned int) seed;
+        } else if (strcmp(arg, "--output") == 0 && has_value) {
+            args.output = argv[++i];
+        } else if (strcmp(arg, "--profile") == 0 && has_value) {
+            args.profile = argv[++i];
+        } else if (strcmp(arg, "--threads") == 0 && has_value) {
+            if (!parse_int_argument(argv[++i], &args.threads) || !args.threads) {
+                return 0;
+            }
+        } else if (strcmp(arg, "--benchmark-save") == 0 && has_value) {
+            if (!parse_int_argument(argv[++i], &args.save_rounds)) {
+                return 0;
+            }
+        } else if (strcmp(arg, "--benchmark-scans") == 0 && has_value) {
+            if (!parse_int_argument(argv[++i], &args.scan_rounds)) {
+                return 0;
+            }
+        } else if (strcmp(arg, "--fast-save") == 0) {
+            args.fast_save_format = 1;
+        } else if (strcmp(arg, "--quiet") == 0) {
+            args.quiet = 1;
+        } else if (arg[0] == '-' || args.savegame) {
+            return 0;
+        } else {
+            args.savegame = arg;
+        }
+    }
+    return args.savegame != 0;
+}
+
+static int init_game(void)
+{
+    if (args.data_directory && !platform_file_manager_set_base_path(args.data_directory)) {
+        fprintf(stderr, "Unable to use data directory %s\n", args.data_directory);
+        return 0;
+    }
+    platform_headless_init_renderer();
+    if (!game_pre_init()) {
+        return 0;
+    }
+    // game_pre_init resets the random state, so the seed has to be set afterwards
+    random_set_stdlib_seed(args.seed);
+    // The simulation posts city messages to the current window. Without a city window
+    // they are queued instead of opening a message dialog.
+    static window_type window = { WINDOW_LOGO };
+    window_show(&window);
+    if (!model_load()) {
+        fprintf(stderr, "Unable to load c3_model.txt\n");
+        return 0;
+    }
+    building_properties_init();
+    game_state_init();
+    resource_init();
+
+    // Autosaves would add disk I/O to the measured ticks
+    config_set(CONFIG_GP_CH_YEARLY_AUTOSAVE, 0);
+    config_set(CONFIG_GP_CH_FAST_SAVE_FORMAT, args.fast_save_format);
+    if (setting_monthly_autosave()) {
+        setting_toggle_monthly_autosave();
+    }
+    return 1;
+}
+
+static int compare_micros(const void *a, const void *b)
+{
+    uint64_t va = *(const uint64_t *) a;
+    uint64_t vb = *(const uint64_t *) b;
+    return va < vb ? -1 : va > vb;
+}
+
+static uint64_t percentile(const uint64_t *sorted, int count, int percent)
+{
+    return sorted[(count - 1) * percent / 100];
+}
+
+static void report(uint64_t *tick_micros, int count, uint64_t total_micros)
+{
+    qsort(tick_micros, count, sizeof(uint64_t), compare_micros);
+    double total_seconds = total_micros / 1000000.0;
+    printf("Ticks:            %d\n", count);
+    printf("Worker threads:   %d\n", system_get_num_workers());
+    printf("Total time:       %.3f s\n", total_seconds);
+    printf("Ticks per second: %.1f\n", total_seconds > 0 ? count / total_seconds : 0.0);
+    printf("Tick time (us):   mean %.1f, p50 %llu, p90 %llu, p99 %llu, max %llu\n",
+        (double) total_micros / count,
+        (unsigned long long) percentile(tick_micros, count, 50),
+        (unsigned long long) percentile(tick_micros, count, 90),
+        (unsigned long long) percentile(tick_micros, count, 99),
+        (unsigned long long) tick_micros[count - 1]);
+    printf("Game date:        month %d, year %d\n", game_time_month(), game_time_year());
+    printf("State checksum:   %08x\n", game_file_io_saved_game_checksum());
+}
+
+static void report_latency(const char *name, uint64_t *micros, int count)
+{
+    uint64_t total = 0;
+    for (int i = 0; i < count; i++) {
+        total += micros[i];
+    }
+    qsort(micros, count, sizeof(uint64_t), compare_micros);
+    printf("%-18s mean %.1f, p50 %llu, max %llu\n", name, (double) total / count,
+        (unsigned long long) percentile(micros, count, 50), (unsigned long long) micros[count - 1]);
+}
+
+static int benchmark_saving(const char *filename, int rounds)
+{
+    uint64_t *micros = malloc(sizeof(uint64_t) * rounds * 3);
+    if (!micros) {
+        fprintf(stderr, "Out of memory\n");
+        return 0;
+    }
+    uint64_t *save_micros = micros;
+    uint64_t *written_micros = micros + rounds;
+    uint64_t *load_micros = micros + 2 * rounds;
+    for (int i = 0; i < rounds; i++) {
+        uint64_t start = system_get_microseconds();
+        if (!game_file_write_saved_game(filename)) {
+            fprintf(stderr, "Unable to save game to %s\n", filename);
+            free(micros);
+            return 0;
+        }
+        save_micros[i] = system_get_microseconds() - start;
+        if (!game_file_io_finish_writing_saved_game()) {
+            fprintf(stderr, "Unable to write saved game to %s\n", filename);
+            free(micros);
+            return 0;
+        }
+        written_micros[i] = system_get_microseconds() - start;
+
+        start = system_get_microseconds();
+        if (game_file_load_saved_game(filename) != FILE_LOAD_SUCCESS) {
+            fprintf(stderr, "Unable to load saved game %s\n", filename);
+            free(micros);
+            return 0;
+        }
+        load_micros[i] = system_get_microseconds() - start;
+    }
+    printf("Save rounds:      %d\n", rounds);
+    printf("Latencies in microseconds:\n");
+    report_latency("  Save (blocking):", save_micros, rounds);
+    report_latency("  Save (on disk):", written_micros, rounds);
+    report_latency("  Load:", load_micros, rounds);
+    free(micros);
+    return 1;
+}
+
+static int count_houses_in_records(void)
+{
+    int houses = 0;
+    for (int i = 1; i < building_count(); i++) {
+        const building *b = building_get(i);
+        if (b->state == BUILDING_STATE_IN_USE && b->house_size) {
+            houses++;
+        }
+    }
+    return houses;
+}
+
+static int count_houses_in_hot_fields(void)
+{
+    const building_hot_fields *fields = building_get_hot_fields();
+    int houses = 0;
+    for (int i = 1; i < building_count(); i++) {
+        if (fields->state[i] == BUILDING_STATE_IN_USE && fields->house_size[i]) {
+            houses++;
+        }
+    }
+    return houses;
+}
+
+static int benchmark_scans(int rounds)
+{
+    uint64_t *micros = malloc(sizeof(uint64_t) * rounds * 2);
+    if (!micros) {
+        fprintf(stderr, "Out of memory\n");
+        return 0;
+    }
+    uint64_t *record_micros = micros;
+    uint64_t *hot_micros = micros + rounds;
+    int houses = 0;
+    for (int i = 0; i < rounds; i++) {
+        uint64_t start = system_get_microseconds();
+        int record_houses = count_houses_in_records();
+        record_micros[i] = system_get_microseconds() - start;
+
+        start = system_get_microseconds();
+        houses = count_houses_in_hot_fields();
+        hot_micros[i] = system_get_microseconds() - start;
+        if (houses != record_houses) {
+            fprintf(stderr, "Copied building fields are out of sync: %d houses instead of %d\n",
+                houses, record_houses);
+            free(micros);
+            return 0;
+        }
+    }
+    printf("Scan rounds:      %d (%d buildings, %d houses)\n", rounds, building_count(), houses);
+    printf("Latencies in microseconds:\n");
+    report_latency("  Records:", record_micros, rounds);
+    report_latency("  Copied fields:", hot_micros, rounds);
+    free(micros);
+    return 1;
+}
+
+static int write_profile(const char *name)
+{
+    char filename[FILE_NAME_MAX];
+    snprintf(filename, FILE_NAME_MAX, "%s.csv", name);
+    if (!game_profiler_write_csv(filename)) {
+        return 0;
+    }
+    snprintf(filename, FILE_NAME_MAX, "%s.json", name);
+    return game_profiler_write_json(filename);
+}
+
+int main(int argc, char **argv)
+{
+    if (!parse_arguments(argc, argv)) {
+        print_usage();
+        return 1;
+    }
+    platform_headless_set_quiet(args.quiet);
+    platform_headless_set_num_workers(args.threads);
+    if (!init_game()) {
+        fprintf(stderr, "Unable to initialize the game, is the data directory correct?\n");
+        return 1;
+    }
+    if (game_file_load_saved_game(args.savegame) != FILE_LOAD_SUCCESS) {
+        fprintf(stderr, "Unable to load saved game %s\n", args.savegame);
+        return 1;
+    }
+    for (int i = 0; i < args.warmup_ticks; i++) {
+        game_tick_run();
+    }
+
+    uint64_t *tick_micros = malloc(sizeof(uint64_t) * args.ticks);
+    if (!tick_micros) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    game_profiler_set_enabled(args.profile != 0);
+    uint64_t start = system_get_microseconds();
+    uint64_t previous = start;
+    for (int i = 0; i < args.ticks; i++) {
+        game_tick_run();
+        uint64_t now = system_get_microseconds();
+        tick_micros[i] = now - previous;
+        previous = now;
+    }
+    game_profiler_set_enabled(0);
+    report(tick_micros, args.ticks, previous - start);
+    free(tick_micros);
+
+    if (args.profile && !write_profile(args.profile)) {
+        return 1;
+    }
+
+    if (args.output && !game_file_write_saved_game(args.output)) {
+        fprintf(stderr, "Unable to save game to %s\n", args.output);
+        return 1;
+    }
+    if (args.scan_rounds && !benchmark_scans(args.scan_rounds)) {
+        return 1;
+    }
+    if (args.save_rounds &&
+        !benchmark_saving(args.output ? args.output : DEFAULT_BENCHMARK_FILE, args.save_rounds)) {
+        return 1;
+    }
+    if (!game_file_io_finish_writing_saved_game()) {
+        fprintf(stderr, "Unable to write saved game to %s\n", args.output ? args.output : DEFAULT_BENCHMARK_FILE);
+        return 1;
+    }
+    // No game_exit(): it would persist the autosave overrides to the user's settings
+    return 0;
+}
@@ -0,0 +1,553 @@
+#include "platform.h"
+
+#include "core/log.h"
+#include "game/system.h"
+#include "graphics/renderer.h"
+#include "platform/platform.h"
+#include "platform/prefs.h"
+#include "sound/device.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#define MAX_WORKERS 16
+
+// The headless runner has no window, no audio device and no textures.
+// Everything the game expects from the SDL platform layer is stubbed out here.
+
+static struct {
+    int quiet;
+    struct {
+        int requested;
+        int initialized;
+        int num;
+        void (*task)(int worker_id, void *userdata);
+        void *userdata;
+#ifndef _WIN32
+        pthread_mutex_t lock;
+        pthread_cond_t start;
+        pthread_cond_t finished;
+        unsigned int generation;
+        int busy;
+#endif
+    } workers;
+    struct {
+        void (*task)(void *userdata);
+        void (*finished)(void *userdata);
+        void *userdata;
+#ifndef _WIN32
+        pthread_t thread;
+        int is_running;
+#endif
+    } background;
+} data;
+
+void platform_headless_set_quiet(int quiet)
+{
+    data.quiet = quiet;
+}
+
+void platform_headless_set_num_workers(int num_workers)
+{
+    data.workers.requested = num_workers;
+}
+
+static void log_internal(const char *type, const char *msg, const char *param_str, int param_int)
+{
+    if (param_str && param_int) {
+        fprintf(stderr, "%s: %s %s %d\n", type, msg, param_str, param_int);
+    } else if (param_str) {
+        fprintf(stderr, "%s: %s %s\n", type, msg, param_str);
+    } else if (param_int) {
+        fprintf(stderr, "%s: %s %d\n", type, msg, param_int);
+    } else {
+        fprintf(stderr, "%s: %s\n", type, msg);
+    }
+}
+
+void log_info(const char *msg, const char *param_str, int param_int)
+{
+    if (!data.quiet) {
+        log_internal("INFO", msg, param_str, param_int);
+    }
+}
+
+void log_error(const char *msg, const char *param_str, int param_int)
+{
+    log_internal("ERROR", msg, param_str, param_int);
+}
+
+void log_repeated_messages(void)
+{
+}
+
+char *platform_get_pref_path(void)
+{
+    return 0;
+}
+
+const char *pref_data_dir(void)
+{
+    return "";
+}
+
+void pref_save_data_dir(const char *data_dir)
+{
+}
+
+const char *pref_user_dir(void)
+{
+    return "";
+}
+
+void pref_save_user_dir(const char *user_dir)
+{
+}
+
+const char *system_version(void)
+{
+    return "headless";
+}
+
+uint64_t system_get_microseconds(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    if (!frequency.QuadPart) {
+        QueryPerformanceFrequency(&frequency);
+    }
+    QueryPerformanceCounter(&counter);
+    return (uint64_t) (counter.QuadPart / frequency.QuadPart) * 1000000 +
+        (uint64_t) (counter.QuadPart % frequency.QuadPart) * 1000000 / frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000 + (uint64_t) ts.tv_nsec / 1000;
+#endif
+}
+
+uint64_t system_get_ticks(void)
+{
+    return system_get_microseconds() / 1000;
+}
+
+#ifndef _WIN32
+static void *run_worker(void *arg)
+{
+    int worker_id = (int) (intptr_t) arg;
+    unsigned int generation = 0;
+    pthread_mutex_lock(&data.workers.lock);
+    while (1) {
+        while (data.workers.generation == generation) {
+            pthread_cond_wait(&data.workers.start, &data.workers.lock);
+        }
+        generation = data.workers.generation;
+        pthread_mutex_unlock(&data.workers.lock);
+        data.workers.task(worker_id, data.workers.userdata);
+        pthread_mutex_lock(&data.workers.lock);
+        if (--data.workers.busy == 0) {
+            pthread_cond_signal(&data.workers.finished);
+        }
+    }
+    return 0;
+}
+#endif
+
+static void init_workers(void)
+{
+    data.workers.initialized = 1;
+    data.workers.num = 1;
+#ifndef _WIN32
+    int num_workers = data.workers.requested;
+    if (num_workers <= 0) {
+        num_workers = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (num_workers > MAX_WORKERS) {
+        num_workers = MAX_WORKERS;
+    }
+    pthread_mutex_init(&data.workers.lock, 0);
+    pthread_cond_init(&data.workers.start, 0);
+    pthread_cond_init(&data.workers.finished, 0);
+    for (int i = 1; i < num_workers; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, 0, run_worker, (void *) (intptr_t) i) != 0) {
+            break;
+        }
+        pthread_detach(thread);
+        data.workers.num++;
+    }
+#endif
+}
+
+int system_get_num_workers(void)
+{
+    if (!data.workers.initialized) {
+        init_workers();
+    }
+    return data.workers.num;
+}
+
+void system_run_on_workers(void (*task)(int worker_id, void *userdata), void *userdata)
+{
+    if (!data.workers.initialized) {
+        init_workers();
+    }
+#ifndef _WIN32
+    if (data.workers.num > 1) {
+        pthread_mutex_lock(&data.workers.lock);
+        data.workers.task = task;
+        data.workers.userdata = userdata;
+        data.workers.busy = data.workers.num - 1;
+        data.workers.generation++;
+        pthread_cond_broadcast(&data.workers.start);
+        pthread_mutex_unlock(&data.workers.lock);
+
+        task(0, userdata);
+
+        pthread_mutex_lock(&data.workers.lock);
+        while (data.workers.busy) {
+            pthread_cond_wait(&data.workers.finished, &data.workers.lock);
+        }
+        pthread_mutex_unlock(&data.workers.lock);
+        return;
+    }
+#endif
+    task(0, userdata);
+}
+
+#ifndef _WIN32
+static void *run_background_task(void *arg)
+{
+    data.background.task(data.background.userdata);
+    return 0;
+}
+#endif
+
+static void finish_background_task(void)
+{
+    void (*finished)(void *userdata) = data.background.finished;
+    data.background.finished = 0;
+    if (finished) {
+        finished(data.background.userdata);
+    }
+}
+
+void system_run_in_background(void (*task)(void *userdata), void (*finished)(void *userdata), void *userdata)
+{
+    system_wait_for_background_task();
+    data.background.task = task;
+    data.background.finished = finished;
+    data.background.userdata = userdata;
+#ifndef _WIN32
+    if (pthread_create(&data.background.thread, 0, run_background_task, 0) == 0) {
+        data.background.is_running = 1;
+        return;
+    }
+#endif
+    task(userdata);
+    finish_background_task();
+}
+
+void system_wait_for_background_task(void)
+{
+#ifndef _WIN32
+    if (data.background.is_running) {
+        pthread_join(data.background.thread, 0);
+        data.background.is_running = 0;
+    }
+#endif
+    finish_background_task();
+}
+
+void system_resize(int width, int height)
+{
+}
+
+void system_get_max_resolution(int *width, int *height)
+{
+    *width = 0;
+    *height = 0;
+}
+
+void system_center(void)
+{
+}
+
+int system_is_fullscreen_only(void)
+{
+    return 0;
+}
+
+void system_set_fullscreen(int fullscreen)
+{
+}
+
+void system_change_window_title(const char *title)
+{
+}
+
+int system_scale_display(int scale_percentage)
+{
+    return 100;
+}
+
+int system_can_scale_display(int *min_scale, int *max_scale)
+{
+    return 0;
+}
+
+void system_init_cursors(int scale_percentage)
+{
+}
+
+void system_set_cursor(int cursor_id)
+{
+}
+
+void system_show_cursor(void)
+{
+}
+
+void system_hide_cursor(void)
+{
+}
+
+key_type system_keyboard_key_for_symbol(const char *name)
+{
+    return KEY_TYPE_NONE;
+}
+
+const char *system_keyboard_key_name(key_type key)
+{
+    return "";
+}
+
+const char *system_keyboard_key_modifier_name(key_modifier_type modifier)
+{
+    return "";
+}
+
+void system_keyboard_set_input_rect(int x, int y, int width, int height)
+{
+}
+
+void system_keyboard_show(void)
+{
+}
+
+void system_keyboard_hide(void)
+{
+}
+
+void system_start_text_input(void)
+{
+}
+
+void system_stop_text_input(void)
+{
+}
+
+void system_mouse_set_relative_mode(int enabled)
+{
+}
+
+void system_mouse_get_relative_state(int *x, int *y)
+{
+    *x = 0;
+    *y = 0;
+}
+
+void system_move_mouse_cursor(int delta_x, int delta_y)
+{
+}
+
+void system_set_mouse_position(int *x, int *y)
+{
+}
+
+int system_supports_select_folder_dialog(void)
+{
+    return 0;
+}
+
+const char *system_show_select_folder_dialog(const char *title, const char *default_path)
+{
+    return 0;
+}
+
+void system_exit(void)
+{
+}
+
+void sound_device_open(void)
+{
+}
+
+void sound_device_close(void)
+{
+}
+
+void sound_device_init_channels(void)
+{
+}
+
+int sound_device_is_file_playing_on_channel(const char *filename, sound_type type)
+{
+    return 0;
+}
+
+void sound_device_set_music_volume(int volume_pct)
+{
+}
+
+void sound_device_set_volume_for_type(sound_type type, int volume_pct)
+{
+}
+
+int sound_device_play_music(const char *filename, int volume_pct, int loop)
+{
+    return 0;
+}
+
+int sound_device_play_track(const char *filename, int volume_pct, void (*on_finish)(void))
+{
+    return 0;
+}
+
+int sound_device_play_file_on_channel_panned(const char *filename, sound_type type,
+    int volume_pct, int left_pct, int right_pct, int loop)
+{
+    return 0;
+}
+
+int sound_device_play_file_on_channel(const char *filename, sound_type type, int volume_pct)
+{
+    return 0;
+}
+
+int sound_device_pause_music(void)
+{
+    return 0;
+}
+
+int sound_device_resume_music(void)
+{
+    return 0;
+}
+
+void sound_device_stop_music(void)
+{
+}
+
+void sound_device_stop_type(sound_type type)
+{
+}
+
+void sound_device_on_audio_finished(void (*callback)(sound_type))
+{
+}
+
+void sound_device_fadeout_music(int milisseconds)
+{
+}
+
+void sound_device_use_custom_music_player(int bitdepth, int num_channels, int rate, const void *audio_data, int len)
+{
+}
+
+void sound_device_write_custom_music_data(const void *audio_data, int len)
+{
+}
+
+void sound_device_use_default_music_player(void)
+{
+}
+
+// Headless renderer: there are no textures, so atlases are never created and image loading
+// bails out early. The simulation itself does not need any pixel data.
+
+static void get_max_image_size(int *width, int *height)
+{
+    *width = 0;
+    *height = 0;
+}
+
+static const image_atlas_data *prepare_image_atlas(atlas_type type, int num_images, int last_width, int last_height)
+{
+    return 0;
+}
+
+static int create_image_atlas(const image_atlas_data *atlas_data, int delete_buffers)
+{
+    return 0;
+}
+
+static const image_atlas_data *get_image_atlas(atlas_type type)
+{
+    return 0;
+}
+
+static int has_image_atlas(atlas_type type)
+{
+    return 0;
+}
+
+static void free_image_atlas(atlas_type type)
+{
+}
+
+static void load_unpacked_image(const image *img, const color_t *pixels)
+{
+}
+
+static int has_unpacked_image(const image *img)
+{
+    return 0;
+}
+
+static void free_unpacked_image(const image *img)
+{
+}
+
+static int should_pack_image(int width, int height)
+{
+    return 0;
+}
+
+static int has_custom_image(custom_image_type type)
+{
+    return 0;
+}
+
+static void update_scale(int city_scale)
+{
+}
+
+void platform_headless_init_renderer(void)
+{
+    static graphics_renderer_interface renderer;
+    memset(&renderer, 0, sizeof(renderer));
+    renderer.get_max_image_size = get_max_image_size;
+    renderer.prepare_image_atlas = prepare_image_atlas;
+    renderer.create_image_atlas = create_image_atlas;
+    renderer.get_image_atlas = get_image_atlas;
+    renderer.has_image_atlas = has_image_atlas;
+    renderer.free_image_atlas = free_image_atlas;
+    renderer.load_unpacked_image = load_unpacked_image;
+    renderer.has_unpacked_image = has_unpacked_image;
+    renderer.free_unpacked_image = free_unpacked_image;
+    renderer.should_pack_image = should_pack_image;
+    renderer.has_custom_image = has_custom_image;
+    renderer.update_scale = update_scale;
+    graphics_renderer_set_interface(&renderer);
+}
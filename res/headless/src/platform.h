@@ -0,0 +1,10 @@
+#ifndef HEADLESS_PLATFORM_H
+#define HEADLESS_PLATFORM_H
+
+void platform_headless_set_quiet(int quiet);
+
+void platform_headless_set_num_workers(int num_workers);
+
+void platform_headless_init_renderer(void);
+
+#endif // HEADLESS_PLATFORM_H
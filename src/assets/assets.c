@@ -171,7 +171,18 @@ void assets_load_unpacked_asset(int image_id)
             asset_image_get_from_id(img->first_layer.calculated_image_id - IMAGE_MAIN_ENTRIES);
         pixels = referenced_asset->data;
     } else {
+        if (img->loads_on_demand && graphics_renderer()->has_unpacked_image(&img->img)) {
+            return;
+        }
+        asset_image_load_on_demand(img);
         pixels = img->data;
     }
+    if (!pixels) {
+        return;
+    }
     graphics_renderer()->load_unpacked_image(&img->img, pixels);
+    // Once the texture exists, the pixels are composed again only if the texture is evicted
+    if (img->loads_on_demand && graphics_renderer()->has_unpacked_image(&img->img)) {
+        asset_image_unload_on_demand(img);
+    }
 }
@@ -6,6 +6,7 @@
 #include "core/image_packer.h"
 #include "core/log.h"
 #include "core/png_read.h"
+#include "core/zlib_helper.h"
 #include "game/campaign.h"
 #include "graphics/color.h"
 #include "graphics/graphics.h"
@@ -35,7 +36,9 @@ static int load_image_layers(asset_image *img, color_t **main_images, int *main_
         if (l->mask == LAYER_MASK_ALPHA) {
             has_alpha_mask = 1;
         }
-        layer_load(l, main_images, main_image_widths);
+        if (!l->data) {
+            layer_load(l, main_images, main_image_widths);
+        }
     }
     return has_alpha_mask;
 }
@@ -199,32 +202,18 @@ static void split_top_and_footprint(const image *img, color_t *dst, const color_
     image_copy_isometric_footprint(&copy);
 }
 
-static int load_image(asset_image *img, color_t **main_images, int *main_image_widths)
+static color_t *create_image_from_layers(asset_image *img, color_t **main_images, int *main_image_widths)
 {
-    img->img.original.width = img->img.width;
-    img->img.original.height = img->img.height;
-
-    image_reference_type reference_type = get_image_reference_type(img);
-    if (reference_type == IMAGE_FULL_REFERENCE) {
-        layer *l = img->last_layer;
-        if (!l->calculated_image_id && !img->img.is_isometric) {
-            layer_load(l, main_images, main_image_widths);
-            img->data = l->data;
-            l->data = 0;
-            make_similar_images_references(img);
-            layer_unload(l);
-            return 1;
-        }
-    }
     int has_alpha_mask = load_image_layers(img, main_images, main_image_widths);
+    int width = img->img.original.width;
+    int height = img->img.original.height;
 
-    color_t *pixels = malloc(sizeof(color_t) * img->img.width * img->img.height);
+    color_t *pixels = malloc(sizeof(color_t) * width * height);
     if (!pixels) {
         log_error("Error creating image - out of memory", 0, 0);
-        unload_image_layers(img);
         return 0;
     }
-    memset(pixels, 0, sizeof(color_t) * img->img.width * img->img.height);
+    memset(pixels, 0, sizeof(color_t) * width * height);
 
     // Images with an alpha mask layer need to be loaded from first to last, which is slower
     const layer *l = has_alpha_mask ? &img->first_layer : img->last_layer;
@@ -245,11 +234,11 @@ static int load_image(asset_image *img, color_t **main_images, int *main_image_w
             image_valid_height = image_start_y + l->width - (l->y_offset < 0 ? -l->y_offset : 0);
             layer_step_x = l->width;
         }
-        if (image_valid_width > img->img.width) {
-            image_valid_width = img->img.width;
+        if (image_valid_width > width) {
+            image_valid_width = width;
         }
-        if (image_valid_height > img->img.height) {
-            image_valid_height = img->img.height;
+        if (image_valid_height > height) {
+            image_valid_height = height;
         }
 
         // The above code is innacurate when a layer is rotated either by 90 or 270 degrees and inverted.
@@ -268,7 +257,7 @@ static int load_image(asset_image *img, color_t **main_images, int *main_image_w
         }
 
         for (int y = image_start_y; y < image_valid_height; y++) {
-            color_t *pixel = &pixels[y * img->img.width + image_start_x];
+            color_t *pixel = &pixels[y * width + image_start_x];
             const color_t *layer_pixel = 0;
             if (!inverts_and_rotates) {
                 layer_pixel = layer_get_color_for_image_position(l, image_start_x, y);
@@ -320,37 +309,89 @@ static int load_image(asset_image *img, color_t **main_images, int *main_image_w
         }
         l = has_alpha_mask ? l->next : l->prev;
     }
+    return pixels;
+}
+
+static int create_isometric_top(image *img)
+{
+    int tiles = (img->width + 2) / (FOOTPRINT_WIDTH + 2);
+    int footprint_height = tiles * FOOTPRINT_HEIGHT;
+    img->top = malloc(sizeof(image));
+    if (!img->top) {
+        log_error("Error creating image - out of memory", 0, 0);
+        return 0;
+    }
+    memset(img->top, 0, sizeof(image));
+    img->top->width = img->width;
+    img->top->height = img->height - footprint_height / 2;
+    img->top->original.width = img->top->width;
+    img->top->original.height = img->top->height;
+    img->atlas.y_offset = img->top->height;
+    img->height = footprint_height;
+    return 1;
+}
+
+// Takes the composed pixels of an isometric image and returns them with the top moved above the footprint
+static color_t *split_isometric_pixels(const image *img, color_t *pixels)
+{
+    image original = *img;
+    original.height = img->original.height;
+    size_t size = sizeof(color_t) * (original.height + img->top->height) * img->width;
+    color_t *new_data = malloc(size);
+    if (!new_data) {
+        log_error("Error creating image - out of memory", 0, 0);
+        free(pixels);
+        return 0;
+    }
+    memset(new_data, 0, size);
+    split_top_and_footprint(&original, new_data, pixels, original.height);
+    free(pixels);
+    return new_data;
+}
+
+static void unload_image_layer_files(asset_image *img)
+{
+    for (layer *l = img->last_layer; l; l = l->prev) {
+        layer_unload_file_data(l);
+    }
+}
+
+static int load_image(asset_image *img, color_t **main_images, int *main_image_widths)
+{
+    img->img.original.width = img->img.width;
+    img->img.original.height = img->img.height;
+
+    image_reference_type reference_type = get_image_reference_type(img);
+    if (reference_type == IMAGE_FULL_REFERENCE) {
+        layer *l = img->last_layer;
+        if (!l->calculated_image_id && !img->img.is_isometric) {
+            layer_load(l, main_images, main_image_widths);
+            img->data = l->data;
+            l->data = 0;
+            make_similar_images_references(img);
+            layer_unload(l);
+            return 1;
+        }
+    }
+    color_t *pixels = create_image_from_layers(img, main_images, main_image_widths);
+    if (!pixels) {
+        unload_image_layers(img);
+        return 0;
+    }
 
     // The top and footprint parts of the image need to be split
     if (img->img.is_isometric) {
-        int tiles = (img->img.width + 2) / (FOOTPRINT_WIDTH + 2);
-        int footprint_height = tiles * FOOTPRINT_HEIGHT;
-
         if (has_top_part(&img->img, pixels)) {
-            img->img.top = malloc(sizeof(image));
-            if (!img->img.top) {
-                log_error("Error creating image - out of memory", 0, 0);
+            if (!create_isometric_top(&img->img)) {
+                free(pixels);
                 unload_image_layers(img);
                 return 0;
             }
-            memset(img->img.top, 0, sizeof(image));
-            img->img.top->width = img->img.width;
-            img->img.top->height = img->img.height - footprint_height / 2;
-            img->img.top->original.width = img->img.top->width;
-            img->img.top->original.height = img->img.top->height;
-            img->img.atlas.y_offset = img->img.top->height;
-            color_t *new_data = malloc(sizeof(color_t) * (img->img.height + img->img.top->height) * img->img.width);
-            if (!new_data) {
-                log_error("Error creating image - out of memory", 0, 0);
+            pixels = split_isometric_pixels(&img->img, pixels);
+            if (!pixels) {
                 unload_image_layers(img);
                 return 0;
             }
-            memset(new_data, 0, sizeof(color_t) * (footprint_height + img->img.top->height) *img->img.width);
-            split_top_and_footprint(&img->img, new_data, pixels, img->img.height);
-
-            img->img.height = footprint_height;
-            free(pixels);
-            pixels = new_data;
         }
         if (reference_type == IMAGE_FULL_REFERENCE) {
             make_similar_images_references(img);
@@ -363,6 +404,90 @@ static int load_image(asset_image *img, color_t **main_images, int *main_image_w
 
     return 1;
 }
+
+// Images too big for the atlas are kept in their own textures, so their pixels are only needed once they are drawn
+static int can_load_on_demand(const asset_image *img)
+{
+    if (img->is_layer_source ||
+        graphics_renderer()->should_pack_image(img->img.width, img->img.height)) {
+        return 0;
+    }
+    for (const layer *l = &img->first_layer; l; l = l->next) {
+        if (l->calculated_image_id >= IMAGE_MAIN_ENTRIES) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+#ifdef CHECK_ON_DEMAND_ASSETS
+static unsigned int get_composed_crc(const asset_image *img, const color_t *pixels)
+{
+    return zlib_helper_crc32(0, pixels, (int) sizeof(color_t) * img->img.original.width * img->img.original.height);
+}
+#endif
+
+static int prepare_to_load_on_demand(asset_image *img, color_t **main_images, int *main_image_widths)
+{
+    img->img.original.width = img->img.width;
+    img->img.original.height = img->img.height;
+
+    // The pixels of the original images are only available now, so those layers are loaded right away
+    for (layer *l = img->last_layer; l; l = l->prev) {
+        if (l->calculated_image_id) {
+            layer_load(l, main_images, main_image_widths);
+        }
+    }
+#ifdef CHECK_ON_DEMAND_ASSETS
+    // Compose every image once, so each later composition can be compared with this one
+    color_t *pixels = create_image_from_layers(img, main_images, main_image_widths);
+    unload_image_layer_files(img);
+    if (!pixels) {
+        return 0;
+    }
+    img->composed_crc = get_composed_crc(img, pixels);
+    if (img->img.is_isometric) {
+        int has_top = has_top_part(&img->img, pixels);
+        free(pixels);
+        if (has_top && !create_isometric_top(&img->img)) {
+            return 0;
+        }
+    } else {
+        free(pixels);
+    }
+#else
+    // Whether an isometric image has a top depends on its pixels, so it is composed once to find out
+    if (img->img.is_isometric) {
+        color_t *pixels = create_image_from_layers(img, main_images, main_image_widths);
+        unload_image_layer_files(img);
+        if (!pixels) {
+            return 0;
+        }
+        int has_top = has_top_part(&img->img, pixels);
+        free(pixels);
+        if (has_top && !create_isometric_top(&img->img)) {
+            return 0;
+        }
+    }
+#endif
+    img->loads_on_demand = 1;
+    return 1;
+}
+
+static void mark_layer_sources(void)
+{
+    asset_image *current_image;
+    array_foreach(data.asset_images, current_image) {
+        for (const layer *l = &current_image->first_layer; l; l = l->next) {
+            if (l->calculated_image_id >= IMAGE_MAIN_ENTRIES) {
+                asset_image *source = asset_image_get_from_id(l->calculated_image_id - IMAGE_MAIN_ENTRIES);
+                if (source) {
+                    source->is_layer_source = 1;
+                }
+            }
+        }
+    }
+}
 #endif
 
 static inline int layer_is_empty(const layer *l)
@@ -462,6 +587,8 @@ void asset_image_unload(asset_image *img)
     img->id = 0;
     img->data = 0;
     img->active = 0;
+    img->is_layer_source = 0;
+    img->loads_on_demand = 0;
     memset(&img->img, 0, sizeof(image));
 }
 
@@ -508,13 +635,18 @@ int asset_image_load_all(color_t **main_images, int *main_image_widths)
     packer.options.reduce_image_size = 1;
     packer.options.sort_by = IMAGE_PACKER_SORT_BY_AREA;
 
+    mark_layer_sources();
+
     asset_image *current_image;
     int rect = 0;
     array_foreach(data.asset_images, current_image) {
         if (current_image->is_reference) {
             continue;
         }
-        load_image(current_image, main_images, main_image_widths);
+        if (!can_load_on_demand(current_image) ||
+            !prepare_to_load_on_demand(current_image, main_images, main_image_widths)) {
+            load_image(current_image, main_images, main_image_widths);
+        }
         int top_height = current_image->img.top ? current_image->img.top->height : 0;
 
         if (graphics_renderer()->should_pack_image(current_image->img.width, current_image->img.height + top_height)) {
@@ -640,6 +772,37 @@ int asset_image_load_all(color_t **main_images, int *main_image_widths)
     return 1;
 }
 
+void asset_image_load_on_demand(asset_image *img)
+{
+#ifndef BUILDING_ASSET_PACKER
+    if (!img->loads_on_demand || img->data) {
+        return;
+    }
+    // The layers stay, so the image can be composed again after its pixels were unloaded
+    color_t *pixels = create_image_from_layers(img, 0, 0);
+    unload_image_layer_files(img);
+    png_unload();
+#ifdef CHECK_ON_DEMAND_ASSETS
+    if (pixels && get_composed_crc(img, pixels) != img->composed_crc) {
+        log_error("On-demand asset image differs from its first composition:", img->id, 0);
+    }
+#endif
+    if (pixels && img->img.top) {
+        pixels = split_isometric_pixels(&img->img, pixels);
+    }
+    img->data = pixels;
+#endif
+}
+
+void asset_image_unload_on_demand(asset_image *img)
+{
+    if (!img->loads_on_demand) {
+        return;
+    }
+    free((color_t *) img->data); // Freeing a const pointer - ugly but necessary
+    img->data = 0;
+}
+
 void asset_image_reload_climate(void)
 {
 #ifndef BUILDING_ASSET_PACKER
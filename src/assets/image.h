@@ -13,6 +13,11 @@ typedef struct {
     image img;
     const color_t *data;
     int is_reference;
+    int is_layer_source;
+    int loads_on_demand;
+#ifdef CHECK_ON_DEMAND_ASSETS
+    unsigned int composed_crc;
+#endif
 #ifdef BUILDING_ASSET_PACKER
     int has_frame_elements;
     int has_defined_size;
@@ -32,6 +37,8 @@ asset_image *asset_image_get_from_id(int image_id);
 int asset_image_init_array(void);
 asset_image *asset_image_create(void);
 int asset_image_load_all(color_t **main_images, int *main_image_widths);
+void asset_image_load_on_demand(asset_image *img);
+void asset_image_unload_on_demand(asset_image *img);
 void asset_image_reload_climate(void);
 void asset_image_count_isometric(void);
 
@@ -268,6 +268,16 @@ void layer_unload(layer *l)
     }
 }
 
+void layer_unload_file_data(layer *l)
+{
+    // A layer that failed to load no longer knows its size, so it stays a dummy, as it would at startup
+    if (!l->asset_image_path || !l->data || l->data == &DUMMY_LAYER_DATA) {
+        return;
+    }
+    free((color_t *) l->data); // Freeing a const pointer. Ugly but necessary
+    l->data = 0;
+}
+
 const color_t *layer_get_color_for_image_position(const layer *l, int x, int y)
 {
     x -= l->x_offset;
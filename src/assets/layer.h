@@ -57,6 +57,7 @@ typedef struct layer {
 
 void layer_load(layer *l, color_t **main_data, int *main_image_widths);
 void layer_unload(layer *l);
+void layer_unload_file_data(layer *l);
 
 const color_t *layer_get_color_for_image_position(const layer *l, int x, int y);
 
@@ -43,6 +43,7 @@ static struct {
     array(building) buildings;
     building *first_of_type[BUILDING_TYPE_MAX];
     building *last_of_type[BUILDING_TYPE_MAX];
+    unsigned int type_versions[BUILDING_TYPE_MAX];
 } data;
 
 static struct {
@@ -51,6 +52,22 @@ static struct {
     int unfixable_houses;
 } extra;
 
+// Copies of the fields that the per-tick scans check for every building, stored as separate arrays
+// indexed by building ID so that skipping the buildings a scan does not care about stays in cache.
+static struct {
+    building_hot_fields fields;
+    unsigned int capacity;
+} hot;
+
+// One bit per building ID for the buildings that building_update_state has to look at. A building is
+// marked when its fields are updated while it is not a house in use, which covers every state change
+// the pass acts on. Houses in use are most of the buildings and need nothing.
+static struct {
+    uint32_t *bits;
+    unsigned int words;
+    int is_valid;
+} pending;
+
 building *building_get(int id)
 {
     return array_item(data.buildings, id);
@@ -99,6 +116,168 @@ building *building_first_of_type(building_type type)
     return data.first_of_type[type];
 }
 
+unsigned int building_type_version(building_type type)
+{
+    return data.type_versions[type];
+}
+
+static int grow_hot_field(void **field, size_t item_size, unsigned int capacity)
+{
+    uint8_t *grown = realloc(*field, item_size * capacity);
+    if (!grown) {
+        return 0;
+    }
+    memset(grown + item_size * hot.capacity, 0, item_size * (capacity - hot.capacity));
+    *field = grown;
+    return 1;
+}
+
+static int ensure_hot_capacity(unsigned int size)
+{
+    if (size <= hot.capacity) {
+        return 1;
+    }
+    unsigned int capacity = hot.capacity ? hot.capacity : BUILDING_ARRAY_SIZE_STEP;
+    while (capacity < size) {
+        capacity *= 2;
+    }
+    if (!grow_hot_field((void **) &hot.fields.state, sizeof(*hot.fields.state), capacity) ||
+        !grow_hot_field((void **) &hot.fields.house_size, sizeof(*hot.fields.house_size), capacity) ||
+        !grow_hot_field((void **) &hot.fields.x, sizeof(*hot.fields.x), capacity) ||
+        !grow_hot_field((void **) &hot.fields.y, sizeof(*hot.fields.y), capacity) ||
+        !grow_hot_field((void **) &hot.fields.grid_offset, sizeof(*hot.fields.grid_offset), capacity) ||
+        !grow_hot_field((void **) &hot.fields.type, sizeof(*hot.fields.type), capacity) ||
+        !grow_hot_field((void **) &hot.fields.road_network_id, sizeof(*hot.fields.road_network_id), capacity)) {
+        log_error("Unable to allocate enough memory for the building fields. The game will now crash.", 0, 0);
+        return 0;
+    }
+    hot.capacity = capacity;
+    return 1;
+}
+
+static void clear_hot_fields(void)
+{
+    if (!hot.capacity) {
+        return;
+    }
+    memset(hot.fields.state, 0, sizeof(*hot.fields.state) * hot.capacity);
+    memset(hot.fields.house_size, 0, sizeof(*hot.fields.house_size) * hot.capacity);
+    memset(hot.fields.x, 0, sizeof(*hot.fields.x) * hot.capacity);
+    memset(hot.fields.y, 0, sizeof(*hot.fields.y) * hot.capacity);
+    memset(hot.fields.grid_offset, 0, sizeof(*hot.fields.grid_offset) * hot.capacity);
+    memset(hot.fields.type, 0, sizeof(*hot.fields.type) * hot.capacity);
+    memset(hot.fields.road_network_id, 0, sizeof(*hot.fields.road_network_id) * hot.capacity);
+}
+
+static void mark_pending(unsigned int id)
+{
+    unsigned int word = id / 32;
+    if (word >= pending.words) {
+        unsigned int words = pending.words ? pending.words : BUILDING_ARRAY_SIZE_STEP / 32;
+        while (words <= word) {
+            words *= 2;
+        }
+        uint32_t *bits = realloc(pending.bits, words * sizeof(uint32_t));
+        if (!bits) {
+            // the next update falls back to looking at every building
+            pending.is_valid = 0;
+            return;
+        }
+        memset(bits + pending.words, 0, (words - pending.words) * sizeof(uint32_t));
+        pending.bits = bits;
+        pending.words = words;
+    }
+    pending.bits[word] |= 1u << (id % 32);
+}
+
+static unsigned int next_pending(unsigned int start, unsigned int size)
+{
+    unsigned int word = start / 32;
+    if (word >= pending.words) {
+        return size;
+    }
+    uint32_t bits = pending.bits[word] & (~0u << (start % 32));
+    while (!bits) {
+        if (++word >= pending.words || word * 32 >= size) {
+            return size;
+        }
+        bits = pending.bits[word];
+    }
+    unsigned int id = word * 32;
+    while (!(bits & 1)) {
+        bits >>= 1;
+        id++;
+    }
+    return id < size ? id : size;
+}
+
+static void clear_pending(unsigned int id)
+{
+    pending.bits[id / 32] &= ~(1u << (id % 32));
+}
+
+static void mark_all_pending(void)
+{
+    pending.is_valid = 1;
+    for (unsigned int id = 0; id < data.buildings.size && pending.is_valid; id++) {
+        mark_pending(id);
+    }
+}
+
+void building_update_hot_fields(const building *b)
+{
+    if (!ensure_hot_capacity(b->id + 1)) {
+        return;
+    }
+    hot.fields.state[b->id] = b->state;
+    hot.fields.house_size[b->id] = b->house_size;
+    hot.fields.x[b->id] = b->x;
+    hot.fields.y[b->id] = b->y;
+    hot.fields.grid_offset[b->id] = b->grid_offset;
+    hot.fields.type[b->id] = b->type;
+    hot.fields.road_network_id[b->id] = b->road_network_id;
+    if (b->state != BUILDING_STATE_IN_USE || !b->house_size) {
+        mark_pending(b->id);
+    }
+}
+
+const building_hot_fields *building_get_hot_fields(void)
+{
+    return &hot.fields;
+}
+
+#ifdef CHECK_BUILDING_HOT_FIELDS
+static void check_hot_fields(void)
+{
+    int mismatches = 0;
+    building *b;
+    array_foreach(data.buildings, b)
+    {
+        if (hot.fields.state[array_index] != b->state || hot.fields.house_size[array_index] != b->house_size ||
+            hot.fields.x[array_index] != b->x || hot.fields.y[array_index] != b->y ||
+            hot.fields.grid_offset[array_index] != b->grid_offset || hot.fields.type[array_index] != b->type ||
+            hot.fields.road_network_id[array_index] != b->road_network_id) {
+            if (!mismatches) {
+                log_error("Building fields out of sync for building", 0, array_index);
+            }
+            mismatches++;
+        }
+    }
+    if (mismatches) {
+        log_error("Number of buildings with out of sync fields:", 0, mismatches);
+    }
+}
+#endif
+
+static void clear_type_lists(void)
+{
+    memset(data.first_of_type, 0, sizeof(data.first_of_type));
+    memset(data.last_of_type, 0, sizeof(data.last_of_type));
+    for (int i = 0; i < BUILDING_TYPE_MAX; i++) {
+        data.type_versions[i]++;
+    }
+}
+
 building *building_main(building *b)
 {
     for (int guard = 0; guard < 9; guard++) {
@@ -117,6 +296,7 @@ building *building_next(building *b)
 
 static void fill_adjacent_types(building *b)
 {
+    data.type_versions[b->type]++;
     building *first = data.first_of_type[b->type];
     building *last = data.last_of_type[b->type];
     if (!first || !last) {
@@ -153,6 +333,7 @@ static void fill_adjacent_types(building *b)
 
 static void remove_adjacent_types(building *b)
 {
+    data.type_versions[b->type]++;
     building *first = data.first_of_type[b->type];
     building *last = data.last_of_type[b->type];
     if (b == first && b == last) {
@@ -176,6 +357,17 @@ static void remove_adjacent_types(building *b)
     b->next_of_type = 0;
 }
 
+static void mark_routing_tiles_changed(const building *b)
+{
+    // the routing terrain of a building's tiles depends on its type
+    int size = b->size > 0 ? b->size : 1;
+    for (int dy = 0; dy < size; dy++) {
+        for (int dx = 0; dx < size; dx++) {
+            map_routing_tile_changed(map_grid_offset(b->x + dx, b->y + dy), ROUTING_CHANGE_LAND);
+        }
+    }
+}
+
 building *building_create(building_type type, int x, int y)
 {
     building *b;
@@ -255,6 +447,8 @@ building *building_create(building_type type, int x, int y)
     b->figure_roam_direction = b->house_figure_generation_delay & 6;
     b->fire_proof = props->fire_proof;
     b->is_close_to_water = building_is_close_to_water(b);
+    building_update_hot_fields(b);
+    mark_routing_tiles_changed(b);
 
     return b;
 }
@@ -267,15 +461,20 @@ void building_change_type(building *b, building_type type)
     remove_adjacent_types(b);
     b->type = type;
     fill_adjacent_types(b);
+    building_update_hot_fields(b);
+    mark_routing_tiles_changed(b);
 }
 
 static void building_delete(building *b)
 {
     building_clear_related_data(b);
     remove_adjacent_types(b);
+    mark_routing_tiles_changed(b);
     int id = b->id;
     memset(b, 0, sizeof(building));
     b->id = id;
+    building_update_hot_fields(b);
+    array_mark_item_free(data.buildings, id);
 
     array_trim(data.buildings);
 }
@@ -301,11 +500,14 @@ void building_clear_related_data(building *b)
 building *building_restore_from_undo(building *to_restore)
 {
     building *b = array_item(data.buildings, to_restore->id);
+    mark_routing_tiles_changed(b);
     memcpy(b, to_restore, sizeof(building));
+    mark_routing_tiles_changed(b);
     if (b->id >= data.buildings.size) {
         data.buildings.size = b->id + 1;
     }
     fill_adjacent_types(b);
+    building_update_hot_fields(b);
     return b;
 }
 
@@ -320,11 +522,25 @@ void building_update_state(void)
     int wall_recalc = 0;
     int road_recalc = 0;
     int aqueduct_recalc = 0;
-    building *b;
-    array_foreach(data.buildings, b)
-    {
+#ifdef CHECK_BUILDING_HOT_FIELDS
+    check_hot_fields();
+#endif
+    if (!ensure_hot_capacity(data.buildings.size)) {
+        return;
+    }
+    if (!pending.is_valid) {
+        mark_all_pending();
+    }
+    for (unsigned int id = next_pending(0, data.buildings.size); id < data.buildings.size;
+        id = next_pending(id + 1, data.buildings.size)) {
+        clear_pending(id);
+        if (hot.fields.state[id] == BUILDING_STATE_IN_USE && hot.fields.house_size[id]) {
+            continue;
+        }
+        building *b = array_item(data.buildings, id);
         if (b->state == BUILDING_STATE_CREATED) {
             b->state = BUILDING_STATE_IN_USE;
+            building_update_hot_fields(b);
         }
         if (b->state == BUILDING_STATE_IN_USE && b->house_size) {
             continue;
@@ -359,10 +575,16 @@ void building_update_state(void)
             building_delete(b);
         } else if (b->immigrant_figure_id) {
             const figure *f = figure_get(b->immigrant_figure_id);
-            if (f->state != FIGURE_STATE_ALIVE || f->destination_building_id != array_index) {
+            if (f->state != FIGURE_STATE_ALIVE || f->destination_building_id != id) {
                 b->immigrant_figure_id = 0;
             }
         }
+        // buildings that hold on to an immigrant are checked again on the next update
+        if (b->state != BUILDING_STATE_UNUSED && b->immigrant_figure_id) {
+            mark_pending(id);
+        } else {
+            clear_pending(id);
+        }
     }
     if (wall_recalc) {
         map_tiles_update_all_walls();
@@ -381,12 +603,14 @@ void building_update_state(void)
 
 void building_update_desirability(void)
 {
-    building *b;
-    array_foreach(data.buildings, b)
-    {
-        if (b->state != BUILDING_STATE_IN_USE) {
+    if (!ensure_hot_capacity(data.buildings.size)) {
+        return;
+    }
+    for (unsigned int id = 0; id < data.buildings.size; id++) {
+        if (hot.fields.state[id] != BUILDING_STATE_IN_USE) {
             continue;
         }
+        building *b = array_item(data.buildings, id);
 
         // Use wider type to prevent 8-bit overflow
         int desirability = map_desirability_get_max(b->x, b->y, b->size);
@@ -516,6 +740,7 @@ int building_mothball_toggle(building *b)
     } else if (b->state == BUILDING_STATE_MOTHBALLED) {
         b->state = BUILDING_STATE_IN_USE;
     }
+    building_update_hot_fields(b);
     return b->state;
 }
 
@@ -529,8 +754,8 @@ int building_mothball_set(building *b, int mothball)
     } else if (b->state == BUILDING_STATE_MOTHBALLED) {
         b->state = BUILDING_STATE_IN_USE;
     }
+    building_update_hot_fields(b);
     return b->state;
-
 }
 
 unsigned char building_stockpiling_toggle(building *b)
@@ -614,13 +839,17 @@ static int building_in_use(const building *b)
 
 void building_clear_all(void)
 {
-    memset(data.first_of_type, 0, sizeof(data.first_of_type));
-    memset(data.last_of_type, 0, sizeof(data.last_of_type));
+    clear_type_lists();
+    clear_hot_fields();
+    pending.is_valid = 0;
+    map_routing_all_tiles_changed(ROUTING_CHANGE_LAND);
 
     if (!array_init(data.buildings, BUILDING_ARRAY_SIZE_STEP, initialize_new_building, building_in_use) ||
         !array_next(data.buildings)) { // Ignore first building
         log_error("Unable to allocate enough memory for the building array. The game will now crash.", 0, 0);
     }
+    array_track_free_slots(data.buildings);
+    building_update_hot_fields(array_first(data.buildings));
 
     extra.created_sequence = 0;
     extra.incorrect_houses = 0;
@@ -679,8 +908,10 @@ void building_load_state(buffer *buf, buffer *sequence, buffer *corrupt_houses,
         log_error("Unable to allocate enough memory for the building array. The game will now crash.", 0, 0);
     }
 
-    memset(data.first_of_type, 0, sizeof(data.first_of_type));
-    memset(data.last_of_type, 0, sizeof(data.last_of_type));
+    clear_type_lists();
+    clear_hot_fields();
+    pending.is_valid = 0;
+    map_routing_all_tiles_changed(ROUTING_CHANGE_LAND);
 
     int highest_id_in_use = 0;
 
@@ -699,7 +930,12 @@ void building_load_state(buffer *buf, buffer *sequence, buffer *corrupt_houses,
         b->type = BUILDING_NONE;
     }
 
+    for (int i = 0; i < buildings_to_load; i++) {
+        building_update_hot_fields(array_item(data.buildings, i));
+    }
+
     data.buildings.size = highest_id_in_use + 1;
+    array_track_free_slots(data.buildings);
 
     extra.created_sequence = buffer_read_i32(sequence);
 
@@ -202,6 +202,18 @@ typedef struct building {
     unsigned char accepted_goods[RESOURCE_MAX];
 } building;
 
+// Copies of often scanned building fields, indexed by building ID.
+// Code that changes one of these fields must call building_update_hot_fields afterwards.
+typedef struct {
+    unsigned char *state;
+    unsigned char *house_size;
+    unsigned char *x;
+    unsigned char *y;
+    short *grid_offset;
+    unsigned short *type;
+    unsigned char *road_network_id;
+} building_hot_fields;
+
 building *building_get(int id);
 
 int building_dist(int x, int y, int w, int h, building *b);
@@ -215,8 +227,14 @@ int building_find(building_type type);
 
 building *building_first_of_type(building_type type);
 
+unsigned int building_type_version(building_type type);
+
 void building_change_type(building *b, building_type type);
 
+void building_update_hot_fields(const building *b);
+
+const building_hot_fields *building_get_hot_fields(void);
+
 building *building_main(building *b);
 
 building *building_next(building *b);
@@ -125,6 +125,7 @@ static void add_warehouse(building *b)
     b->x = b->x + x_offset[corner];
     b->y = b->y + y_offset[corner];
     b->grid_offset = map_grid_offset(b->x, b->y);
+    building_update_hot_fields(b);
     game_undo_adjust_building(b);
 
     building_get(prev)->next_part_building_id = 0;
@@ -127,6 +127,7 @@ static int clear_land_confirmed(int measure_only, int x_start, int y_start, int
                     game_undo_add_building(b);
                 }
                 b->state = BUILDING_STATE_DELETED_BY_PLAYER;
+                building_update_hot_fields(b);
                 b->is_deleted = 1;
                 building *space = b;
                 for (int i = 0; i < 9; i++) {
@@ -136,6 +137,7 @@ static int clear_land_confirmed(int measure_only, int x_start, int y_start, int
                     space = building_get(space->prev_part_building_id);
                     game_undo_add_building(space);
                     space->state = BUILDING_STATE_DELETED_BY_PLAYER;
+                    building_update_hot_fields(space);
                 }
                 space = b;
                 for (int i = 0; i < 9; i++) {
@@ -145,6 +147,7 @@ static int clear_land_confirmed(int measure_only, int x_start, int y_start, int
                     }
                     game_undo_add_building(space);
                     space->state = BUILDING_STATE_DELETED_BY_PLAYER;
+                    building_update_hot_fields(space);
                 }
             } else if (map_terrain_is(grid_offset, TERRAIN_AQUEDUCT)) {
                 map_terrain_remove(grid_offset, TERRAIN_CLEARABLE & ~TERRAIN_HIGHWAY);
@@ -39,6 +39,7 @@ static void destroy_without_rubble(building *b)
 
     map_building_tiles_remove(b->id, b->x, b->y);
     b->state = BUILDING_STATE_DELETED_BY_GAME;
+    building_update_hot_fields(b);
 }
 
 
@@ -75,6 +76,7 @@ static void destroy_on_fire(building *b, int plagued)
     map_building_tiles_remove(b->id, b->x, b->y);
     if (map_terrain_is(b->grid_offset, TERRAIN_WATER)) {
         b->state = BUILDING_STATE_DELETED_BY_GAME;
+        building_update_hot_fields(b);
     } else {
         building_change_type(b, BUILDING_BURNING_RUIN);
         b->figure_id4 = 0;
@@ -131,6 +133,7 @@ static void destroy_linked_parts(building *b, int destruction_method, int plague
             default:
                 map_building_tiles_set_rubble(part_id, part->x, part->y, part->size);
                 part->state = BUILDING_STATE_RUBBLE;
+                building_update_hot_fields(part);
                 break;
         }
     }
@@ -152,6 +155,7 @@ static void destroy_linked_parts(building *b, int destruction_method, int plague
             default:
                 map_building_tiles_set_rubble(part_id, part->x, part->y, part->size);
                 part->state = BUILDING_STATE_RUBBLE;
+                building_update_hot_fields(part);
         }
     }
 
@@ -168,6 +172,7 @@ static void destroy_linked_parts(building *b, int destruction_method, int plague
 void building_destroy_by_collapse(building *b)
 {
     b->state = BUILDING_STATE_RUBBLE;
+    building_update_hot_fields(b);
     map_building_tiles_set_rubble(b->id, b->x, b->y, b->size);
     figure_create_explosion_cloud(b->x, b->y, b->size);
     destroy_linked_parts(b, DESTROY_COLLAPSE, 0);
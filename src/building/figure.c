@@ -41,9 +41,14 @@
 
 #define BEGGAR_UNEMPLOYMENT_THRESHOLD 6
 
+typedef void (*figure_spawner)(building *b);
+
 static struct {
     int beggar_counter;
     int houses_needed_per_beggar;
+    int patrician_generated;
+    int spawners_initialized;
+    figure_spawner spawners[BUILDING_TYPE_MAX];
 } data;
 
 static int worker_percentage(const building *b)
@@ -1970,9 +1975,107 @@ static void update_native_crop_progress(building *b)
     map_image_set(b->grid_offset, image_group(GROUP_BUILDING_FARM_CROPS) + b->data.industry.progress);
 }
 
+static void spawn_figure_patrician(building *b)
+{
+    data.patrician_generated = spawn_patrician(b, data.patrician_generated);
+}
+
+static void spawn_figure_finished_temple(building *b)
+{
+    if (b->monument.phase <= 0) {
+        spawn_figure_temple(b);
+    }
+}
+
+static void spawn_figure_fort(building *b)
+{
+    formation_legion_update_recruit_status(b);
+    spawn_figure_fort_supplier(b);
+}
+
+static void init_spawners(void)
+{
+    data.spawners[BUILDING_WAREHOUSE] = spawn_figure_warehouse;
+    data.spawners[BUILDING_GRANARY] = spawn_figure_granary;
+    data.spawners[BUILDING_TOWER] = spawn_figure_tower;
+    data.spawners[BUILDING_ENGINEERS_POST] = spawn_figure_engineers_post;
+    data.spawners[BUILDING_PREFECTURE] = spawn_figure_prefecture;
+    data.spawners[BUILDING_ACTOR_COLONY] = spawn_figure_actor_colony;
+    data.spawners[BUILDING_GLADIATOR_SCHOOL] = spawn_figure_gladiator_school;
+    data.spawners[BUILDING_LION_HOUSE] = spawn_figure_lion_house;
+    data.spawners[BUILDING_CHARIOT_MAKER] = spawn_figure_chariot_maker;
+    data.spawners[BUILDING_AMPHITHEATER] = spawn_figure_amphitheater;
+    data.spawners[BUILDING_THEATER] = spawn_figure_theater;
+    data.spawners[BUILDING_HIPPODROME] = spawn_figure_hippodrome;
+    data.spawners[BUILDING_COLOSSEUM] = spawn_figure_colosseum;
+    data.spawners[BUILDING_ARENA] = spawn_figure_colosseum;
+    data.spawners[BUILDING_MARKET] = spawn_figure_market;
+    data.spawners[BUILDING_BATHHOUSE] = spawn_figure_bathhouse;
+    data.spawners[BUILDING_SCHOOL] = spawn_figure_school;
+    data.spawners[BUILDING_LIBRARY] = spawn_figure_library;
+    data.spawners[BUILDING_ACADEMY] = spawn_figure_academy;
+    data.spawners[BUILDING_BARBER] = spawn_figure_barber;
+    data.spawners[BUILDING_DOCTOR] = spawn_figure_doctor;
+    data.spawners[BUILDING_HOSPITAL] = spawn_figure_hospital;
+    data.spawners[BUILDING_MISSION_POST] = spawn_figure_mission_post;
+    data.spawners[BUILDING_DOCK] = spawn_figure_dock;
+    data.spawners[BUILDING_WHARF] = spawn_figure_wharf;
+    data.spawners[BUILDING_SHIPYARD] = spawn_figure_shipyard;
+    data.spawners[BUILDING_NATIVE_HUT] = spawn_figure_native_hut;
+    data.spawners[BUILDING_NATIVE_HUT_ALT] = spawn_figure_native_hut;
+    data.spawners[BUILDING_NATIVE_MEETING] = spawn_figure_native_meeting;
+    data.spawners[BUILDING_NATIVE_CROPS] = update_native_crop_progress;
+    data.spawners[BUILDING_FORT_LEGIONARIES] = spawn_figure_fort;
+    data.spawners[BUILDING_FORT_JAVELIN] = spawn_figure_fort;
+    data.spawners[BUILDING_FORT_ARCHERS] = spawn_figure_fort;
+    data.spawners[BUILDING_FORT_AUXILIA_INFANTRY] = spawn_figure_fort;
+    data.spawners[BUILDING_FORT_MOUNTED] = spawn_figure_fort;
+    data.spawners[BUILDING_BARRACKS] = spawn_figure_barracks;
+    data.spawners[BUILDING_MILITARY_ACADEMY] = spawn_figure_military_academy;
+    data.spawners[BUILDING_WORKCAMP] = spawn_figure_work_camp;
+    data.spawners[BUILDING_ARCHITECT_GUILD] = spawn_figure_architect_guild;
+    data.spawners[BUILDING_MESS_HALL] = spawn_figure_mess_hall;
+    data.spawners[BUILDING_GRAND_TEMPLE_MARS] = spawn_figure_grand_temple_mars;
+    data.spawners[BUILDING_GRAND_TEMPLE_CERES] = spawn_figure_temple;
+    data.spawners[BUILDING_GRAND_TEMPLE_NEPTUNE] = spawn_figure_temple;
+    data.spawners[BUILDING_GRAND_TEMPLE_MERCURY] = spawn_figure_temple;
+    data.spawners[BUILDING_GRAND_TEMPLE_VENUS] = spawn_figure_temple;
+    data.spawners[BUILDING_PANTHEON] = spawn_figure_temple;
+    data.spawners[BUILDING_LIGHTHOUSE] = spawn_figure_lighthouse;
+    data.spawners[BUILDING_TAVERN] = spawn_figure_tavern;
+    data.spawners[BUILDING_WATCHTOWER] = spawn_figure_watchtower;
+    data.spawners[BUILDING_CARAVANSERAI] = spawn_figure_caravanserai;
+    data.spawners[BUILDING_DEPOT] = spawn_figure_depot;
+    data.spawners[BUILDING_ARMOURY] = spawn_figure_armoury;
+    for (building_type type = BUILDING_SMALL_TEMPLE_CERES; type <= BUILDING_LARGE_TEMPLE_VENUS; type++) {
+        data.spawners[type] = spawn_figure_finished_temple;
+    }
+    for (building_type type = BUILDING_SENATE_1_UNUSED; type <= BUILDING_FORUM_2_UNUSED; type++) {
+        data.spawners[type] = spawn_figure_senate_forum;
+    }
+    for (building_type type = BUILDING_NONE; type < BUILDING_TYPE_MAX; type++) {
+        if (building_is_raw_resource_producer(type) || building_is_farm(type) || building_is_workshop(type)) {
+            data.spawners[type] = spawn_figure_industry;
+        }
+    }
+    for (building_type type = BUILDING_HOUSE_SMALL_VILLA; type <= BUILDING_HOUSE_LUXURY_PALACE; type++) {
+        data.spawners[type] = spawn_figure_patrician;
+    }
+    data.spawners_initialized = 1;
+}
+
 void building_figure_generate(void)
 {
-    int patrician_generated = 0;
+    if (!data.spawners_initialized) {
+        init_spawners();
+    }
+    // beggars only appear when unemployment is high, so the smaller houses usually have nothing to do
+    figure_spawner house_spawner = city_labor_unemployment_percentage() > BEGGAR_UNEMPLOYMENT_THRESHOLD ?
+        spawn_beggar : 0;
+    for (building_type type = BUILDING_HOUSE_SMALL_TENT; type <= BUILDING_HOUSE_GRAND_INSULA; type++) {
+        data.spawners[type] = house_spawner;
+    }
+    data.patrician_generated = 0;
     calculate_houses_needed_per_beggar();
     for (int i = 1; i < building_count(); i++) {
         building *b = building_get(i);
@@ -1986,166 +2089,9 @@ void building_figure_generate(void)
         }
 
         b->show_on_problem_overlay = 0;
-        // range of building types
-        if (b->type >= BUILDING_HOUSE_SMALL_TENT && b->type <= BUILDING_HOUSE_GRAND_INSULA) {
-            if (city_labor_unemployment_percentage() > BEGGAR_UNEMPLOYMENT_THRESHOLD) {
-                spawn_beggar(b);
-            }
-        } else if (b->type >= BUILDING_HOUSE_SMALL_VILLA && b->type <= BUILDING_HOUSE_LUXURY_PALACE) {
-            patrician_generated = spawn_patrician(b, patrician_generated);
-        } else if (building_is_raw_resource_producer(b->type) ||
-            building_is_farm(b->type) || building_is_workshop(b->type)) {
-            spawn_figure_industry(b);
-        } else if (b->type >= BUILDING_SENATE_1_UNUSED && b->type <= BUILDING_FORUM_2_UNUSED) {
-            spawn_figure_senate_forum(b);
-        } else if (b->type >= BUILDING_SMALL_TEMPLE_CERES &&
-            b->type <= BUILDING_LARGE_TEMPLE_VENUS && b->monument.phase <= 0) {
-            spawn_figure_temple(b);
-        } else {
-            // single building type
-            switch (b->type) {
-                default:
-                    break;
-                case BUILDING_WAREHOUSE:
-                    spawn_figure_warehouse(b);
-                    break;
-                case BUILDING_GRANARY:
-                    spawn_figure_granary(b);
-                    break;
-                case BUILDING_TOWER:
-                    spawn_figure_tower(b);
-                    break;
-                case BUILDING_ENGINEERS_POST:
-                    spawn_figure_engineers_post(b);
-                    break;
-                case BUILDING_PREFECTURE:
-                    spawn_figure_prefecture(b);
-                    break;
-                case BUILDING_ACTOR_COLONY:
-                    spawn_figure_actor_colony(b);
-                    break;
-                case BUILDING_GLADIATOR_SCHOOL:
-                    spawn_figure_gladiator_school(b);
-                    break;
-                case BUILDING_LION_HOUSE:
-                    spawn_figure_lion_house(b);
-                    break;
-                case BUILDING_CHARIOT_MAKER:
-                    spawn_figure_chariot_maker(b);
-                    break;
-                case BUILDING_AMPHITHEATER:
-                    spawn_figure_amphitheater(b);
-                    break;
-                case BUILDING_THEATER:
-                    spawn_figure_theater(b);
-                    break;
-                case BUILDING_HIPPODROME:
-                    spawn_figure_hippodrome(b);
-                    break;
-                case BUILDING_COLOSSEUM:
-                    spawn_figure_colosseum(b);
-                    break;
-                case BUILDING_ARENA:
-                    spawn_figure_colosseum(b);
-                    break;
-                case BUILDING_MARKET:
-                    spawn_figure_market(b);
-                    break;
-                case BUILDING_BATHHOUSE:
-                    spawn_figure_bathhouse(b);
-                    break;
-                case BUILDING_SCHOOL:
-                    spawn_figure_school(b);
-                    break;
-                case BUILDING_LIBRARY:
-                    spawn_figure_library(b);
-                    break;
-                case BUILDING_ACADEMY:
-                    spawn_figure_academy(b);
-                    break;
-                case BUILDING_BARBER:
-                    spawn_figure_barber(b);
-                    break;
-                case BUILDING_DOCTOR:
-                    spawn_figure_doctor(b);
-                    break;
-                case BUILDING_HOSPITAL:
-                    spawn_figure_hospital(b);
-                    break;
-                case BUILDING_MISSION_POST:
-                    spawn_figure_mission_post(b);
-                    break;
-                case BUILDING_DOCK:
-                    spawn_figure_dock(b);
-                    break;
-                case BUILDING_WHARF:
-                    spawn_figure_wharf(b);
-                    break;
-                case BUILDING_SHIPYARD:
-                    spawn_figure_shipyard(b);
-                    break;
-                case BUILDING_NATIVE_HUT:
-                case BUILDING_NATIVE_HUT_ALT:
-                    spawn_figure_native_hut(b);
-                    break;
-                case BUILDING_NATIVE_MEETING:
-                    spawn_figure_native_meeting(b);
-                    break;
-                case BUILDING_NATIVE_CROPS:
-                    update_native_crop_progress(b);
-                    break;
-                case BUILDING_FORT_LEGIONARIES:
-                case BUILDING_FORT_JAVELIN:
-                case BUILDING_FORT_ARCHERS:
-                case BUILDING_FORT_AUXILIA_INFANTRY:
-                case BUILDING_FORT_MOUNTED:
-                    formation_legion_update_recruit_status(b);
-                    spawn_figure_fort_supplier(b);
-                    break;
-                case BUILDING_BARRACKS:
-                    spawn_figure_barracks(b);
-                    break;
-                case BUILDING_MILITARY_ACADEMY:
-                    spawn_figure_military_academy(b);
-                    break;
-                case BUILDING_WORKCAMP:
-                    spawn_figure_work_camp(b);
-                    break;
-                case BUILDING_ARCHITECT_GUILD:
-                    spawn_figure_architect_guild(b);
-                    break;
-                case BUILDING_MESS_HALL:
-                    spawn_figure_mess_hall(b);
-                    break;
-                case BUILDING_GRAND_TEMPLE_MARS:
-                    spawn_figure_grand_temple_mars(b);
-                    break;
-                case BUILDING_GRAND_TEMPLE_CERES:
-                case BUILDING_GRAND_TEMPLE_NEPTUNE:
-                case BUILDING_GRAND_TEMPLE_MERCURY:
-                case BUILDING_GRAND_TEMPLE_VENUS:
-                case BUILDING_PANTHEON:
-                    spawn_figure_temple(b);
-                    break;
-                case BUILDING_LIGHTHOUSE:
-                    spawn_figure_lighthouse(b);
-                    break;
-                case BUILDING_TAVERN:
-                    spawn_figure_tavern(b);
-                    break;
-                case BUILDING_WATCHTOWER:
-                    spawn_figure_watchtower(b);
-                    break;
-                case BUILDING_CARAVANSERAI:
-                    spawn_figure_caravanserai(b);
-                    break;
-                case BUILDING_DEPOT:
-                    spawn_figure_depot(b);
-                    break;
-                case BUILDING_ARMOURY:
-                    spawn_figure_armoury(b);
-                    break;
-            }
+        figure_spawner spawner = data.spawners[b->type];
+        if (spawner) {
+            spawner(b);
         }
     }
 }
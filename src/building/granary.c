@@ -3,6 +3,7 @@
 #include "building/destruction.h"
 #include "building/model.h"
 #include "building/storage.h"
+#include "building/storage_index.h"
 #include "building/warehouse.h"
 #include "city/finance.h"
 #include "city/map.h"
@@ -446,6 +447,46 @@ building *building_granary_get_granary_needing_food(building *source, int resour
     return b; // null
 }
 
+typedef struct {
+    int x;
+    int y;
+    int resource;
+    int road_network_id;
+    int *understaffed;
+} storage_request;
+
+static int score_granary_for_storing(building *b, void *userdata)
+{
+    const storage_request *request = userdata;
+    if (b->road_network_id != request->road_network_id ||
+        !building_granary_accepts_storage(b, request->resource, request->understaffed)) {
+        return BUILDING_STORAGE_INDEX_NO_MATCH;
+    }
+    // there is room
+    return calc_maximum_distance(b->x + 1, b->y + 1, request->x, request->y);
+}
+
+static int score_getting_granary_for_storing(building *b, void *userdata)
+{
+    const storage_request *request = userdata;
+    if (b->state != BUILDING_STATE_IN_USE || b->has_plague) {
+        return BUILDING_STORAGE_INDEX_NO_MATCH;
+    }
+    if (!b->has_road_access || b->distance_from_entry <= 0 || b->road_network_id != request->road_network_id) {
+        return BUILDING_STORAGE_INDEX_NO_MATCH;
+    }
+    int pct_workers = calc_percentage(b->num_workers, model_get_building(b->type)->laborers);
+    if (pct_workers < 100) {
+        return BUILDING_STORAGE_INDEX_NO_MATCH;
+    }
+    const building_storage *s = building_storage_get(b->storage_id);
+    if (!building_granary_maximum_receptible_amount(b, request->resource) || s->empty_all) {
+        return BUILDING_STORAGE_INDEX_NO_MATCH;
+    }
+    // there is room
+    return calc_maximum_distance(b->x + 1, b->y + 1, request->x, request->y);
+}
+
 int building_granary_for_storing(int x, int y, int resource, int road_network_id,
     int force_on_stockpile, int *understaffed, map_point *dst)
 {
@@ -458,20 +499,11 @@ int building_granary_for_storing(int x, int y, int resource, int road_network_id
     if (city_resource_is_stockpiled(resource) && !force_on_stockpile) {
         return 0;
     }
-    int min_dist = INFINITE;
-    int min_building_id = 0;
-    for (building *b = building_first_of_type(BUILDING_GRANARY); b; b = b->next_of_type) {
-        if (b->road_network_id != road_network_id ||
-            !building_granary_accepts_storage(b, resource, understaffed)) {
-            continue;
-        }
-        // there is room
-        int dist = calc_maximum_distance(b->x + 1, b->y + 1, x, y);
-        if (dist < min_dist) {
-            min_dist = dist;
-            min_building_id = b->id;
-        }
-    }
+    storage_request request = { x, y, resource, road_network_id, understaffed };
+    // The caller may still turn down the granary found, so every understaffed granary has to be counted
+    int min_building_id = understaffed ?
+        building_storage_index_find_best_of_all(BUILDING_GRANARY, score_granary_for_storing, &request) :
+        building_storage_index_find_best(BUILDING_GRANARY, x, y, 1, score_granary_for_storing, &request);
     // deliver to center of granary
     building *min = building_get(min_building_id);
     map_point_store_result(min->x + 1, min->y + 1, dst);
@@ -490,31 +522,9 @@ int building_getting_granary_for_storing(int x, int y, int resource, int road_ne
     if (city_resource_is_stockpiled(resource)) {
         return 0;
     }
-    int min_dist = INFINITE;
-    int min_building_id = 0;
-    for (building *b = building_first_of_type(BUILDING_GRANARY); b; b = b->next_of_type) {
-        if (b->state != BUILDING_STATE_IN_USE || b->has_plague) {
-            continue;
-        }
-        if (!b->has_road_access || b->distance_from_entry <= 0 || b->road_network_id != road_network_id) {
-            continue;
-        }
-        int pct_workers = calc_percentage(b->num_workers, model_get_building(b->type)->laborers);
-        if (pct_workers < 100) {
-            continue;
-        }
-        const building_storage *s = building_storage_get(b->storage_id);
-        if (!building_granary_maximum_receptible_amount(b, resource) || s->empty_all) {
-            continue;
-        } else {
-            // there is room
-            int dist = calc_maximum_distance(b->x + 1, b->y + 1, x, y);
-            if (dist < min_dist) {
-                min_dist = dist;
-                min_building_id = b->id;
-            }
-        }
-    }
+    storage_request request = { x, y, resource, road_network_id, 0 };
+    int min_building_id = building_storage_index_find_best(BUILDING_GRANARY, x, y, 1,
+        score_getting_granary_for_storing, &request);
     building *min = building_get(min_building_id);
     map_point_store_result(min->x + 1, min->y + 1, dst);
     return min_building_id;
@@ -156,7 +156,7 @@ building *building_granary_get_granary_needing_food(building *source, int resour
  * @param resource
  * @param road_network_id
  * @param force_on_stockpile
- * @param understaffed
+ * @param understaffed Incremented for every understaffed granary on the road network, may be 0
  * @param dst
  * @return ID of the granary, or 0 if none found
  */
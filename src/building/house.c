@@ -63,6 +63,7 @@ void building_house_change_to_vacant_lot(building *house)
         map_building_tiles_remove(house->id, house->x, house->y);
         house->house_is_merged = 0;
         house->size = house->house_size = 1;
+        building_update_hot_fields(house);
         house->is_close_to_water = building_is_close_to_water(house);
         map_building_tiles_add(house->id, house->x, house->y, 1, building_image_get(house), TERRAIN_BUILDING);
         create_vacant_lot(house->x + 1, house->y);
@@ -93,6 +94,7 @@ static void prepare_for_merge(int building_id, int num_tiles)
                 }
                 house->house_population = 0;
                 house->state = BUILDING_STATE_DELETED_BY_GAME;
+                building_update_hot_fields(house);
             }
         }
     }
@@ -116,6 +118,7 @@ static void merge(building *b)
     b->x = merge_data.x;
     b->y = merge_data.y;
     b->grid_offset = map_grid_offset(b->x, b->y);
+    building_update_hot_fields(b);
     b->house_is_merged = 1;
     map_building_tiles_add(b->id, b->x, b->y, 2, building_image_get(b), TERRAIN_BUILDING);
 }
@@ -293,6 +296,7 @@ static void split_size2(building *house, building_type new_type)
     building_change_type(house, new_type);
     house->subtype.house_level = house->type - BUILDING_HOUSE_VACANT_LOT;
     house->size = house->house_size = 1;
+    building_update_hot_fields(house);
     house->is_close_to_water = building_is_close_to_water(house);
     house->house_is_merged = 0;
     house->house_population = population_per_tile + population_remainder;
@@ -327,6 +331,7 @@ static void split_size3(building *house)
     building_change_type(house, BUILDING_HOUSE_MEDIUM_INSULA);
     house->subtype.house_level = house->type - BUILDING_HOUSE_VACANT_LOT;
     house->size = house->house_size = 1;
+    building_update_hot_fields(house);
     house->is_close_to_water = building_is_close_to_water(house);
     house->house_is_merged = 0;
     house->house_population = population_per_tile + population_remainder;
@@ -386,6 +391,7 @@ void building_house_expand_to_large_insula(building *house)
     house->x = merge_data.x;
     house->y = merge_data.y;
     house->grid_offset = map_grid_offset(house->x, house->y);
+    building_update_hot_fields(house);
     map_building_tiles_add(house->id, house->x, house->y, house->size, building_image_get(house), TERRAIN_BUILDING);
 }
 
@@ -406,6 +412,7 @@ void building_house_expand_to_large_villa(building *house)
     house->x = merge_data.x;
     house->y = merge_data.y;
     house->grid_offset = map_grid_offset(house->x, house->y);
+    building_update_hot_fields(house);
     map_building_tiles_add(house->id, house->x, house->y, house->size, building_image_get(house), TERRAIN_BUILDING);
 }
 
@@ -426,6 +433,7 @@ void building_house_expand_to_large_palace(building *house)
     house->x = merge_data.x;
     house->y = merge_data.y;
     house->grid_offset = map_grid_offset(house->x, house->y);
+    building_update_hot_fields(house);
     map_building_tiles_add(house->id, house->x, house->y, house->size, building_image_get(house), TERRAIN_BUILDING);
 }
 
@@ -483,6 +491,7 @@ void building_house_desize_patrician(building *house)
     house->subtype.house_level = house->type - BUILDING_HOUSE_VACANT_LOT;
     unsigned char new_size = house->size - 1;
     house->size = house->house_size = new_size;
+    building_update_hot_fields(house);
     house->is_close_to_water = building_is_close_to_water(house);
     house->house_is_merged = 0;
     house->distance_from_entry = 0;
@@ -508,6 +517,7 @@ void building_house_devolve_from_large_villa(building *house)
     building_change_type(house, BUILDING_HOUSE_MEDIUM_VILLA);
     house->subtype.house_level = house->type - BUILDING_HOUSE_VACANT_LOT;
     house->size = house->house_size = 2;
+    building_update_hot_fields(house);
     house->is_close_to_water = building_is_close_to_water(house);
     house->house_is_merged = 0;
     house->house_population = population_per_tile + population_remainder;
@@ -549,6 +559,7 @@ void building_house_devolve_from_large_palace(building *house)
     building_change_type(house, BUILDING_HOUSE_MEDIUM_PALACE);
     house->subtype.house_level = house->type - BUILDING_HOUSE_VACANT_LOT;
     house->size = house->house_size = 3;
+    building_update_hot_fields(house);
     house->is_close_to_water = building_is_close_to_water(house);
     house->house_is_merged = 0;
     house->house_population = population_per_tile + population_remainder;
@@ -590,6 +601,7 @@ void building_house_check_for_corruption(building *house)
                     house->grid_offset = grid_offset;
                     house->x = map_grid_offset_to_x(grid_offset);
                     house->y = map_grid_offset_to_y(grid_offset);
+                    building_update_hot_fields(house);
                     building_totals_add_corrupted_house(0);
                     return;
                 }
@@ -597,6 +609,7 @@ void building_house_check_for_corruption(building *house)
         }
         building_totals_add_corrupted_house(1);
         house->state = BUILDING_STATE_RUBBLE;
+        building_update_hot_fields(house);
     }
 }
 
@@ -242,6 +242,7 @@ void house_population_evict_overcrowded(void)
             } else {
                 // house has been removed
                 b->state = BUILDING_STATE_UNDO;
+                building_update_hot_fields(b);
             }
         }
     }
@@ -58,6 +58,7 @@ void building_maintenance_update_burning_ruins(void)
         if (b->fire_duration > 32) {
             game_undo_disable();
             b->state = BUILDING_STATE_RUBBLE;
+            building_update_hot_fields(b);
             map_building_tiles_set_rubble(i, b->x, b->y, b->size);
             recalculate_terrain = 1;
             continue;
@@ -260,6 +261,7 @@ void building_maintenance_check_rome_access(void)
                         b->house_unreachable_ticks = 0;
                     }
                     b->state = BUILDING_STATE_UNDO;
+                    building_update_hot_fields(b);
                 }
             } else {
                 int distance = map_routing_distance(map_grid_offset(x_road, y_road));
@@ -280,6 +282,7 @@ void building_maintenance_check_rome_access(void)
                     if (b->house_unreachable_ticks > 8) {
                         b->house_unreachable_ticks = 0;
                         b->state = BUILDING_STATE_UNDO;
+                        building_update_hot_fields(b);
                     }
                 }
                 b->road_access_x = x_road;
@@ -298,6 +301,7 @@ void building_maintenance_check_rome_access(void)
         } else if (b->type == BUILDING_WAREHOUSE_SPACE) {
             building *main_building = building_main(b);
             b->road_network_id = main_building->road_network_id;
+            building_update_hot_fields(b);
             b->distance_from_entry = main_building->distance_from_entry;
             b->road_access_x = main_building->road_access_x;
             b->road_access_y = main_building->road_access_y;
@@ -319,6 +323,7 @@ void building_maintenance_check_rome_access(void)
         }
         if (road_grid_offset >= 0) {
             b->road_network_id = map_road_network_get(road_grid_offset);
+            building_update_hot_fields(b);
             b->distance_from_entry = map_routing_distance(road_grid_offset);
             b->road_access_x = x_road;
             b->road_access_y = y_road;
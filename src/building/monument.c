@@ -775,9 +775,11 @@ int building_monument_toggle_construction_halted(building *b)
 {
     if (b->state == BUILDING_STATE_MOTHBALLED) {
         b->state = BUILDING_STATE_IN_USE;
+        building_update_hot_fields(b);
         return 0;
     } else {
         b->state = BUILDING_STATE_MOTHBALLED;
+        building_update_hot_fields(b);
         return 1;
     }
 }
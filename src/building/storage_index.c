@@ -0,0 +1,155 @@
+#include "storage_index.h"
+
+#include "map/grid.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Storage buildings are bucketed in square cells by their position. The buckets are rebuilt
+// when a storage building is added or removed, which is rare compared to the lookups.
+#define CELL_SIZE 8
+#define CELLS_PER_ROW ((GRID_SIZE + CELL_SIZE - 1) / CELL_SIZE)
+#define NUM_CELLS (CELLS_PER_ROW * CELLS_PER_ROW)
+
+typedef struct {
+    building_type type;
+    int is_built;
+    unsigned int version;
+    int capacity;
+    int *building_ids; // sorted by cell, then by building ID
+    int cell_start[NUM_CELLS + 1];
+} storage_index;
+
+static struct {
+    storage_index indexes[2];
+    int cell_fill[NUM_CELLS];
+} data = {
+    { { BUILDING_WAREHOUSE }, { BUILDING_GRANARY } }
+};
+
+static storage_index *get_index(building_type type)
+{
+    for (int i = 0; i < 2; i++) {
+        if (data.indexes[i].type == type) {
+            return &data.indexes[i];
+        }
+    }
+    return 0;
+}
+
+static int clamp_cell(int coordinate)
+{
+    int cell = coordinate / CELL_SIZE;
+    if (cell < 0) {
+        return 0;
+    }
+    return cell < CELLS_PER_ROW ? cell : CELLS_PER_ROW - 1;
+}
+
+static int get_cell(const building *b)
+{
+    return clamp_cell(b->y) * CELLS_PER_ROW + clamp_cell(b->x);
+}
+
+static int rebuild(storage_index *index)
+{
+    int num_buildings = 0;
+    for (building *b = building_first_of_type(index->type); b; b = b->next_of_type) {
+        num_buildings++;
+    }
+    if (num_buildings > index->capacity) {
+        int *building_ids = realloc(index->building_ids, num_buildings * sizeof(int));
+        if (!building_ids) {
+            return 0;
+        }
+        index->building_ids = building_ids;
+        index->capacity = num_buildings;
+    }
+    memset(index->cell_start, 0, sizeof(index->cell_start));
+    for (building *b = building_first_of_type(index->type); b; b = b->next_of_type) {
+        index->cell_start[get_cell(b) + 1]++;
+    }
+    for (int cell = 0; cell < NUM_CELLS; cell++) {
+        index->cell_start[cell + 1] += index->cell_start[cell];
+    }
+    memcpy(data.cell_fill, index->cell_start, sizeof(data.cell_fill));
+    // the list of buildings of a type is sorted by ID, so each cell is as well
+    for (building *b = building_first_of_type(index->type); b; b = b->next_of_type) {
+        index->building_ids[data.cell_fill[get_cell(b)]++] = b->id;
+    }
+    index->version = building_type_version(index->type);
+    index->is_built = 1;
+    return 1;
+}
+
+int building_storage_index_find_best_of_all(building_type type, building_storage_index_score score, void *userdata)
+{
+    int best_score = BUILDING_STORAGE_INDEX_NO_MATCH;
+    int best_building_id = 0;
+    for (building *b = building_first_of_type(type); b; b = b->next_of_type) {
+        int building_score = score(b, userdata);
+        if (building_score < best_score) {
+            best_score = building_score;
+            best_building_id = b->id;
+        }
+    }
+    return best_building_id;
+}
+
+int building_storage_index_find_best(building_type type, int x, int y, int max_bonus,
+    building_storage_index_score score, void *userdata)
+{
+    storage_index *index = get_index(type);
+    if (!index) {
+        return building_storage_index_find_best_of_all(type, score, userdata);
+    }
+    if ((!index->is_built || index->version != building_type_version(type)) && !rebuild(index)) {
+        return building_storage_index_find_best_of_all(type, score, userdata);
+    }
+    int can_stop_early = x >= 0 && y >= 0 && x < GRID_SIZE && y < GRID_SIZE;
+    int cell_x = clamp_cell(x);
+    int cell_y = clamp_cell(y);
+    int max_ring = cell_x;
+    if (CELLS_PER_ROW - 1 - cell_x > max_ring) {
+        max_ring = CELLS_PER_ROW - 1 - cell_x;
+    }
+    if (cell_y > max_ring) {
+        max_ring = cell_y;
+    }
+    if (CELLS_PER_ROW - 1 - cell_y > max_ring) {
+        max_ring = CELLS_PER_ROW - 1 - cell_y;
+    }
+
+    int best_score = BUILDING_STORAGE_INDEX_NO_MATCH;
+    int best_building_id = 0;
+    for (int ring = 0; ring <= max_ring; ring++) {
+        // no tile in a cell of this ring is closer than this
+        int min_distance = ring > 0 ? (ring - 1) * CELL_SIZE + 1 : 0;
+        if (can_stop_early && best_building_id && min_distance - max_bonus > best_score) {
+            break;
+        }
+        for (int y_cell = cell_y - ring; y_cell <= cell_y + ring; y_cell++) {
+            if (y_cell < 0 || y_cell >= CELLS_PER_ROW) {
+                continue;
+            }
+            int is_edge_row = y_cell == cell_y - ring || y_cell == cell_y + ring;
+            int x_step = is_edge_row || ring == 0 ? 1 : 2 * ring;
+            for (int x_cell = cell_x - ring; x_cell <= cell_x + ring; x_cell += x_step) {
+                if (x_cell < 0 || x_cell >= CELLS_PER_ROW) {
+                    continue;
+                }
+                int cell = y_cell * CELLS_PER_ROW + x_cell;
+                for (int i = index->cell_start[cell]; i < index->cell_start[cell + 1]; i++) {
+                    int building_id = index->building_ids[i];
+                    int building_score = score(building_get(building_id), userdata);
+                    if (building_score < best_score ||
+                        (building_score == best_score && best_building_id && building_id < best_building_id)) {
+                        best_score = building_score;
+                        best_building_id = building_id;
+                    }
+                }
+            }
+        }
+    }
+    return best_building_id;
+}
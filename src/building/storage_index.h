@@ -0,0 +1,49 @@
+#ifndef BUILDING_STORAGE_INDEX_H
+#define BUILDING_STORAGE_INDEX_H
+
+#include "building/building.h"
+
+/**
+ * @file
+ * Spatial index of storage buildings for nearest storage lookups
+ */
+
+#define BUILDING_STORAGE_INDEX_NO_MATCH 100000
+
+/**
+ * Scores a building for a lookup
+ * @param b The building to score
+ * @param userdata Data passed to building_storage_index_find_best
+ * @return The score, usually the distance to the building, or BUILDING_STORAGE_INDEX_NO_MATCH
+ * if the building does not qualify
+ */
+typedef int (*building_storage_index_score)(building *b, void *userdata);
+
+/**
+ * Finds the building of a type with the lowest score. Buildings are visited roughly in order of
+ * distance to the given point and the search stops when no building further away can score lower.
+ * When several buildings have the lowest score, the one with the lowest ID is returned, as when
+ * walking the list of buildings of that type.
+ * When no building qualifies, all buildings of the type are scored.
+ * @param type BUILDING_WAREHOUSE or BUILDING_GRANARY
+ * @param x X position to measure from
+ * @param y Y position to measure from
+ * @param max_bonus The most a score can be lower than the distance from the point to the building
+ * @param score Scoring function
+ * @param userdata Data to pass to the scoring function
+ * @return The ID of the building with the lowest score or 0 if no building qualifies
+ */
+int building_storage_index_find_best(building_type type, int x, int y, int max_bonus,
+    building_storage_index_score score, void *userdata);
+
+/**
+ * Finds the building of a type with the lowest score, scoring every building of the type.
+ * For scoring functions that have to see all buildings, not just the ones near the best.
+ * @param type BUILDING_WAREHOUSE or BUILDING_GRANARY
+ * @param score Scoring function
+ * @param userdata Data to pass to the scoring function
+ * @return The ID of the building with the lowest score or 0 if no building qualifies
+ */
+int building_storage_index_find_best_of_all(building_type type, building_storage_index_score score, void *userdata);
+
+#endif // BUILDING_STORAGE_INDEX_H
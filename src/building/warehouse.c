@@ -7,6 +7,7 @@
 #include "building/monument.h"
 #include "building/model.h"
 #include "building/storage.h"
+#include "building/storage_index.h"
 #include "city/finance.h"
 #include "city/resource.h"
 #include "core/calc.h"
@@ -576,23 +577,33 @@ int building_warehouse_accepts_storage(building *b, int resource, int *understaf
     return 0;
 }
 
+typedef struct {
+    int src_building_id;
+    int x;
+    int y;
+    int resource;
+    int road_network_id;
+    int *understaffed;
+} storage_request;
+
+static int score_warehouse_for_storing(building *b, void *userdata)
+{
+    const storage_request *request = userdata;
+    if (b->id == request->src_building_id ||
+        (request->road_network_id != -1 && b->road_network_id != request->road_network_id) ||
+        !building_warehouse_accepts_storage(b, request->resource, request->understaffed) ||
+        (building_warehouse_maximum_receptible_amount(b, request->resource) <= 0)) {
+        return BUILDING_STORAGE_INDEX_NO_MATCH;
+    }
+    return calc_maximum_distance(b->x, b->y, request->x, request->y);
+}
+
 int building_warehouse_for_storing(int src_building_id, int x, int y, int resource, int road_network_id,
     int *understaffed, map_point *dst)
 {
-    int min_dist = INFINITE;
-    int min_building_id = 0;
-    for (building *b = building_first_of_type(BUILDING_WAREHOUSE); b; b = b->next_of_type) {
-        if (b->id == src_building_id || (road_network_id != -1 && b->road_network_id != road_network_id) ||
-            !building_warehouse_accepts_storage(b, resource, understaffed) ||
-            (building_warehouse_maximum_receptible_amount(b, resource) <= 0)) {
-            continue;
-        }
-        int dist = calc_maximum_distance(b->x, b->y, x, y);
-        if (dist < min_dist) {
-            min_dist = dist;
-            min_building_id = b->id;
-        }
-    }
+    storage_request request = { src_building_id, x, y, resource, road_network_id, understaffed };
+    int min_building_id = building_storage_index_find_best(BUILDING_WAREHOUSE, x, y, 0,
+        score_warehouse_for_storing, &request);
     building *b = building_get(min_building_id);
     if (b->has_road_access == 1) {
         map_point_store_result(b->x, b->y, dst);
@@ -646,46 +657,60 @@ int building_warehouse_for_getting(building *src, int resource, map_point *dst)
     }
 }
 
-int building_warehouse_with_resource(int x, int y, int resource, int road_network_id,
-     int *understaffed, map_point *dst, building_storage_permission_states p)
+typedef struct {
+    int x;
+    int y;
+    int resource;
+    int road_network_id;
+    int *understaffed;
+    building_storage_permission_states permission;
+} resource_request;
+
+static int score_warehouse_with_resource(building *b, void *userdata)
 {
-    int min_dist = INFINITE;
-    building *min_building = 0;
-    for (building *b = building_first_of_type(BUILDING_WAREHOUSE); b; b = b->next_of_type) {
-        if (b->state != BUILDING_STATE_IN_USE || b->has_plague) {
-            continue;
-        }
-        if (!b->has_road_access || b->distance_from_entry <= 0 || b->road_network_id != road_network_id) {
-            continue;
-        }
-        if (!building_storage_get_permission(p, b)) {
-            continue;
-        }
+    const resource_request *request = userdata;
+    if (b->state != BUILDING_STATE_IN_USE || b->has_plague) {
+        return BUILDING_STORAGE_INDEX_NO_MATCH;
+    }
+    if (!b->has_road_access || b->distance_from_entry <= 0 || b->road_network_id != request->road_network_id) {
+        return BUILDING_STORAGE_INDEX_NO_MATCH;
+    }
+    if (!building_storage_get_permission(request->permission, b)) {
+        return BUILDING_STORAGE_INDEX_NO_MATCH;
+    }
 
-        int pct_workers = calc_percentage(b->num_workers, model_get_building(b->type)->laborers);
-        if (pct_workers < 100) {
-            if (understaffed) {
-                *understaffed += 1;
-            }
-            continue;
-        }
-        int loads_stored = 0;
-        building *space = b;
-        for (int t = 0; t < 8; t++) {
-            space = building_next(space);
-            if (space->id > 0 && space->subtype.warehouse_resource_id == resource) {
-                loads_stored += space->resources[resource];
-            }
+    int pct_workers = calc_percentage(b->num_workers, model_get_building(b->type)->laborers);
+    if (pct_workers < 100) {
+        if (request->understaffed) {
+            *request->understaffed += 1;
         }
-        if (loads_stored > 0) {
-            int dist = calc_maximum_distance(b->x, b->y, x, y);
-            dist -= 2 * loads_stored;
-            if (dist < min_dist) {
-                min_dist = dist;
-                min_building = b;
-            }
+        return BUILDING_STORAGE_INDEX_NO_MATCH;
+    }
+    int loads_stored = 0;
+    building *space = b;
+    for (int t = 0; t < 8; t++) {
+        space = building_next(space);
+        if (space->id > 0 && space->subtype.warehouse_resource_id == request->resource) {
+            loads_stored += space->resources[request->resource];
         }
     }
+    if (loads_stored <= 0) {
+        return BUILDING_STORAGE_INDEX_NO_MATCH;
+    }
+    return calc_maximum_distance(b->x, b->y, request->x, request->y) - 2 * loads_stored;
+}
+
+int building_warehouse_with_resource(int x, int y, int resource, int road_network_id,
+     int *understaffed, map_point *dst, building_storage_permission_states p)
+{
+    resource_request request = { x, y, resource, road_network_id, understaffed, p };
+    // a full warehouse scores lower than its distance
+    building *min_building = 0;
+    int min_building_id = building_storage_index_find_best(BUILDING_WAREHOUSE, x, y,
+        2 * 8 * MAX_CARTLOADS_PER_SPACE, score_warehouse_with_resource, &request);
+    if (min_building_id) {
+        min_building = building_get(min_building_id);
+    }
     if (min_building) {
         if (dst) {
             map_point_store_result(min_building->road_access_x, min_building->road_access_y, dst);
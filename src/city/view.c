@@ -805,6 +805,51 @@ static void do_valid_callback(int view_x, int view_y, int grid_offset, map_callb
     }
 }
 
+void city_view_get_visible_view_area(int *x_view, int *y_view, int *width, int *height)
+{
+    *x_view = data.camera.tile.x - 6;
+    *y_view = data.camera.tile.y - 8;
+    *width = data.viewport.width_tiles + 9;
+    *height = data.viewport.height_tiles + 21;
+}
+
+void city_view_view_tile_to_draw_position(int x_view, int y_view, int *x, int *y)
+{
+    *x = data.viewport.x - data.camera.pixel.x + TILE_WIDTH_PIXELS * (x_view - data.camera.tile.x);
+    if ((y_view - data.camera.tile.y) & 1) {
+        *x -= HALF_TILE_WIDTH_PIXELS;
+    }
+    *y = data.viewport.y - data.camera.pixel.y + HALF_TILE_HEIGHT_PIXELS * (y_view - data.camera.tile.y - 1);
+}
+
+void city_view_foreach_valid_map_tile_in_view_area(int x_view, int y_view, int width, int height,
+    int x, int y, map_callback *callback)
+{
+    // Odd rows relative to the camera are shifted left by half a tile, and the first row may be one of them
+    int first_row_shift = ((y_view - data.camera.tile.y) & 1) ? HALF_TILE_WIDTH_PIXELS : 0;
+    int y_graphic = y;
+    for (int y_offset = 0; y_offset < height; y_offset++) {
+        int current_y_view = y_view + y_offset;
+        if (current_y_view >= 0 && current_y_view < VIEW_Y_MAX) {
+            int x_graphic = x + first_row_shift;
+            if ((current_y_view - data.camera.tile.y) & 1) {
+                x_graphic -= HALF_TILE_WIDTH_PIXELS;
+            }
+            for (int x_offset = 0; x_offset < width; x_offset++) {
+                int current_x_view = x_view + x_offset;
+                if (current_x_view >= 0 && current_x_view < VIEW_X_MAX) {
+                    int grid_offset = view_to_grid_offset_lookup[current_x_view][current_y_view];
+                    if (grid_offset >= 0) {
+                        callback(x_graphic, y_graphic, grid_offset);
+                    }
+                }
+                x_graphic += TILE_WIDTH_PIXELS;
+            }
+        }
+        y_graphic += HALF_TILE_HEIGHT_PIXELS;
+    }
+}
+
 void city_view_foreach_tile_in_range(int grid_offset, int size, int radius, map_callback *callback)
 {
     int x, y;
@@ -87,6 +87,13 @@ void city_view_foreach_valid_map_tile(map_callback *callback);
 
 void city_view_foreach_valid_map_tile_row(map_callback *callback1, map_callback *callback2, map_callback *callback3);
 
+void city_view_get_visible_view_area(int *x_view, int *y_view, int *width, int *height);
+
+void city_view_view_tile_to_draw_position(int x_view, int y_view, int *x, int *y);
+
+void city_view_foreach_valid_map_tile_in_view_area(int x_view, int y_view, int width, int height,
+    int x, int y, map_callback *callback);
+
 void city_view_foreach_tile_in_range(int grid_offset, int size, int radius, map_callback *callback);
 
 void city_view_foreach_minimap_tile(
@@ -28,3 +28,76 @@ void array_free(void **data, unsigned int blocks)
     }
     free(data);
 }
+
+static int ensure_free_slot_words(uint32_t **slots, unsigned int *words, unsigned int needed_words)
+{
+    if (needed_words <= *words) {
+        return 1;
+    }
+    unsigned int new_words = *words ? *words : 1;
+    while (new_words < needed_words) {
+        new_words *= 2;
+    }
+    uint32_t *new_slots = realloc(*slots, sizeof(uint32_t) * new_words);
+    if (!new_slots) {
+        return 0;
+    }
+    memset(&new_slots[*words], 0, sizeof(uint32_t) * (new_words - *words));
+    *slots = new_slots;
+    *words = new_words;
+    return 1;
+}
+
+int array_reset_free_slots(uint32_t **slots, unsigned int *words, unsigned int size)
+{
+    if (*slots) {
+        memset(*slots, 0, sizeof(uint32_t) * *words);
+    }
+    if (!ensure_free_slot_words(slots, words, (size >> 5) + 1)) {
+        free(*slots);
+        *slots = 0;
+        *words = 0;
+        return 0;
+    }
+    return 1;
+}
+
+void array_set_free_slot(uint32_t **slots, unsigned int *words, unsigned int index)
+{
+    if (!ensure_free_slot_words(slots, words, (index >> 5) + 1)) {
+        // without the bitmap, the array checks every item again
+        free(*slots);
+        *slots = 0;
+        *words = 0;
+        return;
+    }
+    (*slots)[index >> 5] |= (uint32_t) 1 << (index & 31);
+}
+
+void array_clear_free_slot(uint32_t *slots, unsigned int words, unsigned int index)
+{
+    if ((index >> 5) < words) {
+        slots[index >> 5] &= ~((uint32_t) 1 << (index & 31));
+    }
+}
+
+unsigned int array_next_free_slot(const uint32_t *slots, unsigned int words, unsigned int start, unsigned int end)
+{
+    unsigned int word = start >> 5;
+    if (word >= words) {
+        return end;
+    }
+    uint32_t bits = slots[word] & (UINT32_MAX << (start & 31));
+    while (!bits) {
+        if (++word >= words) {
+            return end;
+        }
+        bits = slots[word];
+    }
+    unsigned int index = word << 5;
+    while (!(bits & 1)) {
+        bits >>= 1;
+        index++;
+    }
+    return index < end ? index : end;
+}
@@ -1,6 +1,7 @@
 #ifndef CORE_ARRAY_H
 #define CORE_ARRAY_H
 
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -17,6 +18,8 @@ struct { \
     unsigned int bit_offset; \
     void (*constructor)(T *, unsigned int); \
     int (*in_use)(const T *); \
+    uint32_t *free_slots; \
+    unsigned int free_slots_words; \
 }
 
 /**
@@ -26,6 +29,7 @@ struct { \
 #define array_clear(a) \
 ( \
     array_free((void **)(a).items, (a).blocks), \
+    free((a).free_slots), \
     memset(&(a), 0, sizeof(a)) \
 )
 
@@ -63,8 +67,10 @@ struct { \
     ptr = 0; \
     int error = 0; \
     if ((a).in_use) { \
-        for (unsigned int array_index = 0; array_index < (a).size; array_index++) { \
+        for (unsigned int array_index = array_first_free_slot(a, 0); array_index < (a).size; \
+            array_index = array_first_free_slot(a, array_index + 1)) { \
             if (!(a).in_use(array_item(a, array_index))) { \
+                array_take_free_slot(a, array_index); \
                 ptr = array_item(a, array_index); \
                 memset(ptr, 0, sizeof(**(a).items)); \
                 if ((a).constructor) { \
@@ -95,10 +101,13 @@ struct { \
             error = 1; \
             break; \
         } \
+        array_mark_item_free(a, (a).size - 1); \
     } \
     if (!error && (a).in_use) { \
-        for (unsigned int array_index = index; array_index < (a).size; array_index++) { \
+        for (unsigned int array_index = array_first_free_slot(a, index); array_index < (a).size; \
+            array_index = array_first_free_slot(a, array_index + 1)) { \
             if (!(a).in_use(array_item(a, array_index))) { \
+                array_take_free_slot(a, array_index); \
                 ptr = array_item(a, array_index); \
                 memset(ptr, 0, sizeof(**(a).items)); \
                 if ((a).constructor) { \
@@ -130,6 +139,9 @@ struct { \
         memset(array_item(a, (a).size - 1), 0, sizeof(**(a).items)); \
         (a).size--; \
     } \
+    if ((a).free_slots) { \
+        array_track_free_slots(a); \
+    } \
 }
 
 /**
@@ -235,6 +247,9 @@ struct { \
             } \
             (a).size -= items_to_move; \
         } \
+        if ((a).free_slots) { \
+            array_track_free_slots(a); \
+        } \
     } \
 }
 
@@ -249,6 +264,38 @@ struct { \
     array_create_blocks(a, (size) > 0 ? (((size) - 1) >> (a).bit_offset) + 1 - (a).blocks : 0) \
 )
 
+/**
+ * Makes the array keep a bitmap of the items that may be free, so that array_new_item and
+ * array_new_item_after_index find the first free item without calling in_use on every item before it.
+ * The items that are handed out are the same as without the bitmap.
+ * Only works for arrays with an in_use callback. Must be called again after array_init,
+ * and array_mark_item_free must be called whenever an item stops being in use.
+ * If memory for the bitmap cannot be allocated, the array falls back to checking every item.
+ * @param a The array structure
+ */
+#define array_track_free_slots(a) \
+{ \
+    if ((a).in_use && array_reset_free_slots(&(a).free_slots, &(a).free_slots_words, (a).size)) { \
+        for (unsigned int free_index = 0; free_index < (a).size; free_index++) { \
+            if (!(a).in_use(array_item(a, free_index))) { \
+                array_mark_item_free(a, free_index); \
+            } \
+        } \
+    } \
+}
+
+/**
+ * Tells an array that tracks its free items that an item is no longer in use.
+ * The item may still be reported as in use by the in_use callback, in which case it is skipped until it is not.
+ * Does nothing if the array does not track its free items.
+ * @param a The array structure
+ * @param index The index of the item
+ */
+#define array_mark_item_free(a, index) \
+( \
+    (a).free_slots ? array_set_free_slot(&(a).free_slots, &(a).free_slots_words, index) : (void) 0 \
+)
+
 /**
  * Gets the next item of the array without checking for memory bounds.
  * ONLY use when you're SURE the array memory bounds won't be exceeded!
@@ -257,6 +304,7 @@ struct { \
  */
 #define array_next(a) \
 ( \
+    array_take_free_slot(a, (a).size), \
     memset(array_item(a, (a).size), 0, sizeof(**(a).items)), \
     (a).constructor ? (a).constructor(array_item(a, (a).size), (a).size) : (void) 0, \
     (a).size++, \
@@ -271,6 +319,22 @@ struct { \
     array_add_blocks((void ***)&(a).items, &(a).blocks, (a).block_offset + 1, sizeof(**(a).items), num_blocks) \
 )
 
+/**
+ * This definition is private and should not be used
+ */
+#define array_first_free_slot(a, start) \
+( \
+    (a).free_slots ? array_next_free_slot((a).free_slots, (a).free_slots_words, start, (a).size) : (start) \
+)
+
+/**
+ * This definition is private and should not be used
+ */
+#define array_take_free_slot(a, index) \
+( \
+    (a).free_slots ? array_clear_free_slot((a).free_slots, (a).free_slots_words, index) : (void) 0 \
+)
+
 /**
  * This function is private and should not be used
  */
@@ -281,6 +345,14 @@ int array_add_blocks(void ***data, unsigned int *blocks, unsigned int items_per_
  */
 void array_free(void **data, unsigned int blocks);
 
+/**
+ * These functions are private and should not be used
+ */
+int array_reset_free_slots(uint32_t **slots, unsigned int *words, unsigned int size);
+void array_set_free_slot(uint32_t **slots, unsigned int *words, unsigned int index);
+void array_clear_free_slot(uint32_t *slots, unsigned int words, unsigned int index);
+unsigned int array_next_free_slot(const uint32_t *slots, unsigned int words, unsigned int start, unsigned int end);
+
 /**
  * Private helper compile-time functions for finding the next power of two into which a number fits
  */
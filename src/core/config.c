@@ -106,6 +106,8 @@ static const char *ini_keys[] = {
     [CONFIG_UI_CLEAR_WARNINGS_RIGHTCLICK] = "ui_clear_warnings_rightclick",
     [CONFIG_GP_CH_STORAGE_REQUESTS_RESPECT_MAINTAIN] = "gp_ch_storage_requests_respect_maintain",
     [CONFIG_GP_CH_MARKET_RANGE] = "gameplay_market_range",
+    [CONFIG_GP_CH_GOAL_DIRECTED_ROUTING] = "gameplay_goal_directed_routing",
+    [CONFIG_GP_CH_FAST_SAVE_FORMAT] = "gameplay_change_fast_save_format",
 };
 
 static const char *ini_string_keys[] = {
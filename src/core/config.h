@@ -96,6 +96,8 @@ typedef enum {
     CONFIG_UI_CLEAR_WARNINGS_RIGHTCLICK,
     CONFIG_GP_CH_STORAGE_REQUESTS_RESPECT_MAINTAIN,
     CONFIG_GP_CH_MARKET_RANGE,
+    CONFIG_GP_CH_GOAL_DIRECTED_ROUTING,
+    CONFIG_GP_CH_FAST_SAVE_FORMAT,
     CONFIG_MAX_ENTRIES
 } config_key;
 
@@ -3,6 +3,7 @@
 #include "core/config.h"
 #include "core/file.h"
 #include "core/string.h"
+#include "game/system.h"
 #include "platform/file_manager.h"
 
 #include <stdlib.h>
@@ -71,6 +72,8 @@ static int add_to_listing(const char *filename, long modified_time)
 
 const dir_listing *dir_find_files_with_extension(const char *dir, const char *extension)
 {
+    // a saved game that is still being written in the background must be complete when listed
+    system_wait_for_background_task();
     clear_dir_listing();
     snprintf(data.current_dir, FILE_NAME_MAX, "%s", dir);
     platform_file_manager_list_directory_contents(dir, TYPE_FILE, extension, add_to_listing);
@@ -85,6 +88,7 @@ const dir_listing *dir_find_files_with_extension_at_location(int location, const
 
 const dir_listing *dir_find_all_subdirectories(const char *dir)
 {
+    system_wait_for_background_task();
     clear_dir_listing();
     snprintf(data.current_dir, FILE_NAME_MAX, "%s", dir);
     platform_file_manager_list_directory_contents(dir, TYPE_DIR, 0, add_to_listing);
@@ -207,6 +211,7 @@ static const char *get_case_corrected_file(const char *dir, const char *filepath
 
 const dir_listing *dir_append_files_with_extension(const char *extension)
 {
+    system_wait_for_background_task();
     platform_file_manager_list_directory_contents(data.current_dir, TYPE_FILE, extension, add_to_listing);
     qsort(data.listing.files, data.listing.num_files, sizeof(dir_entry), compare_lower);
     return &data.listing;
@@ -17,6 +17,7 @@ static struct {
     int pool_index;
     int32_t pool[MAX_RANDOM];
     time_t last_seed;
+    int stdlib_seed_fixed;
 } data;
 
 void random_init(void)
@@ -96,7 +97,16 @@ void random_save_state(buffer *buf)
     buffer_write_u32(buf, data.iv2);
 }
 
+void random_set_stdlib_seed(unsigned int seed)
+{
+    srand(seed);
+    data.stdlib_seed_fixed = 1;
+}
+
 int random_from_stdlib(void) {
+    if (data.stdlib_seed_fixed) {
+        return rand();
+    }
     time_t t;
     t = time(&t);
     if (data.last_seed != t) {
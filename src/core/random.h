@@ -68,6 +68,13 @@ void random_save_state(buffer *buf);
  */
 void random_load_state(buffer *buf);
 
+/**
+ * Seeds the stdlib random generator with a fixed value, disabling the time-based reseeding.
+ * Used to make simulation runs reproducible.
+ * @param seed Seed to use
+ */
+void random_set_stdlib_seed(unsigned int seed);
+
 int random_from_stdlib(void);
 
 int random_between_from_stdlib(int min, int max);
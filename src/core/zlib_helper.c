@@ -51,3 +51,8 @@ int zlib_helper_compress(void *input_buffer, const int input_length, void *outpu
     *output_length = output_buffer_length - strm.avail_out;
     return 1;
 }
+
+unsigned int zlib_helper_crc32(unsigned int crc, const void *data, int length)
+{
+    return (unsigned int) mz_crc32(crc, data, length);
+}
@@ -3,6 +3,7 @@
 #include "city/entertainment.h"
 #include "city/figures.h"
 #include "figure/figure.h"
+#include "figure/route.h"
 #include "figuretype/animal.h"
 #include "figuretype/cartpusher.h"
 #include "figuretype/crime.h"
@@ -22,6 +23,7 @@
 #include "figuretype/wall.h"
 #include "figuretype/water.h"
 #include "figuretype/workcamp.h"
+#include "game/profiler.h"
 
 
 static void figure_nobody_action(figure *f)
@@ -131,6 +133,7 @@ void figure_action_handle(void)
 {
     city_figures_reset();
     city_entertainment_set_hippodrome_has_race(0);
+    figure_route_plan_ahead();
     for (int i = 1; i < figure_count(); i++) {
         figure *f = figure_get(i);
         if (f->state) {
@@ -143,7 +146,10 @@ void figure_action_handle(void)
                     f->targeted_by_figure_id = 0;
                 }
             }
-            figure_action_callbacks[f->type](f);
+            figure_type type = f->type;
+            uint64_t profiler_start = game_profiler_start();
+            figure_action_callbacks[type](f);
+            game_profiler_record_figure(type, profiler_start);
             if (f->state == FIGURE_STATE_DEAD) {
                 figure_delete(f);
             }
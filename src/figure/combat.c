@@ -12,6 +12,8 @@
 #include "map/figure.h"
 #include "sound/effect.h"
 
+static unsigned int attacks_started;
+
 static int is_attacking_native(const figure *f)
 {
     return f->type == FIGURE_INDIGENOUS_NATIVE && f->action_state == FIGURE_ACTION_159_NATIVE_ATTACKING;
@@ -417,6 +419,11 @@ static int can_attack_animal(figure_category category, figure_category opponent_
     return 0;
 }
 
+unsigned int figure_combat_attacks_started(void)
+{
+    return attacks_started;
+}
+
 void figure_combat_attack_figure_at(figure *f, int grid_offset)
 {
     figure_category category = figure_properties_for_type(f->type)->category;
@@ -426,16 +433,11 @@ void figure_combat_attack_figure_at(figure *f, int grid_offset)
         return;
     }
     formation *l = formation_get(f->formation_id);
-    int guard = 0;
-    int opponent_id = map_figure_at(grid_offset);
-    while (1) {
-        if (++guard >= figure_count() || opponent_id <= 0) {
-            break;
-        }
+    int opponent_id;
+    for (int i = 0; (opponent_id = map_figure_at_index(grid_offset, i)) != 0; i++) {
         figure *opponent = figure_get(opponent_id);
         if (opponent_id == f->id || opponent->is_ghost) {
             // Do not allow troops to attack themselves or enemies located outside of the map
-            opponent_id = opponent->next_figure_id_on_same_tile;
             continue;
         }
 
@@ -482,6 +484,7 @@ void figure_combat_attack_figure_at(figure *f, int grid_offset)
             attack = 0;
         }
         if (attack) {
+            attacks_started++;
             f->action_state_before_attack = f->action_state;
             f->action_state = FIGURE_ACTION_150_ATTACK;
             f->opponent_id = opponent_id;
@@ -514,6 +517,5 @@ void figure_combat_attack_figure_at(figure *f, int grid_offset)
             }
             return;
         }
-        opponent_id = opponent->next_figure_id_on_same_tile;
     }
 }
@@ -16,4 +16,6 @@ int figure_combat_get_missile_target_for_enemy(figure *enemy, int max_distance,
 
 void figure_combat_attack_figure_at(figure *f, int grid_offset);
 
+unsigned int figure_combat_attacks_started(void);
+
 #endif // FIGURE_COMBAT_H
@@ -203,6 +203,7 @@ void figure_delete(figure *f)
     int figure_id = f->id;
     memset(f, 0, sizeof(figure));
     f->id = figure_id;
+    array_mark_item_free(data.figures, figure_id);
 
     array_trim(data.figures);
 }
@@ -243,6 +244,7 @@ void figure_init_scenario(void)
         !array_next(data.figures)) { // Ignore first figure
         log_error("Unable to create figures array. The game will now crash.", 0, 0);
     }
+    array_track_free_slots(data.figures);
     data.created_sequence = 0;
 }
 
@@ -522,6 +524,7 @@ void figure_save_state(buffer *list, buffer *seq)
 
     int buf_size = 4 + data.figures.size * FIGURE_CURRENT_BUFFER_SIZE;
     uint8_t *buf_data = malloc(buf_size);
+    memset(buf_data, 0, buf_size);
     buffer_init(list, buf_data, buf_size);
     buffer_write_i32(list, FIGURE_CURRENT_BUFFER_SIZE);
 
@@ -561,4 +564,5 @@ void figure_load_state(buffer *list, buffer *seq, int version)
         }
     }
     data.figures.size = highest_id_in_use + 1;
+    array_track_free_slots(data.figures);
 }
@@ -133,8 +133,8 @@ void formation_legion_move_to(formation *m, const map_tile *tile)
     m->is_at_fort = 0;
     m->target_formation_id = 0;
 
-    int figure_id = map_figure_at(tile->grid_offset);
-    while (figure_id) {
+    int figure_id;
+    for (int i = 0; (figure_id = map_figure_at_index(tile->grid_offset, i)) != 0; i++) {
         figure *f = figure_get(figure_id);
         if (f->formation_id) {
             formation *l = formation_get(f->formation_id);
@@ -143,8 +143,6 @@ void formation_legion_move_to(formation *m, const map_tile *tile)
                 break;
             }
         }
-
-        figure_id = f->next_figure_id_on_same_tile;
     }
 
     if (m->morale <= 20) {
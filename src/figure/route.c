@@ -1,12 +1,26 @@
 #include "route.h"
 
 #include "core/array.h"
+#include "core/config.h"
 #include "core/log.h"
+#include "figure/action.h"
+#include "figure/combat.h"
+#include "game/profiler.h"
+#include "game/system.h"
+#include "map/grid.h"
 #include "map/routing.h"
+#include "map/routing_cache.h"
 #include "map/routing_path.h"
+#include "map/routing_terrain.h"
+
+#include <string.h>
 
 #define ARRAY_SIZE_STEP 600
 #define MAX_PATH_LENGTH 500
+#define MAX_PLANNED_ROUTES 256
+#define MAX_WORKERS 16
+#define PLAN_FROM_PROGRESS_ON_TILE 11
+#define MAX_SHARED_ROUTES 512
 
 typedef struct {
     unsigned int id;
@@ -16,6 +30,59 @@ typedef struct {
 
 static array(figure_path_data) paths;
 
+// Routes of citizens that are about to ask for one, searched for on worker threads before the
+// figures act. A planned route is only used when the figure still asks for the same route and the
+// terrain has not changed, so the result is the same as searching for it when the figure acts.
+// Planned routes are kept until the terrain changes, since asking again gives the same result.
+typedef struct {
+    int figure_id;
+    int is_planned;
+    int x;
+    int y;
+    int destination_x;
+    int destination_y;
+    int terrain_usage;
+    int direction_limit;
+    int path_length;
+    int routes_calculated;
+    uint8_t directions[MAX_PATH_LENGTH];
+} planned_route;
+
+static struct {
+    planned_route lists[2][MAX_PLANNED_ROUTES];
+    planned_route *routes;
+    int num_routes;
+    unsigned int terrain_version;
+    unsigned int attacks_started;
+    int goal_directed;
+    map_routing_context *contexts[MAX_WORKERS];
+    int num_workers;
+} planned;
+
+// Citizen routes that were handed out recently, so that figures asking for the same route, such as
+// the cart pushers of a workshop going to the same warehouse, get a copy instead of searching again.
+// Like planned routes, shared routes are only valid while the terrain does not change. Routes that
+// may go over land are only shared while no friendly soldier is fighting, since those block the way.
+typedef struct {
+    int in_use;
+    int source_offset;
+    int destination_offset;
+    int terrain_usage;
+    int direction_limit;
+    int path_length;
+    int routes_calculated;
+    uint8_t directions[MAX_PATH_LENGTH];
+} shared_route;
+
+static struct {
+    shared_route routes[MAX_SHARED_ROUTES];
+    int is_valid;
+    int allow_land_routes; // -1 when not yet checked
+    unsigned int terrain_version;
+    unsigned int attacks_started;
+    int goal_directed;
+} shared;
+
 static void create_new_path(figure_path_data *path, unsigned int position)
 {
     path->id = position;
@@ -47,6 +114,273 @@ void figure_route_clean(void)
     array_trim(paths);
 }
 
+static int uses_citizen_routing(const figure *f)
+{
+    switch (f->terrain_usage) {
+        case TERRAIN_USAGE_ENEMY:
+        case TERRAIN_USAGE_WALLS:
+        case TERRAIN_USAGE_ANIMAL:
+            return 0;
+        default:
+            return 1;
+    }
+}
+
+static int may_route_over_land(int terrain_usage)
+{
+    return terrain_usage != TERRAIN_USAGE_ROADS && terrain_usage != TERRAIN_USAGE_ROADS_HIGHWAY;
+}
+
+static int get_direction_limit(const figure *f)
+{
+    return f->disallow_diagonal ? 4 : 8;
+}
+
+static int plans_are_current(void)
+{
+    return planned.terrain_version == map_routing_citizen_version() &&
+        planned.attacks_started == figure_combat_attacks_started() &&
+        planned.goal_directed == config_get(CONFIG_GP_CH_GOAL_DIRECTED_ROUTING);
+}
+
+static planned_route *find_planned_route(planned_route *routes, int num_routes, int figure_id)
+{
+    int low = 0;
+    int high = num_routes - 1;
+    while (low <= high) {
+        int middle = (low + high) / 2;
+        if (routes[middle].figure_id == figure_id) {
+            return &routes[middle];
+        } else if (routes[middle].figure_id < figure_id) {
+            low = middle + 1;
+        } else {
+            high = middle - 1;
+        }
+    }
+    return 0;
+}
+
+static int is_same_request(const planned_route *route, const figure *f)
+{
+    return route->x == f->x && route->y == f->y &&
+        route->destination_x == f->destination_x && route->destination_y == f->destination_y &&
+        route->terrain_usage == f->terrain_usage && route->direction_limit == get_direction_limit(f);
+}
+
+static int is_roaming_freely(const figure *f)
+{
+    return f->roam_choose_destination && f->roam_length < f->max_roam_length;
+}
+
+static int is_route_candidate(const figure *f, int allow_land_routes)
+{
+    // walkers ask for a route when they reach the end of a tile, so only plan for those about to
+    return f->state == FIGURE_STATE_ALIVE && f->progress_on_tile >= PLAN_FROM_PROGRESS_ON_TILE &&
+        !is_roaming_freely(f) && !f->is_boat && f->routing_path_id <= 0 &&
+        !f->use_cross_country && f->action_state != FIGURE_ACTION_125_ROAMING &&
+        f->action_state != FIGURE_ACTION_149_CORPSE && f->action_state != FIGURE_ACTION_150_ATTACK &&
+        uses_citizen_routing(f) && (allow_land_routes || !may_route_over_land(f->terrain_usage)) &&
+        map_grid_is_inside(f->x, f->y, 1) && map_grid_is_inside(f->destination_x, f->destination_y, 1) &&
+        (f->x != f->destination_x || f->y != f->destination_y);
+}
+
+static int has_fighting_friendly(void)
+{
+    for (int i = 1; i < figure_count(); i++) {
+        const figure *f = figure_get(i);
+        if (f->state == FIGURE_STATE_ALIVE && f->is_friendly && f->action_state == FIGURE_ACTION_150_ATTACK) {
+            return 1;
+        }
+    }
+    return map_routing_has_cached_fighting_friendly();
+}
+
+static void plan_route(map_routing_context *context, planned_route *route)
+{
+    int can_travel;
+    switch (route->terrain_usage) {
+        case TERRAIN_USAGE_PREFER_ROADS:
+            can_travel = map_routing_context_citizen_can_travel_over_road_garden(context, route->x, route->y,
+                route->destination_x, route->destination_y, route->direction_limit);
+            if (!can_travel) {
+                can_travel = map_routing_context_citizen_can_travel_over_land(context, route->x, route->y,
+                    route->destination_x, route->destination_y, route->direction_limit);
+            }
+            break;
+        case TERRAIN_USAGE_ROADS:
+            can_travel = map_routing_context_citizen_can_travel_over_road_garden(context, route->x, route->y,
+                route->destination_x, route->destination_y, route->direction_limit);
+            break;
+        case TERRAIN_USAGE_PREFER_ROADS_HIGHWAY:
+            can_travel = map_routing_context_citizen_can_travel_over_road_garden_highway(context, route->x, route->y,
+                route->destination_x, route->destination_y, route->direction_limit);
+            if (!can_travel) {
+                can_travel = map_routing_context_citizen_can_travel_over_land(context, route->x, route->y,
+                    route->destination_x, route->destination_y, route->direction_limit);
+            }
+            break;
+        case TERRAIN_USAGE_ROADS_HIGHWAY:
+            can_travel = map_routing_context_citizen_can_travel_over_road_garden_highway(context, route->x, route->y,
+                route->destination_x, route->destination_y, route->direction_limit);
+            break;
+        default:
+            can_travel = map_routing_context_citizen_can_travel_over_land(context, route->x, route->y,
+                route->destination_x, route->destination_y, route->direction_limit);
+            break;
+    }
+    route->path_length = can_travel ? map_routing_context_get_path(context, route->directions,
+        route->destination_x, route->destination_y, route->direction_limit) : 0;
+    route->routes_calculated = map_routing_context_take_routes_calculated(context);
+    route->is_planned = 1;
+}
+
+static void plan_routes_on_worker(int worker_id, void *userdata)
+{
+    for (int i = worker_id; i < planned.num_routes; i += planned.num_workers) {
+        if (!planned.routes[i].is_planned) {
+            plan_route(planned.contexts[worker_id], &planned.routes[i]);
+        }
+    }
+}
+
+void figure_route_plan_ahead(void)
+{
+    planned.num_workers = system_get_num_workers();
+    if (planned.num_workers <= 1) {
+        return;
+    }
+    if (planned.num_workers > MAX_WORKERS) {
+        planned.num_workers = MAX_WORKERS;
+    }
+    planned_route *previous_routes = planned.routes;
+    int num_previous_routes = plans_are_current() ? planned.num_routes : 0;
+    planned.routes = previous_routes == planned.lists[0] ? planned.lists[1] : planned.lists[0];
+    planned.num_routes = 0;
+    planned.terrain_version = map_routing_citizen_version();
+    planned.attacks_started = figure_combat_attacks_started();
+    planned.goal_directed = config_get(CONFIG_GP_CH_GOAL_DIRECTED_ROUTING);
+
+    int allow_land_routes = !has_fighting_friendly();
+    int needs_planning = 0;
+    for (int i = 1; i < figure_count() && planned.num_routes < MAX_PLANNED_ROUTES; i++) {
+        const figure *f = figure_get(i);
+        if (!is_route_candidate(f, allow_land_routes)) {
+            continue;
+        }
+        planned_route *route = &planned.routes[planned.num_routes++];
+        planned_route *previous = find_planned_route(previous_routes, num_previous_routes, f->id);
+        if (previous && previous->is_planned && is_same_request(previous, f)) {
+            memcpy(route, previous, sizeof(planned_route));
+            continue;
+        }
+        route->figure_id = f->id;
+        route->is_planned = 0;
+        route->x = f->x;
+        route->y = f->y;
+        route->destination_x = f->destination_x;
+        route->destination_y = f->destination_y;
+        route->terrain_usage = f->terrain_usage;
+        route->direction_limit = get_direction_limit(f);
+        needs_planning = 1;
+    }
+    if (!needs_planning) {
+        return;
+    }
+    for (int i = 0; i < planned.num_workers; i++) {
+        if (!planned.contexts[i]) {
+            planned.contexts[i] = map_routing_context_create();
+            if (!planned.contexts[i]) {
+                planned.num_routes = 0;
+                return;
+            }
+        }
+    }
+    map_routing_cache_update_regions();
+    system_run_on_workers(plan_routes_on_worker, 0);
+}
+
+static int use_planned_route(const figure *f, int direction_limit, uint8_t *directions)
+{
+    if (!planned.num_routes || !plans_are_current()) {
+        return -1;
+    }
+    planned_route *route = find_planned_route(planned.routes, planned.num_routes, f->id);
+    if (!route || !route->is_planned || !is_same_request(route, f) || route->direction_limit != direction_limit) {
+        return -1;
+    }
+    memcpy(directions, route->directions, route->path_length);
+    map_routing_add_routes_calculated(route->routes_calculated);
+    return route->path_length;
+}
+
+static int shared_routes_are_current(void)
+{
+    return shared.is_valid && shared.terrain_version == map_routing_citizen_version() &&
+        shared.attacks_started == figure_combat_attacks_started() &&
+        shared.goal_directed == config_get(CONFIG_GP_CH_GOAL_DIRECTED_ROUTING);
+}
+
+static int can_share_route(const figure *f)
+{
+    if (!shared_routes_are_current()) {
+        for (int i = 0; i < MAX_SHARED_ROUTES; i++) {
+            shared.routes[i].in_use = 0;
+        }
+        shared.is_valid = 1;
+        shared.allow_land_routes = -1;
+        shared.terrain_version = map_routing_citizen_version();
+        shared.attacks_started = figure_combat_attacks_started();
+        shared.goal_directed = config_get(CONFIG_GP_CH_GOAL_DIRECTED_ROUTING);
+    }
+    if (!may_route_over_land(f->terrain_usage)) {
+        return 1;
+    }
+    if (shared.allow_land_routes < 0) {
+        shared.allow_land_routes = !has_fighting_friendly();
+    }
+    return shared.allow_land_routes;
+}
+
+static shared_route *get_shared_route(const figure *f, int direction_limit)
+{
+    unsigned int source_offset = map_grid_offset(f->x, f->y);
+    unsigned int destination_offset = map_grid_offset(f->destination_x, f->destination_y);
+    unsigned int hash = (source_offset * 31 + destination_offset) * 8 + f->terrain_usage + direction_limit;
+    return &shared.routes[hash % MAX_SHARED_ROUTES];
+}
+
+static int is_shared_route_for(const shared_route *route, const figure *f, int direction_limit)
+{
+    return route->in_use && route->source_offset == map_grid_offset(f->x, f->y) &&
+        route->destination_offset == map_grid_offset(f->destination_x, f->destination_y) &&
+        route->terrain_usage == f->terrain_usage && route->direction_limit == direction_limit;
+}
+
+static int use_shared_route(const figure *f, int direction_limit, uint8_t *directions)
+{
+    shared_route *route = get_shared_route(f, direction_limit);
+    if (!is_shared_route_for(route, f, direction_limit)) {
+        return -1;
+    }
+    memcpy(directions, route->directions, route->path_length);
+    map_routing_add_routes_calculated(route->routes_calculated);
+    return route->path_length;
+}
+
+static void share_route(const figure *f, int direction_limit, const uint8_t *directions, int path_length,
+    int routes_calculated)
+{
+    shared_route *route = get_shared_route(f, direction_limit);
+    route->in_use = 1;
+    route->source_offset = map_grid_offset(f->x, f->y);
+    route->destination_offset = map_grid_offset(f->destination_x, f->destination_y);
+    route->terrain_usage = f->terrain_usage;
+    route->direction_limit = direction_limit;
+    route->path_length = path_length;
+    route->routes_calculated = routes_calculated;
+    memcpy(route->directions, directions, path_length);
+}
+
 void figure_route_add(figure *f)
 {
     f->routing_path_id = 0;
@@ -65,8 +399,26 @@ void figure_route_add(figure *f)
     if (!path) {
         return;
     }
-    int path_length;
-    if (f->is_boat) {
+    int path_length = -1;
+    int is_shareable = !f->is_boat && uses_citizen_routing(f) && can_share_route(f);
+    int routes_calculated = map_routing_get_routes_calculated();
+    if (is_shareable) {
+        path_length = use_shared_route(f, direction_limit, path->directions);
+        if (path_length >= 0) {
+            game_profiler_count_route(PROFILER_ROUTE_SHARED);
+            is_shareable = 0;
+        }
+    }
+    if (path_length < 0 && !f->is_boat && uses_citizen_routing(f)) {
+        path_length = use_planned_route(f, direction_limit, path->directions);
+        if (path_length >= 0) {
+            game_profiler_count_route(PROFILER_ROUTE_PLANNED);
+        }
+    }
+    if (path_length >= 0) {
+        // the route was shared or planned ahead
+    } else if (f->is_boat) {
+        game_profiler_count_route(PROFILER_ROUTE_SEARCHED);
         if (f->is_boat == 2) { // flotsam
             map_routing_calculate_distances_water_flotsam(f->x, f->y);
             path_length = map_routing_get_path_on_water(path->directions,
@@ -78,6 +430,7 @@ void figure_route_add(figure *f)
         }
     } else {
         // land figure
+        game_profiler_count_route(PROFILER_ROUTE_SEARCHED);
         int can_travel;
         switch (f->terrain_usage) {
             case TERRAIN_USAGE_ENEMY:
@@ -145,6 +498,10 @@ void figure_route_add(figure *f)
             path_length = 0;
         }
     }
+    if (is_shareable) {
+        share_route(f, direction_limit, path->directions, path_length,
+            map_routing_get_routes_calculated() - routes_calculated);
+    }
     if (path_length) {
         path->figure_id = f->id;
         f->routing_path_id = path->id;
@@ -172,6 +529,7 @@ void figure_route_save_state(buffer *figures, buffer *buf_paths)
 {
     int size = paths.size * sizeof(int);
     uint8_t *buf_data = malloc(size);
+    memset(buf_data, 0, size);
     buffer_init(figures, buf_data, size);
 
     size = paths.size * sizeof(uint8_t) * MAX_PATH_LENGTH;
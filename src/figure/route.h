@@ -8,6 +8,8 @@ void figure_route_clear_all(void);
 
 void figure_route_clean(void);
 
+void figure_route_plan_ahead(void);
+
 void figure_route_add(figure *f);
 
 void figure_route_remove(figure *f);
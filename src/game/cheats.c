@@ -10,11 +10,13 @@
 #include "city/sentiment.h"
 #include "city/victory.h"
 #include "city/warning.h"
+#include "core/dir.h"
 #include "core/lang.h"
 #include "core/string.h"
 #include "empire/city.h"
 #include "figure/figure.h"
 #include "figuretype/crime.h"
+#include "game/profiler.h"
 #include "game/tick.h"
 #include "graphics/color.h"
 #include "graphics/font.h"
@@ -55,6 +57,8 @@ static void game_cheat_unlock_legions(uint8_t *);
 static void game_cheat_disable_legions_consumption(uint8_t *);
 static void game_cheat_disable_invasions(uint8_t *);
 static void game_cheat_change_weather(uint8_t *);
+static void game_cheat_toggle_profiler(uint8_t *);
+static void game_cheat_dump_profiler(uint8_t *);
 
 static void (*const execute_command[])(uint8_t *args) = {
     game_cheat_add_money,
@@ -76,6 +80,8 @@ static void (*const execute_command[])(uint8_t *args) = {
     game_cheat_disable_legions_consumption,
     game_cheat_disable_invasions,
     game_cheat_change_weather,
+    game_cheat_toggle_profiler,
+    game_cheat_dump_profiler,
 };
 
 static const char *commands[] = {
@@ -97,7 +103,9 @@ static const char *commands[] = {
     "ihaveanarmy",
     "breadandfish",
     "leavemealone",
-    "weather"
+    "weather",
+    "debug.profiler",
+    "debug.profilerdump"
 };
 
 #define NUMBER_OF_COMMANDS sizeof (commands) / sizeof (commands[0])
@@ -350,6 +358,17 @@ static void game_cheat_change_weather(uint8_t *args)
     show_warning(TR_CHEAT_CHANGE_WEATHER);
 }
 
+static void game_cheat_toggle_profiler(uint8_t *args)
+{
+    game_profiler_set_enabled(!game_profiler_is_enabled());
+}
+
+static void game_cheat_dump_profiler(uint8_t *args)
+{
+    game_profiler_write_csv(dir_append_location("profiler.csv", PATH_LOCATION_ROOT));
+    game_profiler_write_json(dir_append_location("profiler.json", PATH_LOCATION_ROOT));
+}
+
 void game_cheat_parse_command(uint8_t *command)
 {
     uint8_t command_to_call[MAX_COMMAND_SIZE];
@@ -281,6 +281,8 @@ static void initialize_saved_game(void)
 
     map_orientation_update_buildings();
     figure_route_clean();
+    // the largest road networks were loaded from the save and may be outdated
+    map_road_network_clear();
     map_road_network_update();
     map_routing_update_land();
     building_maintenance_check_rome_access();
@@ -477,7 +479,10 @@ int game_file_make_yearly_autosave(void)
         platform_file_manager_get_directory_for_location(PATH_LOCATION_SAVEGAME, 0), "autosave-year-bak-",
         next_autosave_slot, ".svx");
 
-    platform_file_manager_copy_file(current_save_name, backup_save_name);
+    // don't replace a good backup with a saved game that could not be written
+    if (game_file_io_finish_writing_saved_game()) {
+        platform_file_manager_copy_file(current_save_name, backup_save_name);
+    }
     game_file_write_saved_game(current_save_name);
 
     next_autosave_slot++;
@@ -36,8 +36,10 @@ int game_file_load_saved_game(const char *filename);
 
 /**
  * Write saved game to disk
+ * The file is written in the background: use game_file_io_finish_writing_saved_game
+ * to wait for it and to know whether it could be written
  * @param filename File to save to
- * @return Boolean true on success, false on failure
+ * @return Boolean true if the file is being written, false on failure
  */
 int game_file_write_saved_game(const char *filename);
 
@@ -10,6 +10,7 @@
 #include "city/data.h"
 #include "city/message.h"
 #include "city/view.h"
+#include "core/config.h"
 #include "core/dir.h"
 #include "core/file.h"
 #include "core/log.h"
@@ -31,6 +32,7 @@
 #include "figure/visited_buildings.h"
 #include "game/file.h"
 #include "game/save_version.h"
+#include "game/system.h"
 #include "game/time.h"
 #include "game/tutorial.h"
 #include "map/aqueduct.h"
@@ -73,6 +75,14 @@
 #define COMPRESS_BUFFER_INITIAL_SIZE 1000000
 #define UNCOMPRESSED 0x80000000
 #define PIECE_SIZE_DYNAMIC 0
+#define MAX_SAVE_WORKERS 16
+
+// The fast save format stores the pieces uncompressed, preceded by a table with the offset and size of each
+// piece, so they can be read directly or skipped. The signature makes older versions reject the file.
+#define FAST_SAVE_SIGNATURE "AUGFAST1"
+#define FAST_SAVE_SIGNATURE_SIZE 8
+#define FAST_SAVE_HEADER_SIZE (FAST_SAVE_SIGNATURE_SIZE + 12)
+#define FAST_SAVE_TABLE_ENTRY_SIZE 8
 
 typedef struct {
     buffer buf;
@@ -996,13 +1006,13 @@ static int read_int32(FILE *fp)
     return buffer_read_i32(&buf);
 }
 
-static void write_int32(FILE *fp, int value)
+static int write_int32(FILE *fp, int value)
 {
     uint8_t data[4];
     buffer buf;
     buffer_init(&buf, data, 4);
     buffer_write_i32(&buf, value);
-    fwrite(&data, 1, 4, fp);
+    return fwrite(&data, 1, 4, fp) == 4;
 }
 
 static int read_compressed_chunk_from_buffer(buffer *buf, void *dst, size_t bytes_to_read, int read_as_zlib,
@@ -1427,24 +1437,286 @@ static int savegame_read_from_file(FILE *fp, savegame_version_t version)
     return 1;
 }
 
-static void savegame_write_to_file(FILE *fp, memory_block *compress_buffer)
+static int is_needed_for_info(const buffer *buf)
+{
+    const savegame_state *state = &savegame_data.state;
+    const buffer *info_pieces[] = {
+        state->scenario_campaign_mission, state->file_version, state->scenario_version, state->scenario_is_custom,
+        state->scenario_name, state->campaign_name, state->scenario, state->invasions, state->city_data,
+        state->game_time, state->terrain_grid, state->edge_grid, state->bitfields_grid, state->random_grid,
+        state->building_grid, state->buildings
+    };
+    for (int i = 0; i < sizeof(info_pieces) / sizeof(buffer *); i++) {
+        if (info_pieces[i] == buf) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int prepare_fast_piece(file_piece *piece, int size)
+{
+    if (!piece->dynamic) {
+        return size == (int) piece->buf.size;
+    }
+    if (size > 0) {
+        uint8_t *data = malloc(size);
+        if (!data) {
+            return 0;
+        }
+        memset(data, 0, size);
+        buffer_init(&piece->buf, data, size);
+    }
+    return size >= 0;
+}
+
+static int fast_piece_is_in_file(int offset, int size, int header_size, long file_size)
+{
+    return offset >= header_size && size >= 0 && offset <= file_size && size <= file_size - offset;
+}
+
+static int read_fast_save_table_size(buffer *header)
 {
+    buffer_skip(header, FAST_SAVE_HEADER_SIZE - 4);
+    if (buffer_read_i32(header) != savegame_data.num_pieces) {
+        return 0;
+    }
+    return savegame_data.num_pieces * FAST_SAVE_TABLE_ENTRY_SIZE;
+}
+
+static int savegame_read_fast_from_buffer(buffer *buf, int info_only)
+{
+    int table_size = read_fast_save_table_size(buf);
+    if (!table_size || buf->index + table_size > buf->size) {
+        return 0;
+    }
+    int header_size = buf->index + table_size;
+    buffer table;
+    buffer_init(&table, &buf->data[buf->index], table_size);
     for (int i = 0; i < savegame_data.num_pieces; i++) {
         file_piece *piece = &savegame_data.pieces[i];
-        if (piece->dynamic) {
-            write_int32(fp, (int) piece->buf.size);
-            if (!piece->buf.size) {
-                continue;
+        int offset = buffer_read_i32(&table);
+        int size = buffer_read_i32(&table);
+        if (!fast_piece_is_in_file(offset, size, header_size, buf->size) || !prepare_fast_piece(piece, size)) {
+            return 0;
+        }
+        if (!piece->buf.size || (info_only && !is_needed_for_info(&piece->buf))) {
+            continue;
+        }
+        buffer_set(buf, offset);
+        if (buffer_read_raw(buf, piece->buf.data, size) != size) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int savegame_read_fast_from_file(FILE *fp, int info_only)
+{
+    static uint8_t header[FAST_SAVE_HEADER_SIZE +
+        (sizeof(savegame_state) / sizeof(buffer *) + 1) * FAST_SAVE_TABLE_ENTRY_SIZE];
+    long start = ftell(fp);
+    if (start < 0 || fseek(fp, 0, SEEK_END)) {
+        return 0;
+    }
+    long file_size = ftell(fp) - start;
+    if (fseek(fp, start, SEEK_SET) || fread(header, 1, FAST_SAVE_HEADER_SIZE, fp) != FAST_SAVE_HEADER_SIZE) {
+        return 0;
+    }
+    buffer buf;
+    buffer_init(&buf, header, FAST_SAVE_HEADER_SIZE);
+    int table_size = read_fast_save_table_size(&buf);
+    if (!table_size || fread(&header[FAST_SAVE_HEADER_SIZE], 1, table_size, fp) != table_size) {
+        return 0;
+    }
+    int header_size = FAST_SAVE_HEADER_SIZE + table_size;
+    buffer_init(&buf, &header[FAST_SAVE_HEADER_SIZE], table_size);
+    for (int i = 0; i < savegame_data.num_pieces; i++) {
+        file_piece *piece = &savegame_data.pieces[i];
+        int offset = buffer_read_i32(&buf);
+        int size = buffer_read_i32(&buf);
+        if (!fast_piece_is_in_file(offset, size, header_size, file_size) || !prepare_fast_piece(piece, size)) {
+            return 0;
+        }
+        if (!piece->buf.size || (info_only && !is_needed_for_info(&piece->buf))) {
+            continue;
+        }
+        if (fseek(fp, start + offset, SEEK_SET) || fread(piece->buf.data, 1, size, fp) != size) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// A saved game is written in two steps: the pieces are compressed in parallel on the worker threads,
+// after which a background thread writes them to the file one by one while the game continues.
+// The file is closed on the main thread once the background thread is done.
+typedef struct {
+    void *data;
+    int size;
+    int dynamic;
+    int compressed;
+    int compressed_size;
+    int worker;
+} saved_piece;
+
+static struct {
+    int fast_format;
+    int write_failed;
+    FILE *fp;
+    int num_pieces;
+    saved_piece pieces[sizeof(savegame_state) / sizeof(buffer *) + 1];
+} pending_save;
+
+static void compress_saved_piece(saved_piece *piece)
+{
+    // only keep the compressed data when it is smaller
+    void *compressed = malloc(piece->size);
+    int output_size = 0;
+    if (compressed && zlib_helper_compress(piece->data, piece->size, compressed, piece->size, &output_size)) {
+        free(piece->data);
+        piece->data = compressed;
+        piece->compressed_size = output_size;
+    } else {
+        free(compressed);
+        piece->compressed_size = UNCOMPRESSED;
+    }
+}
+
+static void compress_saved_pieces_on_worker(int worker_id, void *userdata)
+{
+    for (int i = 0; i < pending_save.num_pieces; i++) {
+        saved_piece *piece = &pending_save.pieces[i];
+        if (piece->worker == worker_id && piece->compressed && piece->size) {
+            compress_saved_piece(piece);
+        }
+    }
+}
+
+static void assign_saved_pieces_to_workers(int num_workers)
+{
+    static int by_size[sizeof(savegame_state) / sizeof(buffer *) + 1];
+    int64_t load[MAX_SAVE_WORKERS] = { 0 };
+    for (int i = 0; i < pending_save.num_pieces; i++) {
+        by_size[i] = i;
+    }
+    // largest pieces first, each to the worker with the least work so far
+    for (int i = 1; i < pending_save.num_pieces; i++) {
+        int index = by_size[i];
+        int j = i;
+        for (; j > 0 && pending_save.pieces[by_size[j - 1]].size < pending_save.pieces[index].size; j--) {
+            by_size[j] = by_size[j - 1];
+        }
+        by_size[j] = index;
+    }
+    for (int i = 0; i < pending_save.num_pieces; i++) {
+        saved_piece *piece = &pending_save.pieces[by_size[i]];
+        int worker = 0;
+        for (int w = 1; w < num_workers; w++) {
+            if (load[w] < load[worker]) {
+                worker = w;
             }
         }
+        piece->worker = worker;
         if (piece->compressed) {
-            write_compressed_chunk(fp, piece->buf.data, piece->buf.size, compress_buffer);
-        } else {
-            fwrite(piece->buf.data, 1, piece->buf.size, fp);
+            load[worker] += piece->size;
         }
     }
 }
 
+static void take_savegame_pieces(void)
+{
+    pending_save.num_pieces = savegame_data.num_pieces;
+    for (int i = 0; i < savegame_data.num_pieces; i++) {
+        file_piece *piece = &savegame_data.pieces[i];
+        saved_piece *saved = &pending_save.pieces[i];
+        saved->data = piece->buf.data;
+        saved->size = (int) piece->buf.size;
+        saved->dynamic = piece->dynamic;
+        saved->compressed = piece->compressed;
+        saved->compressed_size = UNCOMPRESSED;
+        piece->buf.data = 0;
+    }
+    clear_savegame_pieces();
+}
+
+static int write_fast_save_header(FILE *fp)
+{
+    static uint8_t header[FAST_SAVE_HEADER_SIZE +
+        (sizeof(savegame_state) / sizeof(buffer *) + 1) * FAST_SAVE_TABLE_ENTRY_SIZE];
+    int header_size = FAST_SAVE_HEADER_SIZE + pending_save.num_pieces * FAST_SAVE_TABLE_ENTRY_SIZE;
+    buffer buf;
+    buffer_init(&buf, header, header_size);
+    buffer_write_raw(&buf, FAST_SAVE_SIGNATURE, FAST_SAVE_SIGNATURE_SIZE);
+    buffer_write_i32(&buf, SAVE_GAME_CURRENT_VERSION);
+    buffer_write_i32(&buf, RESOURCE_CURRENT_VERSION);
+    buffer_write_i32(&buf, pending_save.num_pieces);
+    int offset = header_size;
+    for (int i = 0; i < pending_save.num_pieces; i++) {
+        buffer_write_i32(&buf, offset);
+        buffer_write_i32(&buf, pending_save.pieces[i].size);
+        offset += pending_save.pieces[i].size;
+    }
+    return (int) fwrite(header, 1, header_size, fp) == header_size;
+}
+
+static int write_saved_piece(FILE *fp, const saved_piece *piece)
+{
+    if (pending_save.fast_format) {
+        return (int) fwrite(piece->data, 1, piece->size, fp) == piece->size;
+    }
+    if (piece->dynamic && !write_int32(fp, piece->size)) {
+        return 0;
+    }
+    if (!piece->size) {
+        return 1;
+    }
+    if (piece->compressed && !write_int32(fp, piece->compressed_size)) {
+        return 0;
+    }
+    int size = (unsigned int) piece->compressed_size == UNCOMPRESSED ? piece->size : piece->compressed_size;
+    return (int) fwrite(piece->data, 1, size, fp) == size;
+}
+
+static void write_saved_pieces(void *userdata)
+{
+    FILE *fp = pending_save.fp;
+    int ok = !pending_save.fast_format || write_fast_save_header(fp);
+    for (int i = 0; i < pending_save.num_pieces; i++) {
+        saved_piece *piece = &pending_save.pieces[i];
+        if (ok) {
+            ok = write_saved_piece(fp, piece);
+        }
+        free(piece->data);
+        piece->data = 0;
+    }
+    // flush here so the main thread only has to close the file
+    if (fflush(fp) != 0) {
+        ok = 0;
+    }
+    pending_save.num_pieces = 0;
+    pending_save.write_failed = !ok;
+}
+
+static void close_saved_game(void *userdata)
+{
+    if (!file_close(pending_save.fp)) {
+        pending_save.write_failed = 1;
+    }
+    pending_save.fp = 0;
+    if (pending_save.write_failed) {
+        log_error("Unable to write saved game to disk", 0, 0);
+    }
+}
+
+int game_file_io_finish_writing_saved_game(void)
+{
+    system_wait_for_background_task();
+    int result = !pending_save.write_failed;
+    pending_save.write_failed = 0;
+    return result;
+}
+
 static int get_savegame_versions_from_buffer(buffer *buf, savegame_version_t *save_version,
     resource_version_t *resource_version)
 {
@@ -1486,12 +1758,44 @@ static int get_savegame_versions(FILE *fp, savegame_version_t *save_version, res
     return 1;
 }
 
+static int get_fast_savegame_versions_from_buffer(buffer *buf, savegame_version_t *save_version,
+    resource_version_t *resource_version)
+{
+    if (buf->size < FAST_SAVE_HEADER_SIZE || memcmp(buf->data, FAST_SAVE_SIGNATURE, FAST_SAVE_SIGNATURE_SIZE) != 0) {
+        return 0;
+    }
+    buffer_set(buf, FAST_SAVE_SIGNATURE_SIZE);
+    *save_version = buffer_read_i32(buf);
+    *resource_version = buffer_read_i32(buf);
+    buffer_reset(buf);
+    return 1;
+}
+
+static int get_fast_savegame_versions(FILE *fp, savegame_version_t *save_version,
+    resource_version_t *resource_version)
+{
+    uint8_t header[FAST_SAVE_HEADER_SIZE];
+    long start = ftell(fp);
+    int is_fast_save = fread(header, 1, FAST_SAVE_HEADER_SIZE, fp) == FAST_SAVE_HEADER_SIZE &&
+        memcmp(header, FAST_SAVE_SIGNATURE, FAST_SAVE_SIGNATURE_SIZE) == 0;
+    if (fseek(fp, start, SEEK_SET) || !is_fast_save) {
+        return 0;
+    }
+    buffer buf;
+    buffer_init(&buf, header, FAST_SAVE_HEADER_SIZE);
+    buffer_skip(&buf, FAST_SAVE_SIGNATURE_SIZE);
+    *save_version = buffer_read_i32(&buf);
+    *resource_version = buffer_read_i32(&buf);
+    return 1;
+}
+
 int game_file_io_read_save_game_from_buffer(buffer *buf)
 {
     int result = 0;
     savegame_version_t save_version;
     resource_version_t resource_version;
-    if (get_savegame_versions_from_buffer(buf, &save_version, &resource_version)) {
+    int is_fast_save = get_fast_savegame_versions_from_buffer(buf, &save_version, &resource_version);
+    if (is_fast_save || get_savegame_versions_from_buffer(buf, &save_version, &resource_version)) {
         if (save_version > SAVE_GAME_CURRENT_VERSION || resource_version > RESOURCE_CURRENT_VERSION) {
             log_error("Newer save game version than supported. Please update Augustus. Version:", 0, save_version);
             return FILE_LOAD_INCOMPATIBLE_VERSION;
@@ -1499,7 +1803,7 @@ int game_file_io_read_save_game_from_buffer(buffer *buf)
         log_info("Savegame version", 0, save_version);
         resource_set_mapping(resource_version);
         init_savegame_data(save_version);
-        result = savegame_read_from_buffer(buf, save_version);
+        result = is_fast_save ? savegame_read_fast_from_buffer(buf, 0) : savegame_read_from_buffer(buf, save_version);
     }
     if (!result) {
         log_error("Unable to load game, incompatible savefile.", 0, 0);
@@ -1512,6 +1816,7 @@ int game_file_io_read_save_game_from_buffer(buffer *buf)
 
 int game_file_io_read_saved_game(const char *filename, int offset)
 {
+    game_file_io_finish_writing_saved_game();
     log_info("Loading saved game", filename, 0);
     FILE *fp = file_open(filename, "rb");
     if (!fp) {
@@ -1524,7 +1829,8 @@ int game_file_io_read_saved_game(const char *filename, int offset)
     int result = 0;
     savegame_version_t save_version;
     resource_version_t resource_version;
-    if (get_savegame_versions(fp, &save_version, &resource_version)) {
+    int is_fast_save = get_fast_savegame_versions(fp, &save_version, &resource_version);
+    if (is_fast_save || get_savegame_versions(fp, &save_version, &resource_version)) {
         if (save_version > SAVE_GAME_CURRENT_VERSION || resource_version > RESOURCE_CURRENT_VERSION) {
             log_error("Newer save game version than supported. Please update Augustus. Version:", 0, save_version);
             file_close(fp);
@@ -1533,7 +1839,7 @@ int game_file_io_read_saved_game(const char *filename, int offset)
         log_info("Savegame version", 0, save_version);
         resource_set_mapping(resource_version);
         init_savegame_data(save_version);
-        result = savegame_read_from_file(fp, save_version);
+        result = is_fast_save ? savegame_read_fast_from_file(fp, 0) : savegame_read_from_file(fp, save_version);
     }
     file_close(fp);
     if (!result) {
@@ -1680,6 +1986,7 @@ int game_file_io_read_saved_game_info(const char *filename, int offset, saved_ga
         return SAVEGAME_STATUS_INVALID;
     }
     memset(info, 0, sizeof(saved_game_info));
+    game_file_io_finish_writing_saved_game();
     FILE *fp = file_open(filename, "rb");
     if (!fp) {
         return SAVEGAME_STATUS_INVALID;
@@ -1690,7 +1997,8 @@ int game_file_io_read_saved_game_info(const char *filename, int offset, saved_ga
     savegame_load_status result = SAVEGAME_STATUS_INVALID;
     savegame_version_t save_version;
     resource_version_t resource_version;
-    if (!get_savegame_versions(fp, &save_version, &resource_version)) {
+    int is_fast_save = get_fast_savegame_versions(fp, &save_version, &resource_version);
+    if (!is_fast_save && !get_savegame_versions(fp, &save_version, &resource_version)) {
         file_close(fp);
         return SAVEGAME_STATUS_INVALID;
     }
@@ -1700,7 +2008,7 @@ int game_file_io_read_saved_game_info(const char *filename, int offset, saved_ga
     }
     resource_set_mapping(resource_version);
     init_savegame_data(save_version);
-    result = savegame_read_from_file(fp, save_version);
+    result = is_fast_save ? savegame_read_fast_from_file(fp, 1) : savegame_read_from_file(fp, save_version);
     file_close(fp);
     if (result != SAVEGAME_STATUS_OK) {
         return FILE_LOAD_WRONG_FILE_FORMAT;
@@ -1718,7 +2026,8 @@ int game_file_io_read_saved_game_info_from_buffer(buffer *buf, saved_game_info *
     int result = 0;
     savegame_version_t save_version;
     resource_version_t resource_version;
-    if (get_savegame_versions_from_buffer(buf, &save_version, &resource_version)) {
+    int is_fast_save = get_fast_savegame_versions_from_buffer(buf, &save_version, &resource_version);
+    if (is_fast_save || get_savegame_versions_from_buffer(buf, &save_version, &resource_version)) {
         if (save_version > SAVE_GAME_CURRENT_VERSION || resource_version > RESOURCE_CURRENT_VERSION) {
             log_error("Newer save game version than supported. Please update Augustus. Version:", 0, save_version);
             return FILE_LOAD_INCOMPATIBLE_VERSION;
@@ -1726,7 +2035,7 @@ int game_file_io_read_saved_game_info_from_buffer(buffer *buf, saved_game_info *
         log_info("Savegame version", 0, save_version);
         resource_set_mapping(resource_version);
         init_savegame_data(save_version);
-        result = savegame_read_from_buffer(buf, save_version);
+        result = is_fast_save ? savegame_read_fast_from_buffer(buf, 1) : savegame_read_from_buffer(buf, save_version);
     }
     if (!result) {
         log_error("Unable to load game, incompatible savefile.", 0, 0);
@@ -1737,6 +2046,7 @@ int game_file_io_read_saved_game_info_from_buffer(buffer *buf, saved_game_info *
 
 int game_file_io_write_saved_game(const char *filename)
 {
+    game_file_io_finish_writing_saved_game();
     resource_set_mapping(RESOURCE_CURRENT_VERSION);
     init_savegame_data(SAVE_GAME_CURRENT_VERSION);
 
@@ -1746,19 +2056,45 @@ int game_file_io_write_saved_game(const char *filename)
     FILE *fp = file_open(filename, "wb");
     if (!fp) {
         log_error("Unable to save game", 0, 0);
+        clear_savegame_pieces();
         return 0;
     }
-    memory_block compress_buffer;
-    core_memory_block_init(&compress_buffer, COMPRESS_BUFFER_INITIAL_SIZE);
-    savegame_write_to_file(fp, &compress_buffer);
-    core_memory_block_free(&compress_buffer);
-    clear_savegame_pieces();
-    file_close(fp);
+    take_savegame_pieces();
+    pending_save.fast_format = config_get(CONFIG_GP_CH_FAST_SAVE_FORMAT);
+    if (!pending_save.fast_format) {
+        int num_workers = system_get_num_workers();
+        if (num_workers > MAX_SAVE_WORKERS) {
+            num_workers = MAX_SAVE_WORKERS;
+        }
+        assign_saved_pieces_to_workers(num_workers);
+        system_run_on_workers(compress_saved_pieces_on_worker, 0);
+    }
+
+    pending_save.fp = fp;
+    system_run_in_background(write_saved_pieces, close_saved_game, 0);
     return 1;
 }
 
+uint32_t game_file_io_saved_game_checksum(void)
+{
+    resource_set_mapping(RESOURCE_CURRENT_VERSION);
+    init_savegame_data(SAVE_GAME_CURRENT_VERSION);
+    savegame_save_to_state(&savegame_data.state);
+
+    uint32_t checksum = 0;
+    for (int i = 0; i < savegame_data.num_pieces; i++) {
+        file_piece *piece = &savegame_data.pieces[i];
+        if (piece->buf.size) {
+            checksum = zlib_helper_crc32(checksum, piece->buf.data, (int) piece->buf.size);
+        }
+    }
+    clear_savegame_pieces();
+    return checksum;
+}
+
 int game_file_io_delete_saved_game(const char *filename)
 {
+    game_file_io_finish_writing_saved_game();
     log_info("Deleting game", filename, 0);
     int result = file_remove(filename);
     if (!result) {
@@ -53,6 +53,10 @@ int game_file_io_read_saved_game_info_from_buffer(buffer *buf, saved_game_info *
 
 int game_file_io_write_saved_game(const char *filename);
 
+int game_file_io_finish_writing_saved_game(void);
+
+uint32_t game_file_io_saved_game_checksum(void);
+
 int game_file_io_delete_saved_game(const char *filename);
 
 #endif // GAME_FILE_IO_H
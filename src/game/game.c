@@ -18,12 +18,14 @@
 #include "game/campaign.h"
 #include "game/file.h"
 #include "game/file_editor.h"
+#include "game/file_io.h"
 #include "game/settings.h"
 #include "game/speed.h"
 #include "game/state.h"
 #include "game/tick.h"
 #include "graphics/font.h"
 #include "graphics/graphics.h"
+#include "graphics/renderer.h"
 #include "graphics/text.h"
 #include "graphics/video.h"
 #include "graphics/window.h"
@@ -39,6 +41,14 @@
 #include "window/logo.h"
 #include "window/main_menu.h"
 
+#include <stdio.h>
+
+#define FPS_DISPLAY_X 8
+#define FPS_DISPLAY_Y 24
+#define FPS_DISPLAY_WIDTH 24
+#define FPS_DISPLAY_STATISTICS_WIDTH 220
+#define FPS_DISPLAY_HEIGHT 20
+
 static void errlog(const char *msg)
 {
     log_error(msg, 0, 0);
@@ -221,19 +231,45 @@ void game_draw(void)
     sound_city_play();
 }
 
-void game_display_fps(int fps)
+static int has_draw_statistics(void)
+{
+    const graphics_renderer_interface *renderer = graphics_renderer();
+    return renderer && renderer->get_draw_statistics;
+}
+
+int game_fps_display_width(void)
 {
-    int x_offset = 8;
-    int y_offset = 24;
-    int width = 24;
-    int height = 20;
+    return FPS_DISPLAY_X + (has_draw_statistics() ? FPS_DISPLAY_STATISTICS_WIDTH : FPS_DISPLAY_WIDTH);
+}
+
+void game_display_fps(int fps, int frame_time)
+{
+    int x_offset = FPS_DISPLAY_X;
+    int y_offset = FPS_DISPLAY_Y;
+    int height = FPS_DISPLAY_HEIGHT;
+    if (!has_draw_statistics()) {
+        int width = FPS_DISPLAY_WIDTH;
+        graphics_draw_rect(x_offset, y_offset, width + 2, height + 2, COLOR_BLACK);
+        graphics_fill_rect(x_offset + 1, y_offset + 1, width, height, COLOR_WHITE);
+        text_draw_number_centered_colored(fps, x_offset, y_offset + 6, width, FONT_SMALL_PLAIN, COLOR_BLACK);
+        return;
+    }
+    int draw_calls, batched_images;
+    graphics_renderer()->get_draw_statistics(&draw_calls, &batched_images);
+    char line[100];
+    snprintf(line, sizeof(line), "%d fps  %d ms  %d draw calls  %d batched", fps, frame_time, draw_calls,
+        batched_images);
+    int width = FPS_DISPLAY_STATISTICS_WIDTH;
     graphics_draw_rect(x_offset, y_offset, width + 2, height + 2, COLOR_BLACK);
     graphics_fill_rect(x_offset + 1, y_offset + 1, width, height, COLOR_WHITE);
-    text_draw_number_centered_colored(fps, x_offset, y_offset + 6, width, FONT_SMALL_PLAIN, COLOR_BLACK);
+    text_draw((const uint8_t *) line, x_offset + 5, y_offset + 6, FONT_SMALL_PLAIN, COLOR_BLACK);
 }
 
 void game_exit(void)
 {
+    if (!game_file_io_finish_writing_saved_game()) {
+        log_error("The last saved game could not be written before exiting", 0, 0);
+    }
     video_shutdown();
     settings_save();
     config_save();
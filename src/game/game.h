@@ -13,7 +13,9 @@ void game_run(void);
 
 void game_draw(void);
 
-void game_display_fps(int fps);
+int game_fps_display_width(void);
+
+void game_display_fps(int fps, int frame_time);
 
 void game_exit_editor(void);
 
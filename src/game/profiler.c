@@ -0,0 +1,261 @@
+#include "profiler.h"
+
+#include "core/file.h"
+#include "core/lang.h"
+#include "core/log.h"
+#include "figure/type.h"
+#include "game/system.h"
+#include "graphics/color.h"
+#include "graphics/font.h"
+#include "graphics/graphics.h"
+#include "graphics/text.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define OVERLAY_SECTIONS 8
+#define OVERLAY_FIGURE_TYPES 5
+#define OVERLAY_LINE_HEIGHT 12
+
+typedef struct {
+    uint64_t total_time;
+    uint64_t max_time;
+    uint32_t calls;
+} profiler_stats;
+
+// Keep in sync with advance_tick() in game/tick.c
+static const char *SECTION_NAMES[PROFILER_SECTION_MAX] = {
+    "", "city_gods_calculate_moods", "sound_music_update", "widget_minimap_invalidate",
+    "city_emperor_update", "formation_update_all", "map_natives_check_land", "map_road_network_update",
+    "building_granaries_calculate_stocks", "city_buildings_update_plague", "", "",
+    "house_service_decay_houses_covered", "", "", "",
+    "city_resource_calculate_warehouse_stocks", "city_resource_calculate_food_stocks_and_supply_wheat", "",
+    "building_dock_update_open_water_access", "building_industry_update_production",
+    "building_maintenance_check_rome_access", "house_population_update_room", "house_population_update_migration",
+    "house_population_evict_overcrowded", "city_labor_update", "",
+    "map_water_supply_update_reservoir_fountain", "map_water_supply_update_buildings", "formation_update_all",
+    "widget_minimap_invalidate", "building_figure_generate", "city_trade_update",
+    "building_entertainment_run_shows", "building_government_distribute_treasury", "house_service_decay_culture",
+    "house_service_calculate_culture_aggregates", "map_desirability_update", "building_update_desirability",
+    "building_house_process_evolve_and_consume_goods", "building_update_state", "",
+    "city_finance_spawn_tourist", "building_maintenance_update_burning_ruins",
+    "building_maintenance_check_fire_collapse", "figure_generate_criminals", "building_industry_update_production",
+    "city_games_decrement_duration", "house_service_decay_tax_collector", "city_culture_calculate",
+    "advance_day", "figure_action_handle"
+};
+
+static const char *ROUTE_SOURCE_NAMES[PROFILER_ROUTE_MAX] = {
+    "searched", "planned", "shared"
+};
+
+static struct {
+    int enabled;
+    profiler_stats sections[PROFILER_SECTION_MAX];
+    profiler_stats figures[FIGURE_TYPE_MAX];
+    uint32_t routes[PROFILER_ROUTE_MAX];
+} data;
+
+static void add_measurement(profiler_stats *stats, uint64_t start)
+{
+    uint64_t elapsed = system_get_microseconds() - start;
+    stats->total_time += elapsed;
+    stats->calls++;
+    if (elapsed > stats->max_time) {
+        stats->max_time = elapsed;
+    }
+}
+
+void game_profiler_set_enabled(int enabled)
+{
+    if (enabled && !data.enabled) {
+        game_profiler_reset();
+    }
+    data.enabled = enabled;
+}
+
+int game_profiler_is_enabled(void)
+{
+    return data.enabled;
+}
+
+void game_profiler_reset(void)
+{
+    memset(data.sections, 0, sizeof(data.sections));
+    memset(data.figures, 0, sizeof(data.figures));
+    memset(data.routes, 0, sizeof(data.routes));
+}
+
+uint64_t game_profiler_start(void)
+{
+    return data.enabled ? system_get_microseconds() : 0;
+}
+
+void game_profiler_record_section(int section, uint64_t start)
+{
+    if (start && section >= 0 && section < PROFILER_SECTION_MAX) {
+        add_measurement(&data.sections[section], start);
+    }
+}
+
+void game_profiler_record_figure(int type, uint64_t start)
+{
+    if (start && type > FIGURE_NONE && type < FIGURE_TYPE_MAX) {
+        add_measurement(&data.figures[type], start);
+    }
+}
+
+void game_profiler_count_route(profiler_route_source source)
+{
+    if (data.enabled && source >= 0 && source < PROFILER_ROUTE_MAX) {
+        data.routes[source]++;
+    }
+}
+
+static uint64_t average(const profiler_stats *stats)
+{
+    return stats->calls ? stats->total_time / stats->calls : 0;
+}
+
+int game_profiler_write_csv(const char *filename)
+{
+    FILE *fp = file_open(filename, "w");
+    if (!fp) {
+        log_error("Unable to write profiler data to", filename, 0);
+        return 0;
+    }
+    fprintf(fp, "kind,id,name,calls,total_us,average_us,max_us\n");
+    for (int i = 0; i < PROFILER_SECTION_MAX; i++) {
+        const profiler_stats *stats = &data.sections[i];
+        if (stats->calls) {
+            fprintf(fp, "%s,%d,%s,%u,%llu,%llu,%llu\n", i < PROFILER_SECTION_NEW_DAY ? "tick_slot" : "section",
+                i, SECTION_NAMES[i], stats->calls, (unsigned long long) stats->total_time,
+                (unsigned long long) average(stats), (unsigned long long) stats->max_time);
+        }
+    }
+    for (int i = 0; i < FIGURE_TYPE_MAX; i++) {
+        const profiler_stats *stats = &data.figures[i];
+        if (stats->calls) {
+            fprintf(fp, "figure_type,%d,,%u,%llu,%llu,%llu\n", i, stats->calls,
+                (unsigned long long) stats->total_time, (unsigned long long) average(stats),
+                (unsigned long long) stats->max_time);
+        }
+    }
+    for (int i = 0; i < PROFILER_ROUTE_MAX; i++) {
+        fprintf(fp, "route,%d,%s,%u,0,0,0\n", i, ROUTE_SOURCE_NAMES[i], data.routes[i]);
+    }
+    file_close(fp);
+    log_info("Profiler data written to", filename, 0);
+    return 1;
+}
+
+static void write_json_stats(FILE *fp, const char *id_name, int id, const char *name, const profiler_stats *stats,
+    int is_first)
+{
+    fprintf(fp, "%s\n    { \"%s\": %d, ", is_first ? "" : ",", id_name, id);
+    if (name) {
+        fprintf(fp, "\"name\": \"%s\", ", name);
+    }
+    fprintf(fp, "\"calls\": %u, \"total_us\": %llu, \"average_us\": %llu, \"max_us\": %llu }",
+        stats->calls, (unsigned long long) stats->total_time, (unsigned long long) average(stats),
+        (unsigned long long) stats->max_time);
+}
+
+int game_profiler_write_json(const char *filename)
+{
+    FILE *fp = file_open(filename, "w");
+    if (!fp) {
+        log_error("Unable to write profiler data to", filename, 0);
+        return 0;
+    }
+    int is_first = 1;
+    fprintf(fp, "{\n  \"sections\": [");
+    for (int i = 0; i < PROFILER_SECTION_MAX; i++) {
+        if (data.sections[i].calls) {
+            write_json_stats(fp, "id", i, SECTION_NAMES[i], &data.sections[i], is_first);
+            is_first = 0;
+        }
+    }
+    is_first = 1;
+    fprintf(fp, "\n  ],\n  \"figure_types\": [");
+    for (int i = 0; i < FIGURE_TYPE_MAX; i++) {
+        if (data.figures[i].calls) {
+            write_json_stats(fp, "type", i, 0, &data.figures[i], is_first);
+            is_first = 0;
+        }
+    }
+    fprintf(fp, "\n  ],\n  \"routes\": [");
+    for (int i = 0; i < PROFILER_ROUTE_MAX; i++) {
+        fprintf(fp, "%s\n    { \"source\": \"%s\", \"count\": %u }", i ? "," : "", ROUTE_SOURCE_NAMES[i],
+            data.routes[i]);
+    }
+    fprintf(fp, "\n  ]\n}\n");
+    file_close(fp);
+    log_info("Profiler data written to", filename, 0);
+    return 1;
+}
+
+static int find_top(const profiler_stats *stats, int num_stats, int *top, int max_top, int by_total)
+{
+    int count = 0;
+    for (int i = 0; i < num_stats; i++) {
+        if (!stats[i].calls) {
+            continue;
+        }
+        uint64_t value = by_total ? stats[i].total_time : stats[i].max_time;
+        int position = count;
+        while (position > 0) {
+            const profiler_stats *other = &stats[top[position - 1]];
+            if ((by_total ? other->total_time : other->max_time) >= value) {
+                break;
+            }
+            if (position < max_top) {
+                top[position] = top[position - 1];
+            }
+            position--;
+        }
+        if (position < max_top) {
+            top[position] = i;
+            if (count < max_top) {
+                count++;
+            }
+        }
+    }
+    return count;
+}
+
+void game_profiler_draw(void)
+{
+    int top_sections[OVERLAY_SECTIONS];
+    int top_figures[OVERLAY_FIGURE_TYPES];
+    int num_sections = find_top(data.sections, PROFILER_SECTION_MAX, top_sections, OVERLAY_SECTIONS, 0);
+    int num_figures = find_top(data.figures, FIGURE_TYPE_MAX, top_figures, OVERLAY_FIGURE_TYPES, 1);
+
+    int x = 8;
+    int y = 50;
+    int width = 380;
+    int height = (num_sections + num_figures + 2) * OVERLAY_LINE_HEIGHT + 8;
+    graphics_draw_rect(x, y, width + 2, height + 2, COLOR_BLACK);
+    graphics_fill_rect(x + 1, y + 1, width, height, COLOR_WHITE);
+
+    char line[100];
+    y += 5;
+    text_draw((const uint8_t *) "Slot / section      avg us / max us", x + 5, y, FONT_SMALL_PLAIN, COLOR_BLACK);
+    for (int i = 0; i < num_sections; i++) {
+        const profiler_stats *stats = &data.sections[top_sections[i]];
+        y += OVERLAY_LINE_HEIGHT;
+        snprintf(line, sizeof(line), "%2d %s", top_sections[i], SECTION_NAMES[top_sections[i]]);
+        text_draw((const uint8_t *) line, x + 5, y, FONT_SMALL_PLAIN, COLOR_BLACK);
+        snprintf(line, sizeof(line), "%llu / %llu",
+            (unsigned long long) average(stats), (unsigned long long) stats->max_time);
+        text_draw((const uint8_t *) line, x + 290, y, FONT_SMALL_PLAIN, COLOR_BLACK);
+    }
+    y += OVERLAY_LINE_HEIGHT;
+    text_draw((const uint8_t *) "Figure type         calls / total ms", x + 5, y, FONT_SMALL_PLAIN, COLOR_BLACK);
+    for (int i = 0; i < num_figures; i++) {
+        const profiler_stats *stats = &data.figures[top_figures[i]];
+        y += OVERLAY_LINE_HEIGHT;
+        text_draw(lang_get_string(64, top_figures[i]), x + 5, y, FONT_SMALL_PLAIN, COLOR_BLACK);
+        snprintf(line, sizeof(line), "%u / %llu", stats->calls, (unsigned long long) (stats->total_time / 1000));
+        text_draw((const uint8_t *) line, x + 290, y, FONT_SMALL_PLAIN, COLOR_BLACK);
+    }
+}
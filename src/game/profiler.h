@@ -0,0 +1,89 @@
+#ifndef GAME_PROFILER_H
+#define GAME_PROFILER_H
+
+#include <stdint.h>
+
+/**
+ * @file
+ * Simulation profiler.
+ * Records wall time and call counts for each tick slot of the simulation, for the daily
+ * update and for the actions of each figure type, and counts where figure routes came from.
+ */
+
+typedef enum {
+    PROFILER_SECTION_NEW_DAY = 50,
+    PROFILER_SECTION_FIGURES = 51,
+    PROFILER_SECTION_MAX = 52
+} profiler_section;
+
+typedef enum {
+    PROFILER_ROUTE_SEARCHED = 0,
+    PROFILER_ROUTE_PLANNED = 1,
+    PROFILER_ROUTE_SHARED = 2,
+    PROFILER_ROUTE_MAX = 3
+} profiler_route_source;
+
+/**
+ * Enables or disables the profiler. Enabling the profiler clears the previous results.
+ * @param enabled Whether the profiler should be enabled
+ */
+void game_profiler_set_enabled(int enabled);
+
+/**
+ * Checks whether the profiler is enabled
+ * @return 1 if enabled, 0 otherwise
+ */
+int game_profiler_is_enabled(void);
+
+/**
+ * Clears all recorded data
+ */
+void game_profiler_reset(void);
+
+/**
+ * Starts measuring. Returns 0 when the profiler is disabled, which makes the matching
+ * record call a no-op.
+ * @return Start timestamp to pass to the record functions
+ */
+uint64_t game_profiler_start(void);
+
+/**
+ * Records a measurement for a tick slot (0-49) or a profiler_section
+ * @param section Tick slot or section
+ * @param start Timestamp returned by game_profiler_start
+ */
+void game_profiler_record_section(int section, uint64_t start);
+
+/**
+ * Records a measurement for the action of a figure type
+ * @param type Figure type
+ * @param start Timestamp returned by game_profiler_start
+ */
+void game_profiler_record_figure(int type, uint64_t start);
+
+/**
+ * Counts a route handed to a figure
+ * @param source Whether the route was searched for, planned ahead or shared with another figure
+ */
+void game_profiler_count_route(profiler_route_source source);
+
+/**
+ * Writes the recorded data as CSV
+ * @param filename File to write
+ * @return 1 on success, 0 on failure
+ */
+int game_profiler_write_csv(const char *filename);
+
+/**
+ * Writes the recorded data as JSON
+ * @param filename File to write
+ * @return 1 on success, 0 on failure
+ */
+int game_profiler_write_json(const char *filename);
+
+/**
+ * Draws the profiler overlay with the most expensive tick slots and figure types
+ */
+void game_profiler_draw(void);
+
+#endif // GAME_PROFILER_H
@@ -33,6 +33,42 @@ const char *system_OS(void);
  */
 uint64_t system_get_ticks(void);
 
+/**
+ * Gets a high resolution timestamp, meant for measuring short durations
+ * @return Timestamp in microseconds
+ */
+uint64_t system_get_microseconds(void);
+
+/**
+ * Gets the number of threads that system_run_on_workers uses
+ * @return Number of workers, at least 1
+ */
+int system_get_num_workers(void);
+
+/**
+ * Runs a task once on every worker thread and waits until all of them have finished.
+ * The calling thread is worker 0.
+ * @param task Function to run, which receives the worker index and the userdata
+ * @param userdata Data to pass to the task
+ */
+void system_run_on_workers(void (*task)(int worker_id, void *userdata), void *userdata);
+
+/**
+ * Runs a task on a background thread and returns without waiting for it.
+ * Only one background task runs at a time: this first waits for the previous one to finish.
+ * When no thread can be started, the task runs on the calling thread.
+ * @param task Function to run, which receives the userdata
+ * @param finished Function to run on the calling thread once the task is done, can be null
+ * @param userdata Data to pass to both functions
+ */
+void system_run_in_background(void (*task)(void *userdata), void (*finished)(void *userdata), void *userdata);
+
+/**
+ * Waits until the task started with system_run_in_background has finished,
+ * then runs its finished function on the calling thread
+ */
+void system_wait_for_background_task(void);
+
 /**
  * Resize window
  * @param width New width
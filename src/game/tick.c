@@ -39,6 +39,7 @@
 #include "figure/formation.h"
 #include "figuretype/crime.h"
 #include "game/file.h"
+#include "game/profiler.h"
 #include "game/settings.h"
 #include "game/time.h"
 #include "game/tutorial.h"
@@ -149,7 +150,9 @@ static void advance_tick(void)
     // NB: these ticks are noop:
     // 0, 10, 11, 13, 14, 15, 18, 26, 41
     // max is 49
-    switch (game_time_tick()) {
+    int tick = game_time_tick();
+    uint64_t profiler_start = game_profiler_start();
+    switch (tick) {
         case 1: city_gods_calculate_moods(1); break;
         case 2: sound_music_update(0); break;
         case 3: widget_minimap_invalidate(); break;
@@ -192,8 +195,11 @@ static void advance_tick(void)
         case 48: house_service_decay_tax_collector(); break;
         case 49: city_culture_calculate(); break;
     }
+    game_profiler_record_section(tick, profiler_start);
     if (game_time_advance_tick()) {
+        profiler_start = game_profiler_start();
         advance_day();
+        game_profiler_record_section(PROFILER_SECTION_NEW_DAY, profiler_start);
     }
 }
 
@@ -207,7 +213,9 @@ void game_tick_run(void)
     random_generate_next();
     game_undo_reduce_time_available();
     advance_tick();
+    uint64_t profiler_start = game_profiler_start();
     figure_action_handle();
+    game_profiler_record_section(PROFILER_SECTION_FIGURES, profiler_start);
     scenario_earthquake_process();
     scenario_gladiator_revolt_process();
     scenario_emperor_change_process();
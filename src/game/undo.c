@@ -146,6 +146,7 @@ void game_undo_restore_building_state(void)
             building *b = building_get(data.buildings[i].id);
             if (b->state == BUILDING_STATE_DELETED_BY_PLAYER) {
                 b->state = BUILDING_STATE_IN_USE;
+                building_update_hot_fields(b);
             }
             b->is_deleted = 0;
         }
@@ -204,6 +205,7 @@ static void add_building_to_terrain(building *b)
         }
     }
     b->state = BUILDING_STATE_IN_USE;
+    building_update_hot_fields(b);
 }
 
 void game_undo_perform(void)
@@ -270,7 +272,9 @@ void game_undo_perform(void)
         }
         for (int i = 0; i < data.num_buildings; i++) {
             if (data.buildings[i].id) {
-                building_get(data.buildings[i].id)->state = BUILDING_STATE_UNDO;
+                building *b = building_get(data.buildings[i].id);
+                b->state = BUILDING_STATE_UNDO;
+                building_update_hot_fields(b);
             }
         }
         building_update_state();
@@ -3,6 +3,8 @@
 
 #include "core/image.h"
 
+#define MAX_CITY_LAYERS 64
+
 typedef enum {
     ATLAS_FIRST,
     ATLAS_MAIN = ATLAS_FIRST,
@@ -76,6 +78,12 @@ typedef struct {
     void (*set_tooltip_position)(int x, int y);
     void (*set_tooltip_opacity)(int opacity);
 
+    int (*supports_city_layers)(void);
+    int (*start_city_layer_creation)(int layer_id, int width, int height);
+    void (*finish_city_layer_creation)(void);
+    int (*has_city_layer)(int layer_id);
+    void (*draw_city_layer)(int layer_id, int x, int y, float scale);
+
     int (*save_image_from_screen)(int image_id, int x, int y, int width, int height);
     void (*draw_image_to_screen)(int image_id, int x, int y);
     int (*save_screen_buffer)(color_t *pixels, int x, int y, int width, int height, int row_width);
@@ -89,11 +97,14 @@ typedef struct {
     void (*free_image_atlas)(atlas_type type);
 
     void (*load_unpacked_image)(const image *img, const color_t *pixels);
+    int (*has_unpacked_image)(const image *img);
     void (*free_unpacked_image)(const image *img);
 
     int (*should_pack_image)(int width, int height);
 
     void (*update_scale)(int city_scale);
+
+    void (*get_draw_statistics)(int *draw_calls, int *batched_images);
 } graphics_renderer_interface;
 
 const graphics_renderer_interface *graphics_renderer(void);
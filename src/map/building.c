@@ -3,11 +3,48 @@
 #include "building/building.h"
 #include "core/config.h"
 #include "map/grid.h"
+#include "map/routing_terrain.h"
+
+#include <string.h>
+
+#define SERVICE_RANGE_RADIUS 2
+#define SERVICE_RANGE_TILES ((2 * SERVICE_RANGE_RADIUS + 1) * (2 * SERVICE_RANGE_RADIUS + 1))
 
 static grid_u16 buildings_grid;
 static grid_u8 damage_grid;
 static grid_u8 rubble_type_grid;
 
+// The buildings within service range of a tile are collected the first time a walker passes it,
+// and thrown away when a building is placed on or removed from a tile in range.
+static struct {
+    uint8_t num_buildings[GRID_SIZE * GRID_SIZE]; // number of buildings plus one, 0 if not collected
+    uint16_t building_ids[GRID_SIZE * GRID_SIZE][SERVICE_RANGE_TILES];
+    int map_width;
+    int map_height;
+} service_range;
+
+static void clear_service_range(void)
+{
+    memset(service_range.num_buildings, 0, sizeof(service_range.num_buildings));
+    service_range.map_width = map_grid_width();
+    service_range.map_height = map_grid_height();
+}
+
+static void invalidate_service_range(int grid_offset)
+{
+    if (!map_grid_is_valid_offset(grid_offset)) {
+        return;
+    }
+    int x_min, y_min, x_max, y_max;
+    map_grid_get_area(map_grid_offset_to_x(grid_offset), map_grid_offset_to_y(grid_offset), 1, SERVICE_RANGE_RADIUS,
+        &x_min, &y_min, &x_max, &y_max);
+    for (int yy = y_min; yy <= y_max; yy++) {
+        for (int xx = x_min; xx <= x_max; xx++) {
+            service_range.num_buildings[map_grid_offset(xx, yy)] = 0;
+        }
+    }
+}
+
 int map_building_at(int grid_offset)
 {
     return map_grid_is_valid_offset(grid_offset) ? buildings_grid.items[grid_offset] : 0;
@@ -21,9 +58,44 @@ int map_building_from_buffer(buffer *buildings, int grid_offset)
 
 void map_building_set(int grid_offset, int building_id)
 {
+    if (buildings_grid.items[grid_offset] != building_id) {
+        map_routing_tile_changed(grid_offset, ROUTING_CHANGE_LAND);
+        invalidate_service_range(grid_offset);
+    }
     buildings_grid.items[grid_offset] = building_id;
 }
 
+int map_building_in_service_range(int x, int y, const uint16_t **building_ids)
+{
+    if (service_range.map_width != map_grid_width() || service_range.map_height != map_grid_height()) {
+        clear_service_range();
+    }
+    static uint16_t outside_map_ids[SERVICE_RANGE_TILES];
+    int is_inside = map_grid_is_inside(x, y, 1);
+    int grid_offset = is_inside ? map_grid_offset(x, y) : 0;
+    if (is_inside && service_range.num_buildings[grid_offset]) {
+        *building_ids = service_range.building_ids[grid_offset];
+        return service_range.num_buildings[grid_offset] - 1;
+    }
+    uint16_t *ids = is_inside ? service_range.building_ids[grid_offset] : outside_map_ids;
+    int num_buildings = 0;
+    int x_min, y_min, x_max, y_max;
+    map_grid_get_area(x, y, 1, SERVICE_RANGE_RADIUS, &x_min, &y_min, &x_max, &y_max);
+    for (int yy = y_min; yy <= y_max; yy++) {
+        for (int xx = x_min; xx <= x_max; xx++) {
+            int building_id = map_building_at(map_grid_offset(xx, yy));
+            if (building_id) {
+                ids[num_buildings++] = building_id;
+            }
+        }
+    }
+    if (is_inside) {
+        service_range.num_buildings[grid_offset] = num_buildings + 1;
+    }
+    *building_ids = ids;
+    return num_buildings;
+}
+
 void map_building_damage_clear(int grid_offset)
 {
     damage_grid.items[grid_offset] = 0;
@@ -49,6 +121,8 @@ void map_building_clear(void)
     map_grid_clear_u16(buildings_grid.items);
     map_grid_clear_u8(damage_grid.items);
     map_grid_clear_u8(rubble_type_grid.items);
+    map_routing_all_tiles_changed(ROUTING_CHANGE_LAND);
+    clear_service_range();
 }
 
 void map_building_save_state(buffer *buildings, buffer *damage)
@@ -61,6 +135,8 @@ void map_building_load_state(buffer *buildings, buffer *damage)
 {
     map_grid_load_state_u16(buildings_grid.items, buildings);
     map_grid_load_state_u8(damage_grid.items, damage);
+    map_routing_all_tiles_changed(ROUTING_CHANGE_LAND);
+    clear_service_range();
 }
 
 int map_building_is_reservoir(int x, int y)
@@ -4,6 +4,8 @@
 #include "building/type.h"
 #include "core/buffer.h"
 
+#include <stdint.h>
+
 /**
  * Returns the building at the given offset
  * @param grid_offset Map offset
@@ -15,6 +17,17 @@ int map_building_from_buffer(buffer *buildings, int grid_offset);
 
 void map_building_set(int grid_offset, int building_id);
 
+/**
+ * Gets the buildings within service range of a tile, the tiles two steps away or closer.
+ * The tiles are visited row by row and a building is listed once for every tile it covers.
+ * The list stays valid until the next call or the next change to the buildings grid.
+ * @param x X position
+ * @param y Y position
+ * @param building_ids Set to the list of building IDs
+ * @return Number of building IDs in the list
+ */
+int map_building_in_service_range(int x, int y, const uint16_t **building_ids);
+
 /**
  * Increases building damage by 1
  * @param grid_offset Map offset
@@ -4,19 +4,64 @@
 #include "building/model.h"
 #include "building/monument.h"
 #include "core/calc.h"
+#include "core/log.h"
 #include "map/data.h"
 #include "map/grid.h"
 #include "map/property.h"
 #include "map/ring.h"
 #include "map/terrain.h"
 
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_DESIRABILITY 100
+#define MIN_DESIRABILITY -100
+#define MAX_RANGE 8
+
+typedef enum {
+    TERRAIN_INFLUENCE_NONE = 0,
+    TERRAIN_INFLUENCE_PLAZA,
+    TERRAIN_INFLUENCE_EARTHQUAKE,
+    TERRAIN_INFLUENCE_GARDEN,
+    TERRAIN_INFLUENCE_GARDEN_VENUS,
+    TERRAIN_INFLUENCE_RUBBLE,
+    TERRAIN_INFLUENCE_HIGHWAY,
+    TERRAIN_INFLUENCE_AQUEDUCT
+} terrain_influence;
+
+typedef struct {
+    int x;
+    int y;
+    int size;
+    int value;
+    int step;
+    int step_size;
+    int range;
+} influence;
+
 static grid_i8 desirability_grid;
 
+// The desirability grid is kept up to date by removing the old influence of each building or terrain
+// tile that changed since the last update and adding the new one. Positive and negative influences
+// are summed separately: as long as neither sum of a tile goes out of bounds, the tile's desirability
+// is their total. Otherwise the result depends on the order in which the influences were added,
+// so the whole grid is recalculated the way it always was.
+static struct {
+    int is_valid;
+    grid_i16 positive;
+    grid_i16 negative;
+    grid_u8 terrain;
+    influence *buildings;
+    int num_buildings;
+    int buildings_capacity;
+    int needs_full_update;
+} data;
+
 void map_desirability_clear(void)
 {
     map_grid_clear_i8(desirability_grid.items);
+    data.is_valid = 0;
 }
-
 static void add_desirability_at_distance(int x, int y, int size, int distance, int desirability)
 {
     int partially_outside_map = 0;
@@ -50,8 +95,8 @@ static void add_desirability_at_distance(int x, int y, int size, int distance, i
 static void add_to_terrain(int x, int y, int size, int desirability, int step, int step_size, int range)
 {
     if (size > 0) {
-        if (range > 8) {
-            range = 8;
+        if (range > MAX_RANGE) {
+            range = MAX_RANGE;
         }
         int tiles_within_step = 0;
         int distance = 1;
@@ -68,137 +113,323 @@ static void add_to_terrain(int x, int y, int size, int desirability, int step, i
     }
 }
 
-static void update_buildings(void)
+static void add_influence(const influence *inf)
 {
-    int value;
-    int value_bonus;
-    int step;
-    int step_size;
-    int range;
+    add_to_terrain(inf->x, inf->y, inf->size, inf->value, inf->step, inf->step_size, inf->range);
+}
+
+static void set_model_influence(influence *inf, building_type type)
+{
+    const model_building *model = model_get_building(type);
+    inf->value = model->desirability_value;
+    inf->step = model->desirability_step;
+    inf->step_size = model->desirability_step_size;
+    inf->range = model->desirability_range;
+}
+
+static void get_building_influence(building *b, int venus_module2, int venus_gt, influence *inf)
+{
+    if (b->state != BUILDING_STATE_IN_USE) {
+        memset(inf, 0, sizeof(influence));
+        return;
+    }
+    inf->x = b->x;
+    inf->y = b->y;
+    inf->size = b->size;
+    set_model_influence(inf, b->type);
+
+    // Venus Module 2 House Desirability Bonus
+    if (building_is_house(b->type) && b->data.house.temple_venus && venus_module2) {
+        if (b->subtype.house_level >= HOUSE_SMALL_VILLA) {
+            inf->value += 4;
+            inf->range += 1;
+        } else if (b->subtype.house_level <= HOUSE_LARGE_TENT) {
+            // tents normally confer -3, -2, -1, 0, 0, 0 (range=3)
+            // now this becomes -1, 0, 0, 0, 0, 0 (range=1)
+            inf->value += 2;
+            inf->range = 1;
+        } else {
+            if (inf->range <= 1) {
+                inf->range = 1;
+            }
+            inf->value += 2;
+        }
+    }
+
+    if (building_monument_is_monument(b) && b->monument.phase != MONUMENT_FINISHED) {
+        inf->value = 0;
+        inf->step = 0;
+        inf->step_size = 0;
+        inf->range = 0;
+    }
+
+    // Venus GT Base Bonus
+    if (building_is_statue_garden_temple(b->type) && venus_gt) {
+        int value_bonus = ((inf->value / 4) > 1) ? (inf->value / 4) : 1;
+        inf->value += value_bonus;
+        inf->step += 1;
+        inf->range += 1;
+    }
+}
+
+static terrain_influence get_terrain_influence_type(int grid_offset, int venus_gt)
+{
+    int terrain = map_terrain_get(grid_offset);
+    if (map_property_is_plaza_earthquake_or_overgrown_garden(grid_offset)) {
+        if (terrain & TERRAIN_ROAD) {
+            return TERRAIN_INFLUENCE_PLAZA;
+        } else if (terrain & TERRAIN_ROCK) {
+            return TERRAIN_INFLUENCE_EARTHQUAKE;
+        } else if (terrain & TERRAIN_GARDEN) {
+            return venus_gt ? TERRAIN_INFLUENCE_GARDEN_VENUS : TERRAIN_INFLUENCE_GARDEN;
+        } else {
+            // invalid plaza/earthquake flag
+            map_property_clear_plaza_earthquake_or_overgrown_garden(grid_offset);
+            return TERRAIN_INFLUENCE_NONE;
+        }
+    } else if (terrain & TERRAIN_GARDEN) {
+        return venus_gt ? TERRAIN_INFLUENCE_GARDEN_VENUS : TERRAIN_INFLUENCE_GARDEN;
+    } else if (terrain & TERRAIN_RUBBLE) {
+        return TERRAIN_INFLUENCE_RUBBLE;
+    } else if (terrain & TERRAIN_HIGHWAY) {
+        return TERRAIN_INFLUENCE_HIGHWAY;
+    } else if (terrain & TERRAIN_AQUEDUCT) {
+        return TERRAIN_INFLUENCE_AQUEDUCT;
+    }
+    return TERRAIN_INFLUENCE_NONE;
+}
+
+static void get_terrain_influence(terrain_influence type, int x, int y, influence *inf)
+{
+    inf->x = x;
+    inf->y = y;
+    inf->size = 1;
+    switch (type) {
+        case TERRAIN_INFLUENCE_PLAZA:
+            set_model_influence(inf, BUILDING_PLAZA);
+            break;
+        case TERRAIN_INFLUENCE_EARTHQUAKE:
+            // earthquake fault line: slight negative
+            set_model_influence(inf, BUILDING_HOUSE_VACANT_LOT);
+            break;
+        case TERRAIN_INFLUENCE_GARDEN:
+        case TERRAIN_INFLUENCE_GARDEN_VENUS:
+            set_model_influence(inf, BUILDING_GARDENS);
+            if (type == TERRAIN_INFLUENCE_GARDEN_VENUS) {
+                int value_bonus = ((inf->value / 4) > 1) ? (inf->value / 4) : 1;
+                inf->value += value_bonus;
+                inf->step += 1;
+                inf->range += 1;
+            }
+            break;
+        case TERRAIN_INFLUENCE_HIGHWAY:
+            set_model_influence(inf, BUILDING_HIGHWAY);
+            break;
+        case TERRAIN_INFLUENCE_RUBBLE:
+        case TERRAIN_INFLUENCE_AQUEDUCT:
+            inf->value = -2;
+            inf->step = 1;
+            inf->step_size = 1;
+            inf->range = 2;
+            break;
+        default:
+            inf->size = 0;
+            break;
+    }
+}
+
+static void update_all(void)
+{
+    map_grid_clear_i8(desirability_grid.items);
     int venus_module2 = building_monument_gt_module_is_active(VENUS_MODULE_2_DESIRABILITY_ENTERTAINMENT);
     int venus_gt = building_monument_working(BUILDING_GRAND_TEMPLE_VENUS);
+    influence inf;
     for (int i = 1; i < building_count(); i++) {
-        building *b = building_get(i);
-        if (b->state == BUILDING_STATE_IN_USE) {
-
-            const model_building *model = model_get_building(b->type);
-            value = model->desirability_value;
-            step = model->desirability_step;
-            step_size = model->desirability_step_size;
-            range = model->desirability_range;
-
-            // Venus Module 2 House Desirability Bonus
-            if (building_is_house(b->type) && b->data.house.temple_venus && venus_module2) {
-                if (b->subtype.house_level >= HOUSE_SMALL_VILLA) {
-                    value += 4;
-                    range += 1;
-                } else if (b->subtype.house_level <= HOUSE_LARGE_TENT) {
-                    // tents normally confer -3, -2, -1, 0, 0, 0 (range=3)
-                    // now this becomes -1, 0, 0, 0, 0, 0 (range=1)
-                    value += 2;
-                    range = 1;
-                } else {
-                    if (range <= 1) {
-                        range = 1;
-                    }
-                    value += 2;
-                }
-            }
+        get_building_influence(building_get(i), venus_module2, venus_gt, &inf);
+        add_influence(&inf);
+    }
+    int grid_offset = map_data.start_offset;
+    for (int y = 0; y < map_data.height; y++, grid_offset += map_data.border_size) {
+        for (int x = 0; x < map_data.width; x++, grid_offset++) {
+            get_terrain_influence(get_terrain_influence_type(grid_offset, venus_gt), x, y, &inf);
+            add_influence(&inf);
+        }
+    }
+}
 
-            if (building_monument_is_monument(b) && b->monument.phase != MONUMENT_FINISHED) {
-                value = 0;
-                step = 0;
-                step_size = 0;
-                range = 0;
-            }
+static int is_out_of_bounds(int grid_offset)
+{
+    return data.positive.items[grid_offset] > MAX_DESIRABILITY ||
+        data.negative.items[grid_offset] < MIN_DESIRABILITY;
+}
 
-            // Venus GT Base Bonus
-            if (building_is_statue_garden_temple(b->type) && venus_gt) {
-                value_bonus = ((value / 4) > 1) ? (value / 4) : 1;
-                value += value_bonus;
-                step += 1;
-                range += 1;
-            }
+static void change_tile(int grid_offset, int desirability, int sign)
+{
+    // The influence is added to or removed from the sum of its own sign, whichever way it changes
+    if (desirability > 0) {
+        data.positive.items[grid_offset] += sign * desirability;
+    } else {
+        data.negative.items[grid_offset] += sign * desirability;
+    }
+    if (is_out_of_bounds(grid_offset)) {
+        data.needs_full_update = 1;
+    } else {
+        desirability_grid.items[grid_offset] = data.positive.items[grid_offset] + data.negative.items[grid_offset];
+    }
+}
 
-            add_to_terrain(
-                b->x, b->y, b->size,
-                value,
-                step,
-                step_size,
-                range);
+static void change_at_distance(int x, int y, int size, int distance, int desirability, int sign)
+{
+    // same tiles as add_desirability_at_distance
+    int partially_outside_map = 0;
+    if (x - distance < -1 || x + distance + size - 1 > map_data.width) {
+        partially_outside_map = 1;
+    }
+    if (y - distance < -1 || y + distance + size - 1 > map_data.height) {
+        partially_outside_map = 1;
+    }
+    int base_offset = map_grid_offset(x, y);
+    int start = map_ring_start(size, distance);
+    int end = map_ring_end(size, distance);
+    for (int i = start; i < end; i++) {
+        const ring_tile *tile = map_ring_tile(i);
+        if (!partially_outside_map || map_ring_is_inside_map(x + tile->x, y + tile->y)) {
+            change_tile(base_offset + tile->grid_offset, desirability, sign);
         }
     }
 }
 
-static void add_garden_desirability(int x, int y)
+static void change_influence(const influence *inf, int sign)
 {
-    const model_building *model = model_get_building(BUILDING_GARDENS);
+    if (inf->size <= 0) {
+        return;
+    }
+    int range = inf->range > MAX_RANGE ? MAX_RANGE : inf->range;
+    int desirability = inf->value;
+    int tiles_within_step = 0;
+    for (int distance = 1; distance <= range; distance++) {
+        if (desirability) {
+            change_at_distance(inf->x, inf->y, inf->size, distance, desirability, sign);
+        }
+        tiles_within_step++;
+        if (tiles_within_step >= inf->step) {
+            desirability += inf->step_size;
+            tiles_within_step = 0;
+        }
+    }
+}
 
-    int value = model->desirability_value;
-    int step = model->desirability_step;
-    int step_size = model->desirability_step_size;
-    int range = model->desirability_range;
+static void replace_influence(influence *old_influence, const influence *new_influence)
+{
+    if (memcmp(old_influence, new_influence, sizeof(influence)) == 0) {
+        return;
+    }
+    change_influence(old_influence, -1);
+    change_influence(new_influence, 1);
+    *old_influence = *new_influence;
+}
 
-    if (building_monument_working(BUILDING_GRAND_TEMPLE_VENUS)) {
-        int value_bonus = ((value / 4) > 1) ? (value / 4) : 1;
-        value += value_bonus;
-        step += 1;
-        range += 1;
+static int ensure_building_capacity(int num_buildings)
+{
+    if (num_buildings <= data.buildings_capacity) {
+        return 1;
+    }
+    influence *buildings = realloc(data.buildings, num_buildings * sizeof(influence));
+    if (!buildings) {
+        return 0;
     }
+    memset(&buildings[data.buildings_capacity], 0,
+        (num_buildings - data.buildings_capacity) * sizeof(influence));
+    data.buildings = buildings;
+    data.buildings_capacity = num_buildings;
+    return 1;
+}
 
-    add_to_terrain(x, y, 1, value, step, step_size, range);
+static void reset_incremental_state(void)
+{
+    memset(data.positive.items, 0, sizeof(data.positive.items));
+    memset(data.negative.items, 0, sizeof(data.negative.items));
+    memset(data.terrain.items, 0, sizeof(data.terrain.items));
+    if (data.buildings) {
+        memset(data.buildings, 0, data.buildings_capacity * sizeof(influence));
+    }
+    data.num_buildings = 0;
+    data.is_valid = 1;
 }
 
-static void update_terrain(void)
+static int update_incremental(void)
 {
+    int num_buildings = building_count();
+    if (!ensure_building_capacity(num_buildings)) {
+        data.is_valid = 0;
+        return 0;
+    }
+    int was_valid = data.is_valid;
+    if (!was_valid) {
+        reset_incremental_state();
+    }
+    data.needs_full_update = !was_valid;
+
+    int venus_module2 = building_monument_gt_module_is_active(VENUS_MODULE_2_DESIRABILITY_ENTERTAINMENT);
+    int venus_gt = building_monument_working(BUILDING_GRAND_TEMPLE_VENUS);
+    influence inf;
+    for (int i = 1; i < num_buildings; i++) {
+        get_building_influence(building_get(i), venus_module2, venus_gt, &inf);
+        replace_influence(&data.buildings[i], &inf);
+    }
+    memset(&inf, 0, sizeof(influence));
+    for (int i = num_buildings; i < data.num_buildings; i++) {
+        replace_influence(&data.buildings[i], &inf);
+    }
+    data.num_buildings = num_buildings;
+
     int grid_offset = map_data.start_offset;
     for (int y = 0; y < map_data.height; y++, grid_offset += map_data.border_size) {
         for (int x = 0; x < map_data.width; x++, grid_offset++) {
-            int terrain = map_terrain_get(grid_offset);
-            if (map_property_is_plaza_earthquake_or_overgrown_garden(grid_offset)) {
-                int type;
-                if (terrain & TERRAIN_ROAD) {
-                    type = BUILDING_PLAZA;
-                } else if (terrain & TERRAIN_ROCK) {
-                    // earthquake fault line: slight negative
-                    type = BUILDING_HOUSE_VACANT_LOT;
-                } else if (terrain & TERRAIN_GARDEN) {
-                    add_garden_desirability(x, y);
-                    continue;
-                } else {
-                    // invalid plaza/earthquake flag
-                    map_property_clear_plaza_earthquake_or_overgrown_garden(grid_offset);
-                    continue;
-                }
-                const model_building *model = model_get_building(type);
-                add_to_terrain(x, y, 1,
-                    model->desirability_value,
-                    model->desirability_step,
-                    model->desirability_step_size,
-                    model->desirability_range);
-            } else if (terrain & TERRAIN_GARDEN) {
-                add_garden_desirability(x, y);
-            } else if (terrain & TERRAIN_RUBBLE) {
-                add_to_terrain(x, y, 1, -2, 1, 1, 2);
-            } else if (terrain & TERRAIN_HIGHWAY) {
-                const model_building *model = model_get_building(BUILDING_HIGHWAY);
-                add_to_terrain(x, y, 1,
-                    model->desirability_value,
-                    model->desirability_step,
-                    model->desirability_step_size,
-                    model->desirability_range);
-            } else if (terrain & TERRAIN_AQUEDUCT) {
-                add_to_terrain(x, y, 1, -2, 1, 1, 2);
+            terrain_influence type = get_terrain_influence_type(grid_offset, venus_gt);
+            if (type != data.terrain.items[grid_offset]) {
+                influence old_influence;
+                get_terrain_influence(data.terrain.items[grid_offset], x, y, &old_influence);
+                get_terrain_influence(type, x, y, &inf);
+                change_influence(&old_influence, -1);
+                change_influence(&inf, 1);
+                data.terrain.items[grid_offset] = type;
+            }
+        }
+    }
+    return !data.needs_full_update;
+}
+
+#ifdef CHECK_DESIRABILITY
+static void check_incremental_update(void)
+{
+    static grid_i8 incremental;
+    memcpy(incremental.items, desirability_grid.items, sizeof(incremental.items));
+    update_all();
+    int mismatches = 0;
+    for (int i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+        if (incremental.items[i] != desirability_grid.items[i]) {
+            if (!mismatches) {
+                log_error("Incremental desirability differs at grid offset", 0, i);
             }
+            mismatches++;
         }
     }
+    if (mismatches) {
+        log_error("Number of tiles with wrong incremental desirability:", 0, mismatches);
+    }
 }
+#endif
 
 void map_desirability_update(void)
 {
-    map_desirability_clear();
-    update_buildings();
-    update_terrain();
+    if (!update_incremental()) {
+        update_all();
+        return;
+    }
+#ifdef CHECK_DESIRABILITY
+    check_incremental_update();
+#endif
 }
 
 int map_desirability_get(int grid_offset)
@@ -231,4 +462,5 @@ void map_desirability_save_state(buffer *buf)
 void map_desirability_load_state(buffer *buf)
 {
     map_grid_load_state_i8(desirability_grid.items, buf);
+    data.is_valid = 0;
 }
@@ -1,9 +1,138 @@
 #include "figure.h"
 
+#include "core/array.h"
+#include "core/log.h"
 #include "map/grid.h"
 
+#include <stdlib.h>
+
+// The figures on a tile are kept in a bucket: the first IDs are stored inline and crowded tiles
+// spill over into an extra array. The first figure of each tile and the next_figure_id_on_same_tile
+// chains are still kept up to date because they are saved, but they are no longer walked.
+#define FIGURES_IN_BUCKET 5
+#define BUCKET_ARRAY_SIZE_STEP 1024
+#define MAX_FIGURES_ON_SAME_TILE_INDEX 20
+
+typedef struct {
+    uint16_t id;
+    uint16_t count;
+    uint16_t overflow_capacity;
+    uint16_t figure_ids[FIGURES_IN_BUCKET];
+    uint16_t *overflow;
+} tile_bucket;
+
 static grid_u16 figures;
 
+static struct {
+    grid_u16 bucket_at;
+    array(tile_bucket) buckets;
+    int is_valid;
+} data;
+
+static void initialize_new_bucket(tile_bucket *bucket, unsigned int position)
+{
+    bucket->id = position;
+}
+
+static int bucket_in_use(const tile_bucket *bucket)
+{
+    return bucket->count > 0;
+}
+
+static uint16_t *bucket_slot(tile_bucket *bucket, int index)
+{
+    return index < FIGURES_IN_BUCKET ? &bucket->figure_ids[index] : &bucket->overflow[index - FIGURES_IN_BUCKET];
+}
+
+static tile_bucket *get_bucket(int grid_offset)
+{
+    int bucket_id = data.bucket_at.items[grid_offset];
+    return bucket_id ? array_item(data.buckets, bucket_id) : 0;
+}
+
+static int bucket_position(tile_bucket *bucket, int figure_id)
+{
+    for (int i = 0; i < bucket->count; i++) {
+        if (*bucket_slot(bucket, i) == figure_id) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int append_to_bucket(int grid_offset, int figure_id)
+{
+    tile_bucket *bucket = get_bucket(grid_offset);
+    if (!bucket) {
+        array_new_item_after_index(data.buckets, 1, bucket);
+        if (!bucket) {
+            return 0;
+        }
+        data.bucket_at.items[grid_offset] = bucket->id;
+    }
+    if (bucket->count == FIGURES_IN_BUCKET + bucket->overflow_capacity) {
+        int capacity = bucket->overflow_capacity ? bucket->overflow_capacity * 2 : FIGURES_IN_BUCKET * 2;
+        uint16_t *overflow = realloc(bucket->overflow, capacity * sizeof(uint16_t));
+        if (!overflow) {
+            return 0;
+        }
+        bucket->overflow = overflow;
+        bucket->overflow_capacity = capacity;
+    }
+    *bucket_slot(bucket, bucket->count++) = figure_id;
+    return 1;
+}
+
+static void remove_from_bucket(int grid_offset, tile_bucket *bucket, int position)
+{
+    bucket->count--;
+    for (int i = position; i < bucket->count; i++) {
+        *bucket_slot(bucket, i) = *bucket_slot(bucket, i + 1);
+    }
+    if (!bucket->count) {
+        free(bucket->overflow);
+        bucket->overflow = 0;
+        bucket->overflow_capacity = 0;
+        data.bucket_at.items[grid_offset] = 0;
+        array_mark_item_free(data.buckets, bucket->id);
+        array_trim(data.buckets);
+    }
+}
+
+static void clear_buckets(void)
+{
+    tile_bucket *bucket;
+    array_foreach(data.buckets, bucket)
+    {
+        free(bucket->overflow);
+    }
+    map_grid_clear_u16(data.bucket_at.items);
+    if (!array_init(data.buckets, BUCKET_ARRAY_SIZE_STEP, initialize_new_bucket, bucket_in_use) ||
+        !array_next(data.buckets)) { // Ignore first bucket
+        log_error("Unable to create the figure buckets. The game will now crash.", 0, 0);
+    }
+    array_track_free_slots(data.buckets);
+}
+
+static void ensure_valid_buckets(void)
+{
+    if (data.is_valid) {
+        return;
+    }
+    clear_buckets();
+    data.is_valid = 1;
+    for (int grid_offset = 0; grid_offset < GRID_SIZE * GRID_SIZE; grid_offset++) {
+        int figure_id = figures.items[grid_offset];
+        for (int guard = 0; figure_id && guard < figure_count(); guard++) {
+            if (!append_to_bucket(grid_offset, figure_id)) {
+                log_error("Unable to add figure to its tile. The game will now crash.", 0, figure_id);
+                return;
+            }
+            figure_id = figure_get(figure_id)->next_figure_id_on_same_tile;
+        }
+    }
+}
+
 int map_has_figure_at(int grid_offset)
 {
     return map_grid_is_valid_offset(grid_offset) && figures.items[grid_offset] > 0;
@@ -14,11 +143,29 @@ int map_figure_at(int grid_offset)
     return map_grid_is_valid_offset(grid_offset) ? figures.items[grid_offset] : 0;
 }
 
-static void cap_figures_on_same_tile_index(figure *f)
+int map_figure_count_at(int grid_offset)
+{
+    if (!map_grid_is_valid_offset(grid_offset)) {
+        return 0;
+    }
+    ensure_valid_buckets();
+    tile_bucket *bucket = get_bucket(grid_offset);
+    return bucket ? bucket->count : 0;
+}
+
+int map_figure_at_index(int grid_offset, int index)
 {
-    if (f->figures_on_same_tile_index > 20) {
-        f->figures_on_same_tile_index = 20;
+    if (!map_grid_is_valid_offset(grid_offset) || index < 0) {
+        return 0;
     }
+    ensure_valid_buckets();
+    tile_bucket *bucket = get_bucket(grid_offset);
+    return bucket && index < bucket->count ? *bucket_slot(bucket, index) : 0;
+}
+
+static int figures_on_same_tile_index(int position)
+{
+    return position > MAX_FIGURES_ON_SAME_TILE_INDEX ? MAX_FIGURES_ON_SAME_TILE_INDEX : position;
 }
 
 void map_figure_add(figure *f)
@@ -26,21 +173,20 @@ void map_figure_add(figure *f)
     if (!map_grid_is_valid_offset(f->grid_offset)) {
         return;
     }
+    ensure_valid_buckets();
     f->figures_on_same_tile_index = 0;
     f->next_figure_id_on_same_tile = 0;
 
-    if (figures.items[f->grid_offset]) {
-        figure *next = figure_get(figures.items[f->grid_offset]);
-        f->figures_on_same_tile_index++;
-        while (next->next_figure_id_on_same_tile) {
-            next = figure_get(next->next_figure_id_on_same_tile);
-            f->figures_on_same_tile_index++;
-        }
-        cap_figures_on_same_tile_index(f);
-        next->next_figure_id_on_same_tile = f->id;
+    tile_bucket *bucket = get_bucket(f->grid_offset);
+    if (bucket) {
+        figure_get(*bucket_slot(bucket, bucket->count - 1))->next_figure_id_on_same_tile = f->id;
+        f->figures_on_same_tile_index = figures_on_same_tile_index(bucket->count);
     } else {
         figures.items[f->grid_offset] = f->id;
     }
+    if (!append_to_bucket(f->grid_offset, f->id)) {
+        log_error("Unable to add figure to its tile. The game will now crash.", 0, f->id);
+    }
 }
 
 void map_figure_update(figure *f)
@@ -48,18 +194,14 @@ void map_figure_update(figure *f)
     if (!map_grid_is_valid_offset(f->grid_offset)) {
         return;
     }
-    f->figures_on_same_tile_index = 0;
-
-    figure *next = figure_get(figures.items[f->grid_offset]);
-    while (next->id) {
-        if (next->id == f->id) {
-            cap_figures_on_same_tile_index(f);
-            return;
-        }
-        f->figures_on_same_tile_index++;
-        next = figure_get(next->next_figure_id_on_same_tile);
+    ensure_valid_buckets();
+    tile_bucket *bucket = get_bucket(f->grid_offset);
+    if (!bucket) {
+        f->figures_on_same_tile_index = 0;
+        return;
     }
-    cap_figures_on_same_tile_index(f);
+    int position = bucket_position(bucket, f->id);
+    f->figures_on_same_tile_index = figures_on_same_tile_index(position >= 0 ? position : bucket->count);
 }
 
 void map_figure_delete(figure *f)
@@ -68,29 +210,27 @@ void map_figure_delete(figure *f)
         f->next_figure_id_on_same_tile = 0;
         return;
     }
-    if (figures.items[f->grid_offset] == f->id) {
+    ensure_valid_buckets();
+    tile_bucket *bucket = get_bucket(f->grid_offset);
+    int position = bucket ? bucket_position(bucket, f->id) : -1;
+    if (position == 0) {
         figures.items[f->grid_offset] = f->next_figure_id_on_same_tile;
-    } else {
-        figure *prev = figure_get(figures.items[f->grid_offset]);
-        while (prev->id && prev->next_figure_id_on_same_tile != f->id) {
-            prev = figure_get(prev->next_figure_id_on_same_tile);
-        }
-        prev->next_figure_id_on_same_tile = f->next_figure_id_on_same_tile;
+    } else if (position > 0) {
+        figure_get(*bucket_slot(bucket, position - 1))->next_figure_id_on_same_tile = f->next_figure_id_on_same_tile;
+    }
+    if (position >= 0) {
+        remove_from_bucket(f->grid_offset, bucket, position);
     }
     f->next_figure_id_on_same_tile = 0;
 }
 
 int map_figure_foreach_until(int grid_offset, int (*callback)(figure *f))
 {
-    if (figures.items[grid_offset] > 0) {
-        int figure_id = figures.items[grid_offset];
-        while (figure_id) {
-            figure *f = figure_get(figure_id);
-            int result = callback(f);
-            if (result) {
-                return result;
-            }
-            figure_id = f->next_figure_id_on_same_tile;
+    int figure_id;
+    for (int i = 0; (figure_id = map_figure_at_index(grid_offset, i)) != 0; i++) {
+        int result = callback(figure_get(figure_id));
+        if (result) {
+            return result;
         }
     }
     return 0;
@@ -99,6 +239,7 @@ int map_figure_foreach_until(int grid_offset, int (*callback)(figure *f))
 void map_figure_clear(void)
 {
     map_grid_clear_u16(figures.items);
+    data.is_valid = 0;
 }
 
 void map_figure_save_state(buffer *buf)
@@ -109,4 +250,6 @@ void map_figure_save_state(buffer *buf)
 void map_figure_load_state(buffer *buf)
 {
     map_grid_load_state_u16(figures.items, buf);
+    // the figures are loaded afterwards, so the buckets are filled when they are first used
+    data.is_valid = 0;
 }
@@ -18,6 +18,22 @@ int map_figure_at(int grid_offset);
  */
 int map_has_figure_at(int grid_offset);
 
+/**
+ * Returns the number of figures at the given offset
+ * @param grid_offset Map offset
+ * @return Number of figures at offset
+ */
+int map_figure_count_at(int grid_offset);
+
+/**
+ * Returns a figure at the given offset, in the order the figures entered the tile.
+ * Use it to iterate over the figures at an offset until it returns 0.
+ * @param grid_offset Map offset
+ * @param index Position of the figure, starting at 0
+ * @return Figure ID of the figure at that position, or 0 if there are fewer figures at offset
+ */
+int map_figure_at_index(int grid_offset, int index);
+
 void map_figure_add(figure *f);
 
 void map_figure_update(figure *f);
@@ -8,6 +8,7 @@
 #include "map/building_tiles.h"
 #include "map/grid.h"
 #include "map/orientation.h"
+#include "map/routing_terrain.h"
 #include "map/tiles.h"
 
 static grid_u32 images;
@@ -20,6 +21,10 @@ unsigned int map_image_at(int grid_offset)
 
 void map_image_set(int grid_offset, int image_id)
 {
+    // aqueduct images decide where citizens may cross
+    if (images.items[grid_offset] != (uint32_t) image_id) {
+        map_routing_tile_changed(grid_offset, ROUTING_CHANGE_LAND);
+    }
     images.items[grid_offset] = image_id;
 }
 
@@ -31,16 +36,19 @@ void map_image_backup(void)
 void map_image_restore(void)
 {
     map_grid_copy_u32(images_backup.items, images.items);
+    map_routing_all_tiles_changed(ROUTING_CHANGE_LAND);
 }
 
 void map_image_restore_at(int grid_offset)
 {
+    map_routing_tile_changed(grid_offset, ROUTING_CHANGE_LAND);
     images.items[grid_offset] = images_backup.items[grid_offset];
 }
 
 void map_image_clear(void)
 {
     map_grid_clear_u32(images.items);
+    map_routing_all_tiles_changed(ROUTING_CHANGE_LAND);
 }
 
 void map_image_init_edges(void)
@@ -56,6 +64,7 @@ void map_image_init_edges(void)
     images.items[map_grid_offset(0, height)] = 3;
     images.items[map_grid_offset(width, 0)] = 4;
     images.items[map_grid_offset(width, height)] = 5;
+    map_routing_all_tiles_changed(ROUTING_CHANGE_LAND);
 }
 
 void map_image_update_all(void)
@@ -92,4 +101,5 @@ void map_image_save_state_legacy(buffer *buf)
 void map_image_load_state_legacy(buffer *buf)
 {
     map_grid_load_state_u16_to_u32(images.items, buf);
+    map_routing_all_tiles_changed(ROUTING_CHANGE_LAND);
 }
@@ -2,6 +2,7 @@
 
 #include "map/grid.h"
 #include "map/random.h"
+#include "map/routing_terrain.h"
 
 enum {
     BIT_SIZE1 = 0x00,
@@ -98,6 +99,9 @@ int map_property_is_multi_tile_xy(int grid_offset, int x, int y)
 
 void map_property_set_multi_tile_xy(int grid_offset, int x, int y, int is_draw_tile)
 {
+    if ((edge_grid.items[grid_offset] & EDGE_MASK_XY) != edge_for(x, y)) {
+        map_routing_tile_changed(grid_offset, ROUTING_CHANGE_LAND);
+    }
     if (is_draw_tile) {
         edge_grid.items[grid_offset] = edge_for(x, y) | EDGE_LEFTMOST_TILE;
     } else {
@@ -107,6 +111,9 @@ void map_property_set_multi_tile_xy(int grid_offset, int x, int y, int is_draw_t
 
 void map_property_clear_multi_tile_xy(int grid_offset)
 {
+    if (edge_grid.items[grid_offset] & EDGE_MASK_XY) {
+        map_routing_tile_changed(grid_offset, ROUTING_CHANGE_LAND);
+    }
     // only keep native land marker
     edge_grid.items[grid_offset] &= EDGE_NATIVE_LAND;
 }
@@ -222,6 +229,7 @@ void map_property_clear(void)
 {
     map_grid_clear_u8(bitfields_grid.items);
     map_grid_clear_u8(edge_grid.items);
+    map_routing_all_tiles_changed(ROUTING_CHANGE_LAND);
 }
 
 void map_property_backup(void)
@@ -234,6 +242,7 @@ void map_property_restore(void)
 {
     map_grid_copy_u8(bitfields_backup.items, bitfields_grid.items);
     map_grid_copy_u8(edge_backup.items, edge_grid.items);
+    map_routing_all_tiles_changed(ROUTING_CHANGE_LAND);
 }
 
 void map_property_save_state(buffer *bitfields, buffer *edge)
@@ -246,4 +255,5 @@ void map_property_load_state(buffer *bitfields, buffer *edge)
 {
     map_grid_load_state_u8(bitfields_grid.items, bitfields);
     map_grid_load_state_u8(edge_grid.items, edge);
+    map_routing_all_tiles_changed(ROUTING_CHANGE_LAND);
 }
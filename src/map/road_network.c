@@ -3,6 +3,7 @@
 #include "city/map.h"
 #include "map/data.h"
 #include "map/grid.h"
+#include "map/routing_data.h"
 #include "map/routing_terrain.h"
 #include "map/terrain.h"
 
@@ -20,9 +21,18 @@ static struct {
     int tail;
 } queue;
 
+// The networks only depend on the road and access ramp terrain and on the citizen land routing grid,
+// so they are kept until one of those changes
+static struct {
+    int is_valid;
+    unsigned int road_version;
+    grid_i8 land_citizen;
+} inputs;
+
 void map_road_network_clear(void)
 {
     map_grid_clear_u8(network.items);
+    inputs.is_valid = 0;
 }
 
 int map_road_network_get(int grid_offset)
@@ -77,8 +87,40 @@ static int mark_road_network(int grid_offset, uint8_t network_id)
     return size;
 }
 
+static int network_class(int grid_offset, int land_citizen)
+{
+    // only roads, highways and passable access ramps can be part of a network
+    if (land_citizen == CITIZEN_0_ROAD || land_citizen == CITIZEN_1_HIGHWAY) {
+        return land_citizen;
+    }
+    if (land_citizen == CITIZEN_2_PASSABLE_TERRAIN && map_terrain_is(grid_offset, TERRAIN_ACCESS_RAMP)) {
+        return land_citizen;
+    }
+    return CITIZEN_N1_BLOCKED;
+}
+
+static int inputs_changed(void)
+{
+    int changed = !inputs.is_valid || inputs.road_version != map_terrain_road_version();
+    if (memcmp(inputs.land_citizen.items, terrain_land_citizen.items, sizeof(inputs.land_citizen.items))) {
+        for (int i = 0; i < GRID_SIZE * GRID_SIZE && !changed; i++) {
+            if (inputs.land_citizen.items[i] != terrain_land_citizen.items[i] &&
+                network_class(i, inputs.land_citizen.items[i]) != network_class(i, terrain_land_citizen.items[i])) {
+                changed = 1;
+            }
+        }
+        memcpy(inputs.land_citizen.items, terrain_land_citizen.items, sizeof(inputs.land_citizen.items));
+    }
+    inputs.road_version = map_terrain_road_version();
+    inputs.is_valid = 1;
+    return changed;
+}
+
 void map_road_network_update(void)
 {
+    if (!inputs_changed()) {
+        return;
+    }
     city_map_clear_largest_road_networks();
     map_grid_clear_u8(network.items);
     int network_id = 1;
@@ -1,12 +1,15 @@
 #include "routing.h"
 
 #include "building/building.h"
+#include "core/config.h"
 #include "core/time.h"
 #include "map/building.h"
 #include "map/figure.h"
 #include "map/grid.h"
 #include "map/road_aqueduct.h"
+#include "map/routing_cache.h"
 #include "map/routing_data.h"
+#include "map/routing_terrain.h"
 #include "map/terrain.h"
 #include "map/tiles.h"
 
@@ -37,23 +40,39 @@ static const int HIGHWAY_DIRECTIONS[] = {
     0
 };
 
-static map_routing_distance_grid distance;
+typedef struct {
+    int head;
+    int tail;
+    int items[MAX_QUEUE];
+    uint16_t index_of[GRID_SIZE * GRID_SIZE]; // position of a grid offset in the ordered queue
+} routing_queue;
+
+// grid offsets that have a non-zero distance, so clearing does not have to touch the whole map
+typedef struct {
+    int needs_full_clear;
+    int num_offsets;
+    int offsets[GRID_SIZE * GRID_SIZE];
+} touched_offsets;
+
+struct map_routing_context {
+    map_routing_distance_grid distance;
+    routing_queue queue;
+    touched_offsets touched;
+    int routes_calculated;
+};
+
+static map_routing_context city;
 
 static struct {
     int total_routes_calculated;
     int enemy_routes_calculated;
 } stats;
 
-static struct {
-    int head;
-    int tail;
-    int items[MAX_QUEUE];
-} queue;
-
 static grid_u8 water_drag;
 
 static struct {
     grid_u8 status;
+    int num_friendly_tiles;
     time_millis last_check;
 } fighting_data;
 
@@ -67,38 +86,104 @@ static void reset_fighting_status(void)
     time_millis current_time = time_get_millis();
     if (current_time != fighting_data.last_check) {
         map_grid_clear_u8(fighting_data.status.items);
+        fighting_data.num_friendly_tiles = 0;
         fighting_data.last_check = current_time;
     }
 }
 
 const map_routing_distance_grid *map_routing_get_distance_grid(void)
 {
-    return &distance;
+    return &city.distance;
+}
+
+map_routing_context *map_routing_context_create(void)
+{
+    return calloc(1, sizeof(map_routing_context));
+}
+
+void map_routing_context_free(map_routing_context *context)
+{
+    free(context);
+}
+
+const map_routing_distance_grid *map_routing_context_get_distance_grid(const map_routing_context *context)
+{
+    return &context->distance;
+}
+
+int map_routing_context_take_routes_calculated(map_routing_context *context)
+{
+    int routes_calculated = context->routes_calculated;
+    context->routes_calculated = 0;
+    return routes_calculated;
+}
+
+void map_routing_add_routes_calculated(int routes_calculated)
+{
+    stats.total_routes_calculated += routes_calculated;
+}
+
+int map_routing_get_routes_calculated(void)
+{
+    return stats.total_routes_calculated;
+}
+
+static inline void mark_touched(map_routing_context *context, int grid_offset)
+{
+    if (context->distance.determined.items[grid_offset] || context->distance.possible.items[grid_offset]) {
+        return;
+    }
+    if (context->touched.num_offsets < GRID_SIZE * GRID_SIZE) {
+        context->touched.offsets[context->touched.num_offsets++] = grid_offset;
+    } else {
+        context->touched.needs_full_clear = 1;
+    }
+}
+
+static void clear_distances(map_routing_context *context)
+{
+    if (context->touched.needs_full_clear) {
+        map_grid_clear_i16(context->distance.possible.items);
+        map_grid_clear_i16(context->distance.determined.items);
+        context->touched.needs_full_clear = 0;
+    } else {
+        for (int i = 0; i < context->touched.num_offsets; i++) {
+            int grid_offset = context->touched.offsets[i];
+            context->distance.possible.items[grid_offset] = 0;
+            context->distance.determined.items[grid_offset] = 0;
+        }
+    }
+    context->touched.num_offsets = 0;
+}
+
+static void clear_search(map_routing_context *context)
+{
+    clear_distances(context);
+    context->queue.head = 0;
+    context->queue.tail = 0;
 }
 
 static void clear_data(void)
 {
     reset_fighting_status();
-    map_grid_clear_i16(distance.possible.items);
-    map_grid_clear_i16(distance.determined.items);
-    queue.head = 0;
-    queue.tail = 0;
+    clear_search(&city);
 }
 
 static inline void enqueue(int next_offset, int dist)
 {
-    distance.determined.items[next_offset] = dist;
-    queue.items[queue.tail++] = next_offset;
-    if (queue.tail >= MAX_QUEUE) {
-        queue.tail = 0;
+    mark_touched(&city, next_offset);
+    city.distance.determined.items[next_offset] = dist;
+    city.queue.items[city.queue.tail++] = next_offset;
+    if (city.queue.tail >= MAX_QUEUE) {
+        city.queue.tail = 0;
     }
 }
 
 static inline int queue_pop(void)
 {
-    int result = queue.items[queue.head];
-    if (++queue.head >= MAX_QUEUE) {
-        queue.head = 0;
+    int result = city.queue.items[city.queue.head];
+    if (++city.queue.head >= MAX_QUEUE) {
+        city.queue.head = 0;
     }
     return result;
 }
@@ -108,86 +193,106 @@ static inline int ordered_queue_parent(int index)
     return (index - 1) / 2;
 }
 
-static inline void ordered_queue_swap(int first, int second)
+static inline void ordered_queue_set(routing_queue *queue, int index, int offset)
 {
-    int temp = queue.items[first];
-    queue.items[first] = queue.items[second];
-    queue.items[second] = temp;
+    queue->items[index] = offset;
+    queue->index_of[offset] = index;
 }
 
-static void ordered_queue_reorder(int start_index)
+static inline void ordered_queue_swap(routing_queue *queue, int first, int second)
 {
+    int temp = queue->items[first];
+    ordered_queue_set(queue, first, queue->items[second]);
+    ordered_queue_set(queue, second, temp);
+}
+
+static void ordered_queue_reorder(map_routing_context *context, int start_index)
+{
+    routing_queue *queue = &context->queue;
+    const int16_t *possible = context->distance.possible.items;
     int left_child = 2 * start_index + 1;
-    if (left_child >= queue.tail) {
+    if (left_child >= queue->tail) {
         return;
     }
     int right_child = left_child + 1;
     int smallest = start_index;
-    int16_t *offset_smallest = &distance.possible.items[queue.items[smallest]];
-    if (distance.possible.items[queue.items[left_child]] < *offset_smallest) {
+    const int16_t *offset_smallest = &possible[queue->items[smallest]];
+    if (possible[queue->items[left_child]] < *offset_smallest) {
         smallest = left_child;
-        offset_smallest = &distance.possible.items[queue.items[smallest]];
+        offset_smallest = &possible[queue->items[smallest]];
     }
-    if (right_child < queue.tail &&
-        distance.possible.items[queue.items[right_child]] < *offset_smallest) {
+    if (right_child < queue->tail &&
+        possible[queue->items[right_child]] < *offset_smallest) {
         smallest = right_child;
     }
     if (smallest != start_index) {
-        ordered_queue_swap(start_index, smallest);
-        ordered_queue_reorder(smallest);
+        ordered_queue_swap(queue, start_index, smallest);
+        ordered_queue_reorder(context, smallest);
     }
 }
 
-static inline int ordered_queue_pop(void)
+static inline int ordered_queue_pop(map_routing_context *context)
 {
-    int min = queue.items[0];
-    queue.items[0] = queue.items[--queue.tail];
-    ordered_queue_reorder(0);
+    routing_queue *queue = &context->queue;
+    int min = queue->items[0];
+    ordered_queue_set(queue, 0, queue->items[--queue->tail]);
+    ordered_queue_reorder(context, 0);
     return min;
 }
 
-static inline void ordered_queue_reduce_index(int index, int offset, int dist)
+static inline void ordered_queue_reduce_index(map_routing_context *context, int index, int offset, int dist)
 {
-    queue.items[index] = offset;
-    while (index && distance.possible.items[queue.items[ordered_queue_parent(index)]] > dist) {
-        ordered_queue_swap(index, ordered_queue_parent(index));
+    routing_queue *queue = &context->queue;
+    ordered_queue_set(queue, index, offset);
+    while (index && context->distance.possible.items[queue->items[ordered_queue_parent(index)]] > dist) {
+        ordered_queue_swap(queue, index, ordered_queue_parent(index));
         index = ordered_queue_parent(index);
     }
 }
 
-static void ordered_enqueue(int next_offset, int current_dist, int remaining_dist)
+static void ordered_enqueue(map_routing_context *context, int next_offset, int current_dist, int remaining_dist)
 {
+    map_routing_distance_grid *distance = &context->distance;
     int possible_dist = remaining_dist + current_dist;
-    int index = queue.tail;
-    if (distance.possible.items[next_offset]) {
-        if (distance.possible.items[next_offset] <= possible_dist) {
+    int index = context->queue.tail;
+    if (distance->possible.items[next_offset]) {
+        if (distance->possible.items[next_offset] <= possible_dist) {
             return;
         } else {
-            for (int i = 0; i < queue.tail; i++) {
-                if (queue.items[i] == next_offset) {
-                    index = i;
-                    break;
-                }
-            }
+            index = context->queue.index_of[next_offset];
         }
     } else {
-        queue.tail++;
+        context->queue.tail++;
     }
-    distance.determined.items[next_offset] = current_dist;
-    distance.possible.items[next_offset] = possible_dist;
+    mark_touched(context, next_offset);
+    distance->determined.items[next_offset] = current_dist;
+    distance->possible.items[next_offset] = possible_dist;
 
-    ordered_queue_reduce_index(index, next_offset, possible_dist);
+    ordered_queue_reduce_index(context, index, next_offset, possible_dist);
 }
 
-static inline int valid_offset(int grid_offset, int possible_dist)
+static inline int valid_offset(const map_routing_context *context, int grid_offset, int possible_dist)
 {
-    int determined = distance.determined.items[grid_offset];
+    int determined = context->distance.determined.items[grid_offset];
     return map_grid_is_valid_offset(grid_offset) && (determined == 0 || possible_dist < determined);
 }
 
-static inline int distance_left(int x, int y)
+static inline int distance_left(const map_routing_distance_grid *distance, int x, int y)
 {
-    return abs(distance.dst_x - x) + abs(distance.dst_y - y);
+    return abs(distance->dst_x - x) + abs(distance->dst_y - y);
+}
+
+static inline int goal_directed_distance_left(const map_routing_distance_grid *distance, int x, int y,
+    int num_directions, int straight_cost)
+{
+    int dx = abs(distance->dst_x - x);
+    int dy = abs(distance->dst_y - y);
+    if (num_directions == DIRECTIONS_NO_DIAGONALS) {
+        return straight_cost * (dx + dy);
+    }
+    // octile distance: a diagonal step costs 2, a straight one 2 or 1 when taking a highway
+    int diagonal = dx < dy ? dx : dy;
+    return 2 * diagonal + straight_cost * (dx + dy - 2 * diagonal);
 }
 
 static int receive_highway_bonus(int offset, int direction)
@@ -199,32 +304,42 @@ static int receive_highway_bonus(int offset, int direction)
     return 0;
 }
 
-static void route_queue_from_to(int src_x, int src_y, int dst_x, int dst_y, int num_directions, int max_tiles,
-    int (*callback)(int offset, int next_offset, int direction))
+static void route_queue_from_to(map_routing_context *context, int src_x, int src_y, int dst_x, int dst_y,
+    int num_directions, int max_tiles, int (*callback)(int offset, int next_offset, int direction))
 {
-    clear_data();
-    distance.dst_x = dst_x;
-    distance.dst_y = dst_y;
+    map_routing_distance_grid *distance = &context->distance;
+    if (context == &city) {
+        reset_fighting_status();
+    }
+    clear_search(context);
+    distance->dst_x = dst_x;
+    distance->dst_y = dst_y;
     int dest = map_grid_offset(dst_x, dst_y);
-    ordered_enqueue(map_grid_offset(src_x, src_y), 1, 0);
+    int goal_directed = config_get(CONFIG_GP_CH_GOAL_DIRECTED_ROUTING);
+    // the estimate must never exceed the real cost, so assume the cheapest step when highways exist
+    int straight_cost = map_routing_citizen_has_highways() ? 1 : 2;
+    ordered_enqueue(context, map_grid_offset(src_x, src_y), 1, 0);
     int tiles = 0;
-    while (queue.tail) {
-        int offset = ordered_queue_pop();
+    while (context->queue.tail) {
+        int offset = ordered_queue_pop(context);
         if (offset == dest || (max_tiles && ++tiles > max_tiles)) {
             break;
         }
         int x = map_grid_offset_to_x(offset);
         int y = map_grid_offset_to_y(offset);
-        distance.possible.items[offset] = 1;
+        distance->possible.items[offset] = 1;
         for (int i = 0; i < num_directions; i++) {
             int next_offset = offset + ROUTE_OFFSETS[i];
-            int remaining_dist = distance_left(x + ROUTE_OFFSETS_X[i], y + ROUTE_OFFSETS_Y[i]);
-            int dist = 2 + distance.determined.items[offset];
+            int remaining_dist = goal_directed ?
+                goal_directed_distance_left(distance, x + ROUTE_OFFSETS_X[i], y + ROUTE_OFFSETS_Y[i],
+                    num_directions, straight_cost) :
+                distance_left(distance, x + ROUTE_OFFSETS_X[i], y + ROUTE_OFFSETS_Y[i]);
+            int dist = 2 + distance->determined.items[offset];
             if (receive_highway_bonus(next_offset, i)) {
                 dist--;
             }
-            if (valid_offset(next_offset, dist) && callback(offset, next_offset, i)) {
-                ordered_enqueue(next_offset, dist, remaining_dist);
+            if (valid_offset(context, next_offset, dist) && callback(offset, next_offset, i)) {
+                ordered_enqueue(context, next_offset, dist, remaining_dist);
             }
         }
     }
@@ -237,7 +352,7 @@ static void route_queue_all_from(int source, max_directions directions,
     map_grid_clear_u8(water_drag.items);
     enqueue(source, 1);
     int tiles = 0;
-    while (queue.head != queue.tail) {
+    while (city.queue.head != city.queue.tail) {
         if (++tiles > GUARD) {
             break;
         }
@@ -245,16 +360,16 @@ static void route_queue_all_from(int source, max_directions directions,
         int drag = is_boat && terrain_water.items[offset] == WATER_N2_MAP_EDGE ? 4 : 0;
         if (water_drag.items[offset] < drag) {
             water_drag.items[offset]++;
-            queue.items[queue.tail++] = offset;
-            if (queue.tail >= MAX_QUEUE) {
-                queue.tail = 0;
+            city.queue.items[city.queue.tail++] = offset;
+            if (city.queue.tail >= MAX_QUEUE) {
+                city.queue.tail = 0;
             }
         } else {
-            int dist = 1 + distance.determined.items[offset];
+            int dist = 1 + city.distance.determined.items[offset];
             for (max_directions i = 0; i < directions; i++) {
                 int route_offset = ROUTE_OFFSETS[i];
                 int next_offset = offset + route_offset;
-                if (valid_offset(next_offset, dist)) {
+                if (valid_offset(&city, next_offset, dist)) {
                     if (callback(next_offset, dist, i) == UNTIL_STOP) {
                         break;
                     }
@@ -275,7 +390,14 @@ static int callback_calc_distance(int next_offset, int dist, int direction)
 void map_routing_calculate_distances(int x, int y)
 {
     ++stats.total_routes_calculated;
-    route_queue_all_from(map_grid_offset(x, y), DIRECTIONS_NO_DIAGONALS, callback_calc_distance, 0);
+    int source = map_grid_offset(x, y);
+    clear_distances(&city);
+    if (map_routing_cache_get_distances(source, &city.distance.determined)) {
+        city.touched.needs_full_clear = 1;
+        return;
+    }
+    route_queue_all_from(source, DIRECTIONS_NO_DIAGONALS, callback_calc_distance, 0);
+    map_routing_cache_store_distances(source, &city.distance.determined);
 }
 
 static int callback_calc_distance_water_boat(int next_offset, int dist, int direction)
@@ -284,7 +406,7 @@ static int callback_calc_distance_water_boat(int next_offset, int dist, int dire
         terrain_water.items[next_offset] != WATER_N3_LOW_BRIDGE) {
         enqueue(next_offset, dist);
         if (terrain_water.items[next_offset] == WATER_N2_MAP_EDGE) {
-            distance.determined.items[next_offset] += 4;
+            city.distance.determined.items[next_offset] += 4;
         }
     }
     return 1;
@@ -358,7 +480,8 @@ static int callback_calc_distance_build_road(int next_offset, int dist, int dire
     switch (terrain_land_citizen.items[next_offset]) {
         case CITIZEN_N3_AQUEDUCT:
             if (!map_can_place_road_under_aqueduct(next_offset)) {
-                distance.determined.items[next_offset] = -1;
+                mark_touched(&city, next_offset);
+                city.distance.determined.items[next_offset] = -1;
                 blocked = 1;
             }
             break;
@@ -401,7 +524,8 @@ static int callback_calc_distance_build_aqueduct(int next_offset, int dist, int
             break;
     }
     if (map_terrain_is(next_offset, TERRAIN_ROAD) && !map_can_place_aqueduct_on_road(next_offset)) {
-        distance.determined.items[next_offset] = -1;
+        mark_touched(&city, next_offset);
+        city.distance.determined.items[next_offset] = -1;
         blocked = 1;
     }
     if (!blocked) {
@@ -529,7 +653,9 @@ static int is_fighting_friendly(figure *f)
 static inline int has_fighting_friendly(int grid_offset)
 {
     if (!(fighting_data.status.items[grid_offset] & 0x80)) {
-        fighting_data.status.items[grid_offset] |= 0x80 | map_figure_foreach_until(grid_offset, is_fighting_friendly);
+        int has_friendly = map_figure_foreach_until(grid_offset, is_fighting_friendly);
+        fighting_data.status.items[grid_offset] |= 0x80 | has_friendly;
+        fighting_data.num_friendly_tiles += has_friendly;
     }
     return fighting_data.status.items[grid_offset] & 1;
 }
@@ -547,6 +673,11 @@ static inline int has_fighting_enemy(int grid_offset)
     return fighting_data.status.items[grid_offset] & 2;
 }
 
+int map_routing_has_cached_fighting_friendly(void)
+{
+    return fighting_data.num_friendly_tiles > 0;
+}
+
 static int callback_travel_citizen_land(int offset, int next_offset, int direction)
 {
     if (terrain_land_citizen.items[next_offset] >= 0 && !has_fighting_friendly(next_offset)) {
@@ -558,8 +689,40 @@ static int callback_travel_citizen_land(int offset, int next_offset, int directi
 int map_routing_citizen_can_travel_over_land(int src_x, int src_y, int dst_x, int dst_y, int num_directions)
 {
     ++stats.total_routes_calculated;
-    route_queue_from_to(src_x, src_y, dst_x, dst_y, num_directions, 0, callback_travel_citizen_land);
-    return distance.determined.items[map_grid_offset(dst_x, dst_y)] != 0;
+    // an unreachable destination would otherwise flood the whole connected area
+    if (!map_routing_cache_citizen_can_reach_over_land(map_grid_offset(src_x, src_y),
+            map_grid_offset(dst_x, dst_y), num_directions)) {
+        return 0;
+    }
+    route_queue_from_to(&city, src_x, src_y, dst_x, dst_y, num_directions, 0, callback_travel_citizen_land);
+    return city.distance.determined.items[map_grid_offset(dst_x, dst_y)] != 0;
+}
+
+static int callback_travel_citizen_land_ignoring_fights(int offset, int next_offset, int direction)
+{
+    return terrain_land_citizen.items[next_offset] >= 0;
+}
+
+int map_routing_context_citizen_can_travel_over_land(map_routing_context *context,
+    int src_x, int src_y, int dst_x, int dst_y, int num_directions)
+{
+    ++context->routes_calculated;
+    if (!map_routing_cache_citizen_can_reach_over_land_concurrent(map_grid_offset(src_x, src_y),
+            map_grid_offset(dst_x, dst_y), num_directions)) {
+        return 0;
+    }
+    route_queue_from_to(context, src_x, src_y, dst_x, dst_y, num_directions, 0,
+        callback_travel_citizen_land_ignoring_fights);
+    return context->distance.determined.items[map_grid_offset(dst_x, dst_y)] != 0;
+}
+
+static void count_route(map_routing_context *context)
+{
+    if (context == &city) {
+        ++stats.total_routes_calculated;
+    } else {
+        ++context->routes_calculated;
+    }
 }
 
 static int callback_travel_citizen_road_garden(int offset, int next_offset, int direction)
@@ -571,16 +734,22 @@ static int callback_travel_citizen_road_garden(int offset, int next_offset, int
     return 0;
 }
 
-int map_routing_citizen_can_travel_over_road_garden(int src_x, int src_y, int dst_x, int dst_y, int num_directions)
+int map_routing_context_citizen_can_travel_over_road_garden(map_routing_context *context,
+    int src_x, int src_y, int dst_x, int dst_y, int num_directions)
 {
     int dst_offset = map_grid_offset(dst_x, dst_y);
     if (terrain_land_citizen.items[dst_offset] != CITIZEN_0_ROAD &&
         terrain_land_citizen.items[dst_offset] != CITIZEN_2_PASSABLE_TERRAIN) {
         return 0;
     }
-    ++stats.total_routes_calculated;
-    route_queue_from_to(src_x, src_y, dst_x, dst_y, num_directions, 0, callback_travel_citizen_road_garden);
-    return distance.determined.items[dst_offset] != 0;
+    count_route(context);
+    route_queue_from_to(context, src_x, src_y, dst_x, dst_y, num_directions, 0, callback_travel_citizen_road_garden);
+    return context->distance.determined.items[dst_offset] != 0;
+}
+
+int map_routing_citizen_can_travel_over_road_garden(int src_x, int src_y, int dst_x, int dst_y, int num_directions)
+{
+    return map_routing_context_citizen_can_travel_over_road_garden(&city, src_x, src_y, dst_x, dst_y, num_directions);
 }
 
 static int callback_travel_citizen_road_garden_highway(int offset, int next_offset, int direction)
@@ -592,16 +761,24 @@ static int callback_travel_citizen_road_garden_highway(int offset, int next_offs
     return 0;
 }
 
-int map_routing_citizen_can_travel_over_road_garden_highway(int src_x, int src_y, int dst_x, int dst_y, int num_directions)
+int map_routing_context_citizen_can_travel_over_road_garden_highway(map_routing_context *context,
+    int src_x, int src_y, int dst_x, int dst_y, int num_directions)
 {
     int dst_offset = map_grid_offset(dst_x, dst_y);
     if (terrain_land_citizen.items[dst_offset] < CITIZEN_0_ROAD ||
         terrain_land_citizen.items[dst_offset] > CITIZEN_2_PASSABLE_TERRAIN) {
         return 0;
     }
-    ++stats.total_routes_calculated;
-    route_queue_from_to(src_x, src_y, dst_x, dst_y, num_directions, 0, callback_travel_citizen_road_garden_highway);
-    return distance.determined.items[dst_offset] != 0;
+    count_route(context);
+    route_queue_from_to(context, src_x, src_y, dst_x, dst_y, num_directions, 0,
+        callback_travel_citizen_road_garden_highway);
+    return context->distance.determined.items[dst_offset] != 0;
+}
+
+int map_routing_citizen_can_travel_over_road_garden_highway(int src_x, int src_y, int dst_x, int dst_y, int num_directions)
+{
+    return map_routing_context_citizen_can_travel_over_road_garden_highway(&city,
+        src_x, src_y, dst_x, dst_y, num_directions);
 }
 
 static int callback_travel_walls(int offset, int next_offset, int direction)
@@ -616,8 +793,8 @@ static int callback_travel_walls(int offset, int next_offset, int direction)
 int map_routing_can_travel_over_walls(int src_x, int src_y, int dst_x, int dst_y, int num_directions)
 {
     ++stats.total_routes_calculated;
-    route_queue_from_to(src_x, src_y, dst_x, dst_y, num_directions, 0, callback_travel_walls);
-    return distance.determined.items[map_grid_offset(dst_x, dst_y)] != 0;
+    route_queue_from_to(&city, src_x, src_y, dst_x, dst_y, num_directions, 0, callback_travel_walls);
+    return city.distance.determined.items[map_grid_offset(dst_x, dst_y)] != 0;
 }
 
 static int callback_travel_noncitizen_land_through_building(int offset, int next_offset, int direction)
@@ -658,11 +835,11 @@ int map_routing_noncitizen_can_travel_over_land(
         state.through_building_id = only_through_building_id;
         // due to formation offsets, the destination building may not be the same as the "through building" (a.k.a. target building)
         state.dest_building_id = map_building_at(map_grid_offset(dst_x, dst_y));
-        route_queue_from_to(src_x, src_y, dst_x, dst_y, num_directions, 0, callback_travel_noncitizen_land_through_building);
+        route_queue_from_to(&city, src_x, src_y, dst_x, dst_y, num_directions, 0, callback_travel_noncitizen_land_through_building);
     } else {
-        route_queue_from_to(src_x, src_y, dst_x, dst_y, num_directions, max_tiles, callback_travel_noncitizen_land);
+        route_queue_from_to(&city, src_x, src_y, dst_x, dst_y, num_directions, max_tiles, callback_travel_noncitizen_land);
     }
-    return distance.determined.items[map_grid_offset(dst_x, dst_y)] != 0;
+    return city.distance.determined.items[map_grid_offset(dst_x, dst_y)] != 0;
 }
 
 static int callback_travel_noncitizen_through_everything(int offset, int next_offset, int direction)
@@ -676,8 +853,8 @@ static int callback_travel_noncitizen_through_everything(int offset, int next_of
 int map_routing_noncitizen_can_travel_through_everything(int src_x, int src_y, int dst_x, int dst_y, int num_directions)
 {
     ++stats.total_routes_calculated;
-    route_queue_from_to(src_x, src_y, dst_x, dst_y, num_directions, 0, callback_travel_noncitizen_through_everything);
-    return distance.determined.items[map_grid_offset(dst_x, dst_y)] != 0;
+    route_queue_from_to(&city, src_x, src_y, dst_x, dst_y, num_directions, 0, callback_travel_noncitizen_through_everything);
+    return city.distance.determined.items[map_grid_offset(dst_x, dst_y)] != 0;
 }
 
 void map_routing_block(int x, int y, int size)
@@ -687,14 +864,14 @@ void map_routing_block(int x, int y, int size)
     }
     for (int dy = 0; dy < size; dy++) {
         for (int dx = 0; dx < size; dx++) {
-            distance.determined.items[map_grid_offset(x + dx, y + dy)] = 0;
+            city.distance.determined.items[map_grid_offset(x + dx, y + dy)] = 0;
         }
     }
 }
 
 int map_routing_distance(int grid_offset)
 {
-    return distance.determined.items[grid_offset];
+    return city.distance.determined.items[grid_offset];
 }
 
 void map_routing_save_state(buffer *buf)
@@ -21,6 +21,17 @@ typedef struct map_routing_distance_grid {
 
 const map_routing_distance_grid *map_routing_get_distance_grid(void);
 
+// A routing context holds the state of one route search, so that citizen routes can be searched
+// for on several threads at once. Searches in a context do not check for fighting soldiers.
+typedef struct map_routing_context map_routing_context;
+
+map_routing_context *map_routing_context_create(void);
+void map_routing_context_free(map_routing_context *context);
+const map_routing_distance_grid *map_routing_context_get_distance_grid(const map_routing_context *context);
+int map_routing_context_take_routes_calculated(map_routing_context *context);
+void map_routing_add_routes_calculated(int routes_calculated);
+int map_routing_get_routes_calculated(void);
+
 void map_routing_calculate_distances(int x, int y);
 void map_routing_calculate_distances_water_boat(int x, int y);
 void map_routing_calculate_distances_water_flotsam(int x, int y);
@@ -34,6 +45,14 @@ int map_routing_distance(int grid_offset);
 int map_routing_citizen_can_travel_over_land(int src_x, int src_y, int dst_x, int dst_y, int num_directions);
 int map_routing_citizen_can_travel_over_road_garden(int src_x, int src_y, int dst_x, int dst_y, int num_directions);
 int map_routing_citizen_can_travel_over_road_garden_highway(int src_x, int src_y, int dst_x, int dst_y, int num_directions);
+int map_routing_has_cached_fighting_friendly(void);
+
+int map_routing_context_citizen_can_travel_over_land(map_routing_context *context,
+    int src_x, int src_y, int dst_x, int dst_y, int num_directions);
+int map_routing_context_citizen_can_travel_over_road_garden(map_routing_context *context,
+    int src_x, int src_y, int dst_x, int dst_y, int num_directions);
+int map_routing_context_citizen_can_travel_over_road_garden_highway(map_routing_context *context,
+    int src_x, int src_y, int dst_x, int dst_y, int num_directions);
 int map_routing_can_travel_over_walls(int src_x, int src_y, int dst_x, int dst_y, int num_directions);
 
 int map_routing_noncitizen_can_travel_over_land(
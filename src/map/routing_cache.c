@@ -0,0 +1,389 @@
+#include "routing_cache.h"
+
+#include "map/routing_data.h"
+
+#include <string.h>
+
+// The map is split into square clusters. Each cluster labels its own connected regions of
+// passable land and keeps the links from its regions to the regions of later clusters that
+// touch them. When the terrain changes, only the clusters that changed are labelled again,
+// and only they and their neighbours look for links again. The links of all clusters are then
+// joined into a coarse region graph, which takes time in the number of regions, not tiles.
+#define CLUSTER_SIZE 18
+#define CLUSTERS_PER_ROW (GRID_SIZE / CLUSTER_SIZE)
+#define NUM_CLUSTERS (CLUSTERS_PER_ROW * CLUSTERS_PER_ROW)
+#define REGIONS_PER_CLUSTER (CLUSTER_SIZE * CLUSTER_SIZE)
+#define MAX_REGIONS (NUM_CLUSTERS * REGIONS_PER_CLUSTER + 1)
+// every border tile touches at most three tiles of other clusters, except for the four corners
+#define MAX_LINKS_PER_CLUSTER (4 * 3 * CLUSTER_SIZE)
+
+#define MAX_DISTANCE_FIELDS 4
+
+typedef struct {
+    uint16_t region;
+    uint16_t other_region;
+} region_link;
+
+typedef struct {
+    int num_regions;
+    int num_links;
+    region_link links[MAX_LINKS_PER_CLUSTER];
+} cluster_regions;
+
+typedef struct {
+    int direction_step; // 2 when only moving in straight lines, 1 when diagonals are allowed
+    int is_dirty;
+    uint8_t dirty_clusters[NUM_CLUSTERS];
+    grid_u16 region;
+    uint16_t parent[MAX_REGIONS];
+    cluster_regions clusters[NUM_CLUSTERS];
+} region_graph;
+
+typedef struct {
+    int in_use;
+    int source_offset;
+    unsigned int generation;
+    unsigned int last_used;
+    grid_i16 determined;
+} distance_field;
+
+static struct {
+    int initialized;
+    unsigned int generation;
+    unsigned int use_counter;
+    grid_i8 land_citizen;
+    region_graph graphs[2];
+    distance_field distances[MAX_DISTANCE_FIELDS];
+} data;
+
+static void mark_cluster_dirty(int cluster)
+{
+    for (int i = 0; i < 2; i++) {
+        data.graphs[i].dirty_clusters[cluster] = 1;
+        data.graphs[i].is_dirty = 1;
+    }
+}
+
+static void init(void)
+{
+    if (data.initialized) {
+        return;
+    }
+    data.graphs[0].direction_step = 2;
+    data.graphs[1].direction_step = 1;
+    for (int cluster = 0; cluster < NUM_CLUSTERS; cluster++) {
+        mark_cluster_dirty(cluster);
+    }
+    memcpy(data.land_citizen.items, terrain_land_citizen.items, sizeof(data.land_citizen.items));
+    data.initialized = 1;
+}
+
+static int cluster_start_offset(int cluster)
+{
+    return (cluster / CLUSTERS_PER_ROW) * CLUSTER_SIZE * GRID_SIZE + (cluster % CLUSTERS_PER_ROW) * CLUSTER_SIZE;
+}
+
+static int cluster_for_offset(int grid_offset)
+{
+    return (grid_offset / GRID_SIZE / CLUSTER_SIZE) * CLUSTERS_PER_ROW + (grid_offset % GRID_SIZE) / CLUSTER_SIZE;
+}
+
+static int update_cluster_copy(int cluster)
+{
+    int changed = 0;
+    int grid_offset = cluster_start_offset(cluster);
+    for (int y = 0; y < CLUSTER_SIZE; y++, grid_offset += GRID_SIZE) {
+        if (memcmp(&data.land_citizen.items[grid_offset], &terrain_land_citizen.items[grid_offset], CLUSTER_SIZE)) {
+            memcpy(&data.land_citizen.items[grid_offset], &terrain_land_citizen.items[grid_offset], CLUSTER_SIZE);
+            changed = 1;
+        }
+    }
+    return changed;
+}
+
+int map_routing_cache_refresh(void)
+{
+    if (!data.initialized) {
+        init();
+        data.generation++;
+        return 1;
+    }
+    int changed = 0;
+    for (int cluster = 0; cluster < NUM_CLUSTERS; cluster++) {
+        if (update_cluster_copy(cluster)) {
+            mark_cluster_dirty(cluster);
+            changed = 1;
+        }
+    }
+    if (changed) {
+        data.generation++;
+    }
+    return changed;
+}
+
+int map_routing_cache_refresh_tiles(const int *grid_offsets, int num_tiles)
+{
+    if (!data.initialized) {
+        init();
+        data.generation++;
+        return 1;
+    }
+    int changed = 0;
+    for (int i = 0; i < num_tiles; i++) {
+        int grid_offset = grid_offsets[i];
+        if (data.land_citizen.items[grid_offset] != terrain_land_citizen.items[grid_offset]) {
+            data.land_citizen.items[grid_offset] = terrain_land_citizen.items[grid_offset];
+            mark_cluster_dirty(cluster_for_offset(grid_offset));
+            changed = 1;
+        }
+    }
+    if (changed) {
+        data.generation++;
+    }
+    return changed;
+}
+
+int map_routing_cache_get_distances(int source_offset, grid_i16 *determined)
+{
+    for (int i = 0; i < MAX_DISTANCE_FIELDS; i++) {
+        distance_field *field = &data.distances[i];
+        if (field->in_use && field->source_offset == source_offset && field->generation == data.generation) {
+            field->last_used = ++data.use_counter;
+            memcpy(determined->items, field->determined.items, sizeof(determined->items));
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void map_routing_cache_store_distances(int source_offset, const grid_i16 *determined)
+{
+    distance_field *oldest = &data.distances[0];
+    for (int i = 0; i < MAX_DISTANCE_FIELDS; i++) {
+        distance_field *field = &data.distances[i];
+        if (!field->in_use || field->generation != data.generation) {
+            oldest = field;
+            break;
+        }
+        if (field->last_used < oldest->last_used) {
+            oldest = field;
+        }
+    }
+    oldest->in_use = 1;
+    oldest->source_offset = source_offset;
+    oldest->generation = data.generation;
+    oldest->last_used = ++data.use_counter;
+    memcpy(oldest->determined.items, determined->items, sizeof(oldest->determined.items));
+}
+
+static inline int is_passable(int grid_offset)
+{
+    return data.land_citizen.items[grid_offset] >= CITIZEN_0_ROAD;
+}
+
+static void label_cluster(region_graph *graph, int cluster)
+{
+    static int stack[REGIONS_PER_CLUSTER];
+    int start_offset = cluster_start_offset(cluster);
+    for (int y = 0; y < CLUSTER_SIZE; y++) {
+        memset(&graph->region.items[start_offset + y * GRID_SIZE], 0, CLUSTER_SIZE * sizeof(uint16_t));
+    }
+    int region = cluster * REGIONS_PER_CLUSTER;
+    for (int y = 0; y < CLUSTER_SIZE; y++) {
+        for (int x = 0; x < CLUSTER_SIZE; x++) {
+            int grid_offset = start_offset + y * GRID_SIZE + x;
+            if (!is_passable(grid_offset) || graph->region.items[grid_offset]) {
+                continue;
+            }
+            graph->region.items[grid_offset] = ++region;
+            int stack_size = 0;
+            stack[stack_size++] = grid_offset;
+            while (stack_size) {
+                int offset = stack[--stack_size];
+                for (int direction = 0; direction < 8; direction += graph->direction_step) {
+                    int next_offset = offset + map_grid_direction_delta(direction);
+                    if (map_grid_is_valid_offset(next_offset) && cluster_for_offset(next_offset) == cluster &&
+                        is_passable(next_offset) && !graph->region.items[next_offset]) {
+                        graph->region.items[next_offset] = region;
+                        stack[stack_size++] = next_offset;
+                    }
+                }
+            }
+        }
+    }
+    graph->clusters[cluster].num_regions = region - cluster * REGIONS_PER_CLUSTER;
+}
+
+static int find_root(region_graph *graph, int region)
+{
+    while (graph->parent[region] != region) {
+        graph->parent[region] = graph->parent[graph->parent[region]];
+        region = graph->parent[region];
+    }
+    return region;
+}
+
+static int find_root_read_only(const region_graph *graph, int region)
+{
+    while (graph->parent[region] != region) {
+        region = graph->parent[region];
+    }
+    return region;
+}
+
+static void join_regions(region_graph *graph, int first, int second)
+{
+    first = find_root(graph, first);
+    second = find_root(graph, second);
+    if (first < second) {
+        graph->parent[second] = first;
+    } else if (second < first) {
+        graph->parent[first] = second;
+    }
+}
+
+static int cluster_border_step(int y)
+{
+    return y == 0 || y == CLUSTER_SIZE - 1 ? 1 : CLUSTER_SIZE - 1;
+}
+
+static void mark_neighbour_links_dirty(const region_graph *graph, int cluster, uint8_t *dirty_links)
+{
+    int start_offset = cluster_start_offset(cluster);
+    dirty_links[cluster] = 1;
+    for (int y = 0; y < CLUSTER_SIZE; y++) {
+        for (int x = 0; x < CLUSTER_SIZE; x += cluster_border_step(y)) {
+            int grid_offset = start_offset + y * GRID_SIZE + x;
+            for (int direction = 0; direction < 8; direction += graph->direction_step) {
+                int next_offset = grid_offset + map_grid_direction_delta(direction);
+                if (map_grid_is_valid_offset(next_offset) && cluster_for_offset(next_offset) < cluster) {
+                    dirty_links[cluster_for_offset(next_offset)] = 1;
+                }
+            }
+        }
+    }
+}
+
+static void find_links(region_graph *graph, int cluster)
+{
+    cluster_regions *regions = &graph->clusters[cluster];
+    regions->num_links = 0;
+    int start_offset = cluster_start_offset(cluster);
+    for (int y = 0; y < CLUSTER_SIZE; y++) {
+        for (int x = 0; x < CLUSTER_SIZE; x += cluster_border_step(y)) {
+            int grid_offset = start_offset + y * GRID_SIZE + x;
+            int region = graph->region.items[grid_offset];
+            if (!region) {
+                continue;
+            }
+            for (int direction = 0; direction < 8; direction += graph->direction_step) {
+                int next_offset = grid_offset + map_grid_direction_delta(direction);
+                // a link between two clusters is kept by the first one only
+                if (!map_grid_is_valid_offset(next_offset) || !graph->region.items[next_offset] ||
+                    cluster_for_offset(next_offset) <= cluster) {
+                    continue;
+                }
+                int other_region = graph->region.items[next_offset];
+                region_link *last = regions->num_links ? &regions->links[regions->num_links - 1] : 0;
+                if (!last || last->region != region || last->other_region != other_region) {
+                    regions->links[regions->num_links].region = region;
+                    regions->links[regions->num_links].other_region = other_region;
+                    regions->num_links++;
+                }
+            }
+        }
+    }
+}
+
+static void update_graph(region_graph *graph)
+{
+    static uint8_t dirty_links[NUM_CLUSTERS];
+    memset(dirty_links, 0, sizeof(dirty_links));
+    for (int cluster = 0; cluster < NUM_CLUSTERS; cluster++) {
+        if (graph->dirty_clusters[cluster]) {
+            label_cluster(graph, cluster);
+            mark_neighbour_links_dirty(graph, cluster, dirty_links);
+            graph->dirty_clusters[cluster] = 0;
+        }
+    }
+    for (int cluster = 0; cluster < NUM_CLUSTERS; cluster++) {
+        if (dirty_links[cluster]) {
+            find_links(graph, cluster);
+        }
+    }
+    // removing a link can split a region anywhere on the map, so the region graph is joined again,
+    // but only from the regions and links of the clusters
+    for (int cluster = 0; cluster < NUM_CLUSTERS; cluster++) {
+        int first_region = cluster * REGIONS_PER_CLUSTER + 1;
+        int last_region = first_region + graph->clusters[cluster].num_regions;
+        for (int region = first_region; region < last_region; region++) {
+            graph->parent[region] = region;
+        }
+    }
+    for (int cluster = 0; cluster < NUM_CLUSTERS; cluster++) {
+        const cluster_regions *regions = &graph->clusters[cluster];
+        for (int i = 0; i < regions->num_links; i++) {
+            join_regions(graph, regions->links[i].region, regions->links[i].other_region);
+        }
+    }
+    graph->is_dirty = 0;
+}
+
+static int can_reach_over_land(region_graph *graph, int src_offset, int dst_offset, int read_only)
+{
+    if (!graph->region.items[dst_offset]) {
+        return 0;
+    }
+    int dst_region = read_only ? find_root_read_only(graph, graph->region.items[dst_offset]) :
+        find_root(graph, graph->region.items[dst_offset]);
+    // the source tile itself may be blocked (a figure leaving a building), so check its neighbours
+    for (int direction = 0; direction < 8; direction += graph->direction_step) {
+        int next_offset = src_offset + map_grid_direction_delta(direction);
+        if (!map_grid_is_valid_offset(next_offset) || !graph->region.items[next_offset]) {
+            continue;
+        }
+        int region = read_only ? find_root_read_only(graph, graph->region.items[next_offset]) :
+            find_root(graph, graph->region.items[next_offset]);
+        if (region == dst_region) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int map_routing_cache_citizen_can_reach_over_land(int src_offset, int dst_offset, int num_directions)
+{
+    if (src_offset == dst_offset ||
+        !map_grid_is_valid_offset(src_offset) || !map_grid_is_valid_offset(dst_offset)) {
+        return 1;
+    }
+    init();
+    region_graph *graph = &data.graphs[num_directions == 8 ? 1 : 0];
+    if (graph->is_dirty) {
+        update_graph(graph);
+    }
+    return can_reach_over_land(graph, src_offset, dst_offset, 0);
+}
+
+void map_routing_cache_update_regions(void)
+{
+    init();
+    for (int i = 0; i < 2; i++) {
+        if (data.graphs[i].is_dirty) {
+            update_graph(&data.graphs[i]);
+        }
+    }
+}
+
+int map_routing_cache_citizen_can_reach_over_land_concurrent(int src_offset, int dst_offset, int num_directions)
+{
+    if (src_offset == dst_offset || !data.initialized ||
+        !map_grid_is_valid_offset(src_offset) || !map_grid_is_valid_offset(dst_offset)) {
+        return 1;
+    }
+    region_graph *graph = &data.graphs[num_directions == 8 ? 1 : 0];
+    if (graph->is_dirty) {
+        return 1;
+    }
+    return can_reach_over_land(graph, src_offset, dst_offset, 1);
+}
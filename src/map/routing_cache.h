@@ -0,0 +1,64 @@
+#ifndef MAP_ROUTING_CACHE_H
+#define MAP_ROUTING_CACHE_H
+
+#include "map/grid.h"
+
+/**
+ * Compares the citizen land routing grid with the copy the cache was built from
+ * and invalidates everything that depends on the parts of the map that changed.
+ * Must be called whenever terrain_land_citizen is updated.
+ * @return 1 if the citizen land routing grid changed, 0 otherwise
+ */
+int map_routing_cache_refresh(void);
+
+/**
+ * Same as map_routing_cache_refresh, but only compares the given tiles.
+ * Must be called instead of it when only these tiles of terrain_land_citizen were updated.
+ * @param grid_offsets The tiles that were updated
+ * @param num_tiles Number of tiles
+ * @return 1 if the citizen land routing grid changed, 0 otherwise
+ */
+int map_routing_cache_refresh_tiles(const int *grid_offsets, int num_tiles);
+
+/**
+ * Gets a previously stored citizen land distance field
+ * @param source_offset Grid offset the distances were calculated from
+ * @param determined Grid to copy the distances to
+ * @return 1 if the distances were found in the cache, 0 otherwise
+ */
+int map_routing_cache_get_distances(int source_offset, grid_i16 *determined);
+
+/**
+ * Stores a citizen land distance field, replacing the least recently used one
+ * @param source_offset Grid offset the distances were calculated from
+ * @param determined The calculated distances
+ */
+void map_routing_cache_store_distances(int source_offset, const grid_i16 *determined);
+
+/**
+ * Checks whether the destination lies in a land region that can be entered from the source.
+ * @param src_offset Grid offset to start from
+ * @param dst_offset Grid offset of the destination
+ * @param num_directions 4 or 8
+ * @return 0 if a citizen can certainly not walk from source to destination, 1 otherwise
+ */
+int map_routing_cache_citizen_can_reach_over_land(int src_offset, int dst_offset, int num_directions);
+
+/**
+ * Brings the region graphs up to date, so that they can be queried from several threads
+ * with map_routing_cache_citizen_can_reach_over_land_concurrent.
+ */
+void map_routing_cache_update_regions(void);
+
+/**
+ * Same as map_routing_cache_citizen_can_reach_over_land, but does not change the cache,
+ * so it can be called from several threads at once.
+ * Returns 1 when the regions are out of date.
+ * @param src_offset Grid offset to start from
+ * @param dst_offset Grid offset of the destination
+ * @param num_directions 4 or 8
+ * @return 0 if a citizen can certainly not walk from source to destination, 1 otherwise
+ */
+int map_routing_cache_citizen_can_reach_over_land_concurrent(int src_offset, int dst_offset, int num_directions);
+
+#endif // MAP_ROUTING_CACHE_H
@@ -9,8 +9,6 @@
 
 #define MAX_PATH 500
 
-static int direction_path[MAX_PATH];
-
 static void adjust_tile_in_direction(int direction, int *x, int *y, int *grid_offset)
 {
     switch (direction) {
@@ -86,10 +84,11 @@ static int next_is_better(
     return 0;
 }
 
-int map_routing_get_path(uint8_t *path, int dst_x, int dst_y, int num_directions)
+static int get_path(const int16_t *distances, uint8_t *path, int dst_x, int dst_y, int num_directions)
 {
+    int direction_path[MAX_PATH];
     int dst_grid_offset = map_grid_offset(dst_x, dst_y);
-    int distance = map_routing_distance(dst_grid_offset);
+    int distance = distances[dst_grid_offset];
     if (distance <= 0 || distance >= 998) {
         return 0;
     }
@@ -102,14 +101,14 @@ int map_routing_get_path(uint8_t *path, int dst_x, int dst_y, int num_directions
     int step = num_directions == 8 ? 1 : 2;
 
     while (distance > 1) {
-        int base_distance = map_routing_distance(grid_offset);
+        int base_distance = distances[grid_offset];
         distance = base_distance;
         int direction = -1;
         int is_highway = 0;
         for (int next_direction = 0; next_direction < 8; next_direction += step) {
             if (next_direction != last_direction) {
                 int next_offset = grid_offset + map_grid_direction_delta(next_direction);
-                int next_distance = map_routing_distance(next_offset);
+                int next_distance = distances[next_offset];
                 int next_is_highway = map_terrain_is(next_offset, TERRAIN_HIGHWAY);
                 if (next_distance && next_is_better(base_distance, distance, next_distance,
                         direction, next_direction, is_highway, next_is_highway)) {
@@ -136,8 +135,21 @@ int map_routing_get_path(uint8_t *path, int dst_x, int dst_y, int num_directions
     return num_tiles;
 }
 
+int map_routing_get_path(uint8_t *path, int dst_x, int dst_y, int num_directions)
+{
+    return get_path(map_routing_get_distance_grid()->determined.items, path, dst_x, dst_y, num_directions);
+}
+
+int map_routing_context_get_path(const map_routing_context *context, uint8_t *path,
+    int dst_x, int dst_y, int num_directions)
+{
+    return get_path(map_routing_context_get_distance_grid(context)->determined.items,
+        path, dst_x, dst_y, num_directions);
+}
+
 int map_routing_get_path_on_water(uint8_t *path, int dst_x, int dst_y, int is_flotsam)
 {
+    int direction_path[MAX_PATH];
     int rand = random_byte() & 3;
     int dst_grid_offset = map_grid_offset(dst_x, dst_y);
     int distance = map_routing_distance(dst_grid_offset);
@@ -4,17 +4,178 @@
 #include "city/view.h"
 #include "core/direction.h"
 #include "core/image.h"
+#include "core/log.h"
 #include "map/building.h"
 #include "map/data.h"
 #include "map/image.h"
 #include "map/property.h"
 #include "map/random.h"
+#include "map/routing_cache.h"
 #include "map/routing_data.h"
 #include "map/sprite.h"
 #include "map/terrain.h"
 
+#include <stdlib.h>
+#include <string.h>
+
+// Tiles whose terrain, building, image or sprite changed are kept in a journal for each routing grid,
+// so the grids are only updated on those tiles and on the neighbouring tiles that depend on them.
+// When too many tiles changed, or a whole map grid was replaced, the routing grid is rebuilt.
+#define MAX_CHANGED_TILES (GRID_SIZE * GRID_SIZE / 8)
+
+enum {
+    GRID_LAND_CITIZEN = 0,
+    GRID_LAND_NONCITIZEN = 1,
+    GRID_WATER = 2,
+    GRID_WALLS = 3,
+    NUM_ROUTING_GRIDS = 4
+};
+
+typedef struct {
+    int *items;
+    int size;
+    int capacity;
+} tile_list;
+
+typedef struct {
+    int all_changed;
+    tile_list changed;
+    tile_list updating;
+} tile_journal;
+
+typedef void (*tile_updater)(int grid_offset, int x, int y);
+
 static void map_routing_update_land_noncitizen(void);
 
+static int has_highways;
+static unsigned int land_citizen_version;
+
+static struct {
+    grid_u8 is_changed;
+    tile_journal journals[NUM_ROUTING_GRIDS];
+    int walls_orientation;
+    grid_u8 is_highway;
+    int num_highway_tiles;
+} journal = {
+    .journals = { { 1 }, { 1 }, { 1 }, { 1 } }
+};
+
+static void mark_tile(int grid, int grid_offset)
+{
+    tile_journal *tiles = &journal.journals[grid];
+    uint8_t grid_bit = 1 << grid;
+    if (tiles->all_changed || !map_grid_is_valid_offset(grid_offset) ||
+        (journal.is_changed.items[grid_offset] & grid_bit)) {
+        return;
+    }
+    tile_list *list = &tiles->changed;
+    if (list->size == list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 256;
+        int *items = capacity <= MAX_CHANGED_TILES ? realloc(list->items, capacity * sizeof(int)) : 0;
+        if (!items) {
+            tiles->all_changed = 1;
+            return;
+        }
+        list->items = items;
+        list->capacity = capacity;
+    }
+    journal.is_changed.items[grid_offset] |= grid_bit;
+    list->items[list->size++] = grid_offset;
+}
+
+void map_routing_tile_changed(int grid_offset, int changes)
+{
+    if (changes & ROUTING_CHANGE_LAND) {
+        mark_tile(GRID_LAND_CITIZEN, grid_offset);
+        mark_tile(GRID_LAND_NONCITIZEN, grid_offset);
+    }
+    if (changes & ROUTING_CHANGE_WATER) {
+        // water tiles depend on their direct neighbours
+        mark_tile(GRID_WATER, grid_offset);
+        mark_tile(GRID_WATER, grid_offset + map_grid_delta(0, -1));
+        mark_tile(GRID_WATER, grid_offset + map_grid_delta(-1, 0));
+        mark_tile(GRID_WATER, grid_offset + map_grid_delta(1, 0));
+        mark_tile(GRID_WATER, grid_offset + map_grid_delta(0, 1));
+    }
+    if (changes & ROUTING_CHANGE_WALLS) {
+        // wall tiles depend on all their neighbours
+        for (int dy = -1; dy <= 1; dy++) {
+            for (int dx = -1; dx <= 1; dx++) {
+                mark_tile(GRID_WALLS, grid_offset + map_grid_delta(dx, dy));
+            }
+        }
+    }
+}
+
+void map_routing_all_tiles_changed(int changes)
+{
+    if (changes & ROUTING_CHANGE_LAND) {
+        journal.journals[GRID_LAND_CITIZEN].all_changed = 1;
+        journal.journals[GRID_LAND_NONCITIZEN].all_changed = 1;
+    }
+    if (changes & ROUTING_CHANGE_WATER) {
+        journal.journals[GRID_WATER].all_changed = 1;
+    }
+    if (changes & ROUTING_CHANGE_WALLS) {
+        journal.journals[GRID_WALLS].all_changed = 1;
+    }
+}
+
+static void update_all_tiles(tile_updater update_tile)
+{
+    int grid_offset = map_data.start_offset;
+    for (int y = 0; y < map_data.height; y++, grid_offset += map_data.border_size) {
+        for (int x = 0; x < map_data.width; x++, grid_offset++) {
+            update_tile(grid_offset, x, y);
+        }
+    }
+}
+
+// Takes the changed tiles out of the journal, so tiles that change while updating are kept for the next update.
+// Returns 0 when the whole grid has to be updated.
+static const tile_list *take_changed_tiles(int grid)
+{
+    tile_journal *tiles = &journal.journals[grid];
+    tile_list list = tiles->updating;
+    tiles->updating = tiles->changed;
+    tiles->changed = list;
+    tiles->changed.size = 0;
+
+    uint8_t grid_bit = 1 << grid;
+    for (int i = 0; i < tiles->updating.size; i++) {
+        journal.is_changed.items[tiles->updating.items[i]] &= ~grid_bit;
+    }
+    if (tiles->all_changed) {
+        tiles->all_changed = 0;
+        return 0;
+    }
+    return &tiles->updating;
+}
+
+static void update_changed_tiles(const tile_list *tiles, tile_updater update_tile)
+{
+    for (int i = 0; i < tiles->size; i++) {
+        int grid_offset = tiles->items[i];
+        int offset_in_map = grid_offset - map_data.start_offset;
+        if (offset_in_map < 0) {
+            continue;
+        }
+        int x = offset_in_map % GRID_SIZE;
+        int y = offset_in_map / GRID_SIZE;
+        if (x < map_data.width && y < map_data.height) {
+            update_tile(grid_offset, x, y);
+        }
+    }
+}
+
+static void set_highway(int grid_offset, int is_highway)
+{
+    if (journal.is_highway.items[grid_offset] != is_highway) {
+        journal.is_highway.items[grid_offset] = is_highway;
+        journal.num_highway_tiles += is_highway ? 1 : -1;
+    }
+}
+
 void map_routing_update_all(void)
 {
     map_routing_update_land();
@@ -99,39 +260,106 @@ static int get_land_type_citizen_aqueduct(int grid_offset)
     }
 }
 
-void map_routing_update_land_citizen(void)
+static void update_land_citizen_tile(int grid_offset, int x, int y)
+{
+    int terrain = map_terrain_get(grid_offset);
+    set_highway(grid_offset, (terrain & TERRAIN_HIGHWAY) != 0);
+    if (terrain & TERRAIN_ROAD) {
+        terrain_land_citizen.items[grid_offset] = CITIZEN_0_ROAD;
+    } else if (terrain & TERRAIN_HIGHWAY) {
+        terrain_land_citizen.items[grid_offset] = CITIZEN_1_HIGHWAY;
+    } else if (terrain & (TERRAIN_RUBBLE | TERRAIN_ACCESS_RAMP | TERRAIN_GARDEN)) {
+        terrain_land_citizen.items[grid_offset] = CITIZEN_2_PASSABLE_TERRAIN;
+    } else if (terrain & (TERRAIN_BUILDING | TERRAIN_GATEHOUSE)) {
+        if (!map_building_at(grid_offset)) {
+            // shouldn't happen
+            terrain_land_citizen.items[grid_offset] = -1;
+            terrain_land_noncitizen.items[grid_offset] = CITIZEN_4_CLEAR_TERRAIN; // BUG: should be citizen?
+            map_terrain_remove(grid_offset, TERRAIN_BUILDING);
+            map_image_set(grid_offset, (map_random_get(grid_offset) & 7) + image_group(GROUP_TERRAIN_GRASS_1));
+            map_property_mark_draw_tile(grid_offset);
+            map_property_set_multi_tile_size(grid_offset, 1);
+            return;
+        }
+        terrain_land_citizen.items[grid_offset] = get_land_type_citizen_building(grid_offset);
+    } else if (terrain & TERRAIN_AQUEDUCT) {
+        terrain_land_citizen.items[grid_offset] = get_land_type_citizen_aqueduct(grid_offset);
+    } else if (terrain & TERRAIN_NOT_CLEAR) {
+        terrain_land_citizen.items[grid_offset] = CITIZEN_N1_BLOCKED;
+    } else {
+        terrain_land_citizen.items[grid_offset] = CITIZEN_4_CLEAR_TERRAIN;
+    }
+}
+
+static int update_all_land_citizen(void)
 {
     map_grid_init_i8(terrain_land_citizen.items, -1);
-    int grid_offset = map_data.start_offset;
-    for (int y = 0; y < map_data.height; y++, grid_offset += map_data.border_size) {
-        for (int x = 0; x < map_data.width; x++, grid_offset++) {
-            int terrain = map_terrain_get(grid_offset);
-            if (terrain & TERRAIN_ROAD) {
-                terrain_land_citizen.items[grid_offset] = CITIZEN_0_ROAD;
-            } else if (terrain & TERRAIN_HIGHWAY) {
-                terrain_land_citizen.items[grid_offset] = CITIZEN_1_HIGHWAY;
-            } else if (terrain & (TERRAIN_RUBBLE | TERRAIN_ACCESS_RAMP | TERRAIN_GARDEN)) {
-                terrain_land_citizen.items[grid_offset] = CITIZEN_2_PASSABLE_TERRAIN;
-            } else if (terrain & (TERRAIN_BUILDING | TERRAIN_GATEHOUSE)) {
-                if (!map_building_at(grid_offset)) {
-                    // shouldn't happen
-                    terrain_land_noncitizen.items[grid_offset] = CITIZEN_4_CLEAR_TERRAIN; // BUG: should be citizen?
-                    map_terrain_remove(grid_offset, TERRAIN_BUILDING);
-                    map_image_set(grid_offset, (map_random_get(grid_offset) & 7) + image_group(GROUP_TERRAIN_GRASS_1));
-                    map_property_mark_draw_tile(grid_offset);
-                    map_property_set_multi_tile_size(grid_offset, 1);
-                    continue;
-                }
-                terrain_land_citizen.items[grid_offset] = get_land_type_citizen_building(grid_offset);
-            } else if (terrain & TERRAIN_AQUEDUCT) {
-                terrain_land_citizen.items[grid_offset] = get_land_type_citizen_aqueduct(grid_offset);
-            } else if (terrain & TERRAIN_NOT_CLEAR) {
-                terrain_land_citizen.items[grid_offset] = CITIZEN_N1_BLOCKED;
-            } else {
-                terrain_land_citizen.items[grid_offset] = CITIZEN_4_CLEAR_TERRAIN;
+    map_grid_clear_u8(journal.is_highway.items);
+    journal.num_highway_tiles = 0;
+    update_all_tiles(update_land_citizen_tile);
+    return map_routing_cache_refresh();
+}
+
+#ifdef CHECK_ROUTING_TERRAIN
+static void check_incremental_update(const grid_i8 *grid, void (*update_all)(void), const char *name)
+{
+    static grid_i8 incremental;
+    memcpy(incremental.items, grid->items, sizeof(incremental.items));
+    update_all();
+    int mismatches = 0;
+    for (int i = 0; i < GRID_SIZE * GRID_SIZE; i++) {
+        if (incremental.items[i] != grid->items[i]) {
+            if (!mismatches) {
+                log_error(name, 0, i);
             }
+            mismatches++;
+        }
+    }
+    if (mismatches) {
+        log_error("Number of tiles with wrong incremental routing terrain:", 0, mismatches);
+    }
+}
+
+static void update_all_land_citizen_for_check(void)
+{
+    update_all_land_citizen();
+}
+#endif
+
+static int includes_highway(const tile_list *tiles)
+{
+    for (int i = 0; i < tiles->size; i++) {
+        if (journal.is_highway.items[tiles->items[i]]) {
+            return 1;
         }
     }
+    return 0;
+}
+
+void map_routing_update_land_citizen(void)
+{
+    const tile_list *tiles = take_changed_tiles(GRID_LAND_CITIZEN);
+    int changed;
+    if (tiles) {
+        update_changed_tiles(tiles, update_land_citizen_tile);
+        changed = map_routing_cache_refresh_tiles(tiles->items, tiles->size);
+        // The directions of a highway are read from the terrain when routing,
+        // and they can change while the tile stays a highway
+        if (!changed) {
+            changed = includes_highway(tiles);
+        }
+#ifdef CHECK_ROUTING_TERRAIN
+        check_incremental_update(&terrain_land_citizen, update_all_land_citizen_for_check,
+            "Incremental citizen routing terrain differs at grid offset");
+#endif
+    } else {
+        // Every highway may have changed its directions
+        changed = update_all_land_citizen() || journal.num_highway_tiles > 0;
+    }
+    has_highways = journal.num_highway_tiles > 0;
+    if (changed) {
+        land_citizen_version++;
+    }
 }
 
 static int get_land_type_noncitizen(int grid_offset)
@@ -186,34 +414,48 @@ static int get_land_type_noncitizen(int grid_offset)
     return type;
 }
 
-static void map_routing_update_land_noncitizen(void)
+static void update_land_noncitizen_tile(int grid_offset, int x, int y)
+{
+    int terrain = map_terrain_get(grid_offset);
+    if (terrain & TERRAIN_GATEHOUSE) {
+        terrain_land_noncitizen.items[grid_offset] = NONCITIZEN_4_GATEHOUSE;
+    } else if (terrain & TERRAIN_BUILDING) {
+        terrain_land_noncitizen.items[grid_offset] = get_land_type_noncitizen(grid_offset);
+    } else if (terrain & TERRAIN_ROAD) {
+        terrain_land_noncitizen.items[grid_offset] = NONCITIZEN_0_PASSABLE;
+    } else if (terrain & TERRAIN_HIGHWAY) {
+        terrain_land_noncitizen.items[grid_offset] = NONCITIZEN_0_PASSABLE;
+    } else if (terrain & (TERRAIN_GARDEN | TERRAIN_ACCESS_RAMP | TERRAIN_RUBBLE)) {
+        terrain_land_noncitizen.items[grid_offset] = NONCITIZEN_2_CLEARABLE;
+    } else if (terrain & TERRAIN_AQUEDUCT) {
+        terrain_land_noncitizen.items[grid_offset] = NONCITIZEN_2_CLEARABLE;
+    } else if (terrain & TERRAIN_WALL) {
+        terrain_land_noncitizen.items[grid_offset] = NONCITIZEN_3_WALL;
+    } else if (terrain & TERRAIN_NOT_CLEAR) {
+        terrain_land_noncitizen.items[grid_offset] = NONCITIZEN_N1_BLOCKED;
+    } else {
+        terrain_land_noncitizen.items[grid_offset] = NONCITIZEN_0_PASSABLE;
+    }
+}
+
+static void update_all_land_noncitizen(void)
 {
     map_grid_init_i8(terrain_land_noncitizen.items, -1);
-    int grid_offset = map_data.start_offset;
-    for (int y = 0; y < map_data.height; y++, grid_offset += map_data.border_size) {
-        for (int x = 0; x < map_data.width; x++, grid_offset++) {
-            int terrain = map_terrain_get(grid_offset);
-            if (terrain & TERRAIN_GATEHOUSE) {
-                terrain_land_noncitizen.items[grid_offset] = NONCITIZEN_4_GATEHOUSE;
-            } else if (terrain & TERRAIN_BUILDING) {
-                terrain_land_noncitizen.items[grid_offset] = get_land_type_noncitizen(grid_offset);
-            } else if (terrain & TERRAIN_ROAD) {
-                terrain_land_noncitizen.items[grid_offset] = NONCITIZEN_0_PASSABLE;
-            } else if (terrain & TERRAIN_HIGHWAY) {
-                terrain_land_noncitizen.items[grid_offset] = NONCITIZEN_0_PASSABLE;
-            } else if (terrain & (TERRAIN_GARDEN | TERRAIN_ACCESS_RAMP | TERRAIN_RUBBLE)) {
-                terrain_land_noncitizen.items[grid_offset] = NONCITIZEN_2_CLEARABLE;
-            } else if (terrain & TERRAIN_AQUEDUCT) {
-                terrain_land_noncitizen.items[grid_offset] = NONCITIZEN_2_CLEARABLE;
-            } else if (terrain & TERRAIN_WALL) {
-                terrain_land_noncitizen.items[grid_offset] = NONCITIZEN_3_WALL;
-            } else if (terrain & TERRAIN_NOT_CLEAR) {
-                terrain_land_noncitizen.items[grid_offset] = NONCITIZEN_N1_BLOCKED;
-            } else {
-                terrain_land_noncitizen.items[grid_offset] = NONCITIZEN_0_PASSABLE;
-            }
-        }
+    update_all_tiles(update_land_noncitizen_tile);
+}
+
+static void map_routing_update_land_noncitizen(void)
+{
+    const tile_list *tiles = take_changed_tiles(GRID_LAND_NONCITIZEN);
+    if (!tiles) {
+        update_all_land_noncitizen();
+        return;
     }
+    update_changed_tiles(tiles, update_land_noncitizen_tile);
+#ifdef CHECK_ROUTING_TERRAIN
+    check_incremental_update(&terrain_land_noncitizen, update_all_land_noncitizen,
+        "Incremental non-citizen routing terrain differs at grid offset");
+#endif
 }
 
 static int is_surrounded_by_water(int grid_offset)
@@ -224,35 +466,48 @@ static int is_surrounded_by_water(int grid_offset)
         map_terrain_is(grid_offset + map_grid_delta(0, 1), TERRAIN_WATER);
 }
 
-void map_routing_update_water(void)
+static void update_water_tile(int grid_offset, int x, int y)
 {
-    map_grid_init_i8(terrain_water.items, -1);
-    int grid_offset = map_data.start_offset;
-    for (int y = 0; y < map_data.height; y++, grid_offset += map_data.border_size) {
-        for (int x = 0; x < map_data.width; x++, grid_offset++) {
-            if (map_terrain_is(grid_offset, TERRAIN_WATER) && is_surrounded_by_water(grid_offset)) {
-                if (x > 0 && x < map_data.width - 1 &&
-                    y > 0 && y < map_data.height - 1) {
-                    switch (map_sprite_bridge_at(grid_offset)) {
-                        case 5:
-                        case 6: // low bridge middle section
-                            terrain_water.items[grid_offset] = WATER_N3_LOW_BRIDGE;
-                            break;
-                        case 13: // ship bridge pillar
-                            terrain_water.items[grid_offset] = WATER_N1_BLOCKED;
-                            break;
-                        default:
-                            terrain_water.items[grid_offset] = WATER_0_PASSABLE;
-                            break;
-                    }
-                } else {
-                    terrain_water.items[grid_offset] = WATER_N2_MAP_EDGE;
-                }
-            } else {
-                terrain_water.items[grid_offset] = WATER_N1_BLOCKED;
+    if (map_terrain_is(grid_offset, TERRAIN_WATER) && is_surrounded_by_water(grid_offset)) {
+        if (x > 0 && x < map_data.width - 1 &&
+            y > 0 && y < map_data.height - 1) {
+            switch (map_sprite_bridge_at(grid_offset)) {
+                case 5:
+                case 6: // low bridge middle section
+                    terrain_water.items[grid_offset] = WATER_N3_LOW_BRIDGE;
+                    break;
+                case 13: // ship bridge pillar
+                    terrain_water.items[grid_offset] = WATER_N1_BLOCKED;
+                    break;
+                default:
+                    terrain_water.items[grid_offset] = WATER_0_PASSABLE;
+                    break;
             }
+        } else {
+            terrain_water.items[grid_offset] = WATER_N2_MAP_EDGE;
         }
+    } else {
+        terrain_water.items[grid_offset] = WATER_N1_BLOCKED;
+    }
+}
+
+static void update_all_water(void)
+{
+    map_grid_init_i8(terrain_water.items, -1);
+    update_all_tiles(update_water_tile);
+}
+
+void map_routing_update_water(void)
+{
+    const tile_list *tiles = take_changed_tiles(GRID_WATER);
+    if (!tiles) {
+        update_all_water();
+        return;
     }
+    update_changed_tiles(tiles, update_water_tile);
+#ifdef CHECK_ROUTING_TERRAIN
+    check_incremental_update(&terrain_water, update_all_water, "Incremental water routing terrain differs at grid offset");
+#endif
 }
 
 static int is_wall_tile(int grid_offset)
@@ -288,25 +543,43 @@ static int count_adjacent_wall_tiles(int grid_offset)
     return adjacent;
 }
 
-void map_routing_update_walls(void)
+static void update_wall_tile(int grid_offset, int x, int y)
 {
-    map_grid_init_i8(terrain_walls.items, -1);
-    int grid_offset = map_data.start_offset;
-    for (int y = 0; y < map_data.height; y++, grid_offset += map_data.border_size) {
-        for (int x = 0; x < map_data.width; x++, grid_offset++) {
-            if (map_terrain_is(grid_offset, TERRAIN_WALL)) {
-                if (count_adjacent_wall_tiles(grid_offset) == 3) {
-                    terrain_walls.items[grid_offset] = WALL_0_PASSABLE;
-                } else {
-                    terrain_walls.items[grid_offset] = WALL_N1_BLOCKED;
-                }
-            } else if (map_terrain_is(grid_offset, TERRAIN_GATEHOUSE)) {
-                terrain_walls.items[grid_offset] = WALL_0_PASSABLE;
-            } else {
-                terrain_walls.items[grid_offset] = WALL_N1_BLOCKED;
-            }
+    if (map_terrain_is(grid_offset, TERRAIN_WALL)) {
+        if (count_adjacent_wall_tiles(grid_offset) == 3) {
+            terrain_walls.items[grid_offset] = WALL_0_PASSABLE;
+        } else {
+            terrain_walls.items[grid_offset] = WALL_N1_BLOCKED;
         }
+    } else if (map_terrain_is(grid_offset, TERRAIN_GATEHOUSE)) {
+        terrain_walls.items[grid_offset] = WALL_0_PASSABLE;
+    } else {
+        terrain_walls.items[grid_offset] = WALL_N1_BLOCKED;
+    }
+}
+
+static void update_all_walls(void)
+{
+    map_grid_init_i8(terrain_walls.items, -1);
+    update_all_tiles(update_wall_tile);
+}
+
+void map_routing_update_walls(void)
+{
+    // which neighbours are checked depends on the orientation
+    if (journal.walls_orientation != city_view_orientation()) {
+        journal.walls_orientation = city_view_orientation();
+        map_routing_all_tiles_changed(ROUTING_CHANGE_WALLS);
+    }
+    const tile_list *tiles = take_changed_tiles(GRID_WALLS);
+    if (!tiles) {
+        update_all_walls();
+        return;
     }
+    update_changed_tiles(tiles, update_wall_tile);
+#ifdef CHECK_ROUTING_TERRAIN
+    check_incremental_update(&terrain_walls, update_all_walls, "Incremental wall routing terrain differs at grid offset");
+#endif
 }
 
 int map_routing_is_wall_passable(int grid_offset)
@@ -358,6 +631,16 @@ int map_routing_citizen_is_highway(int grid_offset)
     return terrain_land_citizen.items[grid_offset] == CITIZEN_1_HIGHWAY;
 }
 
+int map_routing_citizen_has_highways(void)
+{
+    return has_highways;
+}
+
+unsigned int map_routing_citizen_version(void)
+{
+    return land_citizen_version;
+}
+
 int map_routing_citizen_is_passable_terrain(int grid_offset)
 {
     return terrain_land_citizen.items[grid_offset] == CITIZEN_2_PASSABLE_TERRAIN;
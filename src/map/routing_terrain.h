@@ -1,6 +1,16 @@
 #ifndef MAP_ROUTING_TERRAIN_H
 #define MAP_ROUTING_TERRAIN_H
 
+enum {
+    ROUTING_CHANGE_LAND = 1,
+    ROUTING_CHANGE_WATER = 2,
+    ROUTING_CHANGE_WALLS = 4,
+    ROUTING_CHANGE_ALL = 7
+};
+
+void map_routing_tile_changed(int grid_offset, int changes);
+void map_routing_all_tiles_changed(int changes);
+
 void map_routing_update_all(void);
 void map_routing_update_land(void);
 void map_routing_update_land_citizen(void);
@@ -13,6 +23,8 @@ int map_routing_wall_tile_in_radius(int x, int y, int radius, int *x_wall, int *
 int map_routing_citizen_is_passable(int grid_offset);
 int map_routing_citizen_is_road(int grid_offset);
 int map_routing_citizen_is_highway(int grid_offset);
+int map_routing_citizen_has_highways(void);
+unsigned int map_routing_citizen_version(void);
 int map_routing_citizen_is_passable_terrain(int grid_offset);
 
 int map_routing_noncitizen_is_passable(int grid_offset);
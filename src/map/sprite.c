@@ -1,10 +1,20 @@
 #include "sprite.h"
 
 #include "map/grid.h"
+#include "map/routing_terrain.h"
 
 static grid_u8 sprite;
 static grid_u8 sprite_backup;
 
+static void set_sprite(int grid_offset, int value)
+{
+    // bridge sprites decide where boats may pass
+    if (sprite.items[grid_offset] != value) {
+        map_routing_tile_changed(grid_offset, ROUTING_CHANGE_WATER);
+    }
+    sprite.items[grid_offset] = value;
+}
+
 int map_sprite_animation_at(int grid_offset)
 {
     return sprite.items[grid_offset];
@@ -12,7 +22,7 @@ int map_sprite_animation_at(int grid_offset)
 
 void map_sprite_animation_set(int grid_offset, int value)
 {
-    sprite.items[grid_offset] = value;
+    set_sprite(grid_offset, value);
 }
 
 int map_sprite_bridge_at(int grid_offset)
@@ -22,17 +32,18 @@ int map_sprite_bridge_at(int grid_offset)
 
 void map_sprite_bridge_set(int grid_offset, int value)
 {
-    sprite.items[grid_offset] = value;
+    set_sprite(grid_offset, value);
 }
 
 void map_sprite_clear_tile(int grid_offset)
 {
-    sprite.items[grid_offset] = 0;
+    set_sprite(grid_offset, 0);
 }
 
 void map_sprite_clear(void)
 {
     map_grid_clear_u8(sprite.items);
+    map_routing_all_tiles_changed(ROUTING_CHANGE_WATER);
 }
 
 void map_sprite_backup(void)
@@ -43,6 +54,7 @@ void map_sprite_backup(void)
 void map_sprite_restore(void)
 {
     map_grid_copy_u8(sprite_backup.items, sprite.items);
+    map_routing_all_tiles_changed(ROUTING_CHANGE_WATER);
 }
 
 void map_sprite_save_state(buffer *buf, buffer *backup)
@@ -55,4 +67,5 @@ void map_sprite_load_state(buffer *buf, buffer *backup)
 {
     map_grid_load_state_u8(sprite.items, buf);
     map_grid_load_state_u8(sprite_backup.items, backup);
+    map_routing_all_tiles_changed(ROUTING_CHANGE_WATER);
 }
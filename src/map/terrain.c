@@ -8,11 +8,67 @@
 #include "map/grid.h"
 #include "map/ring.h"
 #include "map/routing.h"
+#include "map/routing_terrain.h"
 #include "map/sprite.h"
 
+#define ROAD_NETWORK_TERRAIN (TERRAIN_ROAD | TERRAIN_ACCESS_RAMP)
+#define WATER_SUPPLY_TERRAIN (TERRAIN_WATER | TERRAIN_AQUEDUCT | TERRAIN_HIGHWAY | \
+    TERRAIN_RESERVOIR_RANGE | TERRAIN_FOUNTAIN_RANGE)
+
 static grid_u32 terrain_grid;
 static grid_u32 terrain_grid_backup;
 
+static struct {
+    unsigned int road;
+    unsigned int water_supply;
+} version;
+
+static void update_versions(uint32_t changed_terrain)
+{
+    if (changed_terrain & ROAD_NETWORK_TERRAIN) {
+        version.road++;
+    }
+    if (changed_terrain & WATER_SUPPLY_TERRAIN) {
+        version.water_supply++;
+    }
+}
+
+static int routing_changes(uint32_t changed_terrain)
+{
+    int changes = 0;
+    if (changed_terrain & TERRAIN_NOT_CLEAR) {
+        changes |= ROUTING_CHANGE_LAND;
+    }
+    if (changed_terrain & TERRAIN_WATER) {
+        changes |= ROUTING_CHANGE_WATER;
+    }
+    if (changed_terrain & TERRAIN_WALL_OR_GATEHOUSE) {
+        changes |= ROUTING_CHANGE_WALLS;
+    }
+    return changes;
+}
+
+static void update_terrain(int grid_offset, uint32_t terrain)
+{
+    uint32_t changed_terrain = terrain_grid.items[grid_offset] ^ terrain;
+    if (!changed_terrain) {
+        return;
+    }
+    update_versions(changed_terrain);
+    map_routing_tile_changed(grid_offset, routing_changes(changed_terrain));
+    terrain_grid.items[grid_offset] = terrain;
+}
+
+unsigned int map_terrain_road_version(void)
+{
+    return version.road;
+}
+
+unsigned int map_terrain_water_supply_version(void)
+{
+    return version.water_supply;
+}
+
 int map_terrain_is(int grid_offset, int terrain)
 {
     return map_grid_is_valid_offset(grid_offset) && terrain_grid.items[grid_offset] & terrain;
@@ -48,17 +104,17 @@ int map_terrain_get_from_buffer_32(buffer *buf, int grid_offset)
 
 void map_terrain_set(int grid_offset, int terrain)
 {
-    terrain_grid.items[grid_offset] = terrain;
+    update_terrain(grid_offset, terrain);
 }
 
 void map_terrain_add(int grid_offset, int terrain)
 {
-    terrain_grid.items[grid_offset] |= terrain;
+    update_terrain(grid_offset, terrain_grid.items[grid_offset] | terrain);
 }
 
 void map_terrain_remove(int grid_offset, int terrain)
 {
-    terrain_grid.items[grid_offset] &= ~terrain;
+    update_terrain(grid_offset, terrain_grid.items[grid_offset] & ~terrain);
 }
 
 void map_terrain_add_with_radius(int x, int y, int size, int radius, int terrain)
@@ -88,6 +144,8 @@ void map_terrain_remove_with_radius(int x, int y, int size, int radius, int terr
 void map_terrain_remove_all(int terrain)
 {
     map_grid_and_u32(terrain_grid.items, ~terrain);
+    update_versions(terrain);
+    map_routing_all_tiles_changed(routing_changes(terrain));
 }
 
 int map_terrain_count_directly_adjacent_with_type(int grid_offset, int terrain)
@@ -409,11 +467,15 @@ void map_terrain_backup(void)
 void map_terrain_restore(void)
 {
     map_grid_copy_u32(terrain_grid_backup.items, terrain_grid.items);
+    update_versions(TERRAIN_ALL);
+    map_routing_all_tiles_changed(ROUTING_CHANGE_ALL);
 }
 
 void map_terrain_clear(void)
 {
     map_grid_clear_u32(terrain_grid.items);
+    update_versions(TERRAIN_ALL);
+    map_routing_all_tiles_changed(ROUTING_CHANGE_ALL);
 }
 
 void map_terrain_init_outside_map(void)
@@ -430,6 +492,8 @@ void map_terrain_init_outside_map(void)
             }
         }
     }
+    update_versions(TERRAIN_ALL);
+    map_routing_all_tiles_changed(ROUTING_CHANGE_ALL);
 }
 
 void map_terrain_save_state(buffer *buf)
@@ -582,5 +646,7 @@ void map_terrain_load_state(buffer *buf, int expanded_terrain_data, buffer *imag
     } else {
         map_grid_load_state_u16_to_u32(terrain_grid.items, buf);
     }
+    update_versions(TERRAIN_ALL);
+    map_routing_all_tiles_changed(ROUTING_CHANGE_ALL);
     determine_original_trees(images, legacy_image_buffer);
 }
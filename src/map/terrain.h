@@ -63,6 +63,10 @@ enum {
 
 int map_terrain_is(int grid_offset, int terrain);
 
+unsigned int map_terrain_road_version(void);
+
+unsigned int map_terrain_water_supply_version(void);
+
 int map_terrain_is_roadblock(int grid_offset);
 
 int map_terrain_is_superset(int grid_offset, unsigned int terrain_sum);
@@ -6,6 +6,7 @@
 #include "building/monument.h"
 #include "building/list.h"
 #include "core/image.h"
+#include "core/log.h"
 #include "map/aqueduct.h"
 #include "map/building_tiles.h"
 #include "map/data.h"
@@ -18,6 +19,7 @@
 #include "map/tiles.h"
 #include "scenario/property.h"
 
+#include <stdlib.h>
 #include <string.h>
 
 #define OFFSET(x,y) (x + GRID_SIZE * y)
@@ -37,6 +39,51 @@ static struct {
     int tail;
 } queue;
 
+// Range terrain is only changed where the areas covered by reservoirs and fountains change.
+// Each tile keeps the number of areas that cover it, so overlapping areas can be removed one by one.
+// The aqueducts are only filled again when the reservoirs or the water supply terrain changed.
+typedef struct {
+    int building_id;
+    int x;
+    int y;
+    int size;
+    int radius;
+} range_area;
+
+typedef struct {
+    range_area *items;
+    int size;
+    int capacity;
+} range_area_list;
+
+typedef struct {
+    int terrain;
+    grid_u16 num_areas;
+    range_area_list current;
+    range_area_list next;
+} water_range;
+
+typedef struct {
+    int building_id;
+    int state;
+    int grid_offset;
+} reservoir_info;
+
+static struct {
+    int is_valid;
+    unsigned int terrain_version;
+    struct {
+        reservoir_info *items;
+        int size;
+        int capacity;
+    } reservoirs;
+    water_range reservoir_range;
+    water_range fountain_range;
+} data = {
+    .reservoir_range = { TERRAIN_RESERVOIR_RANGE },
+    .fountain_range = { TERRAIN_FOUNTAIN_RANGE }
+};
+
 static void mark_well_access(int well_id, int radius)
 {
     building *well = building_get(well_id);
@@ -189,10 +236,49 @@ static void fill_aqueducts_from_offset(int grid_offset)
     } while (next_offset > -1);
 }
 
-void map_water_supply_update_reservoir_fountain(void)
+static void *grow_list(void *items, int *capacity, size_t item_size)
+{
+    int new_capacity = *capacity ? *capacity * 2 : 64;
+    void *new_items = realloc(items, new_capacity * item_size);
+    if (!new_items) {
+        log_error("Unable to track the water supply. The game will now crash.", 0, 0);
+        return 0;
+    }
+    *capacity = new_capacity;
+    return new_items;
+}
+
+static int update_reservoir_list(void)
+{
+    int changed = 0;
+    int index = 0;
+    for (building *b = building_first_of_type(BUILDING_RESERVOIR); b; b = b->next_of_type, index++) {
+        if (index == data.reservoirs.capacity) {
+            reservoir_info *items = grow_list(data.reservoirs.items, &data.reservoirs.capacity,
+                sizeof(reservoir_info));
+            if (!items) {
+                return 1;
+            }
+            data.reservoirs.items = items;
+        }
+        reservoir_info *info = &data.reservoirs.items[index];
+        if (index >= data.reservoirs.size || info->building_id != b->id || info->state != b->state ||
+            info->grid_offset != b->grid_offset) {
+            info->building_id = b->id;
+            info->state = b->state;
+            info->grid_offset = b->grid_offset;
+            changed = 1;
+        }
+    }
+    if (index != data.reservoirs.size) {
+        data.reservoirs.size = index;
+        changed = 1;
+    }
+    return changed;
+}
+
+static void update_aqueducts(void)
 {
-    map_terrain_remove_all(TERRAIN_FOUNTAIN_RANGE | TERRAIN_RESERVOIR_RANGE);
-    // reservoirs
     set_all_aqueducts_to_no_water();
     for (building *b = building_first_of_type(BUILDING_RESERVOIR); b; b = b->next_of_type) {
         if (b->state != BUILDING_STATE_IN_USE) {
@@ -221,18 +307,116 @@ void map_water_supply_update_reservoir_fountain(void)
             }
         }
     }
+}
+
+static void clear_range(water_range *range)
+{
+    map_terrain_remove_all(range->terrain);
+    map_grid_clear_u16(range->num_areas.items);
+    range->current.size = 0;
+}
+
+static void add_area(water_range *range, const building *b, int size, int radius)
+{
+    range_area_list *list = &range->next;
+    if (list->size == list->capacity) {
+        range_area *items = grow_list(list->items, &list->capacity, sizeof(range_area));
+        if (!items) {
+            return;
+        }
+        list->items = items;
+    }
+    // keep the list sorted by building ID
+    int index = list->size++;
+    while (index > 0 && list->items[index - 1].building_id > b->id) {
+        list->items[index] = list->items[index - 1];
+        index--;
+    }
+    range_area *area = &list->items[index];
+    area->building_id = b->id;
+    area->x = b->x;
+    area->y = b->y;
+    area->size = size;
+    area->radius = radius;
+}
+
+static int is_same_area(const range_area *a, const range_area *b)
+{
+    return a->x == b->x && a->y == b->y && a->size == b->size && a->radius == b->radius;
+}
+
+static void change_tiles_in_area(water_range *range, const range_area *area, int delta)
+{
+    int x_min, y_min, x_max, y_max;
+    map_grid_get_area(area->x, area->y, area->size, area->radius, &x_min, &y_min, &x_max, &y_max);
+
+    for (int yy = y_min; yy <= y_max; yy++) {
+        for (int xx = x_min; xx <= x_max; xx++) {
+            int grid_offset = map_grid_offset(xx, yy);
+            if (delta > 0) {
+                if (range->num_areas.items[grid_offset]++ == 0) {
+                    map_terrain_add(grid_offset, range->terrain);
+                }
+            } else if (--range->num_areas.items[grid_offset] == 0) {
+                map_terrain_remove(grid_offset, range->terrain);
+            }
+        }
+    }
+}
+
+static void apply_range_changes(water_range *range)
+{
+    const range_area_list *current = &range->current;
+    const range_area_list *next = &range->next;
+    int i = 0;
+    int j = 0;
+    while (i < current->size || j < next->size) {
+        const range_area *old_area = i < current->size ? &current->items[i] : 0;
+        const range_area *new_area = j < next->size ? &next->items[j] : 0;
+        if (old_area && new_area && old_area->building_id == new_area->building_id) {
+            if (!is_same_area(old_area, new_area)) {
+                change_tiles_in_area(range, new_area, 1);
+                change_tiles_in_area(range, old_area, -1);
+            }
+            i++;
+            j++;
+        } else if (new_area && (!old_area || new_area->building_id < old_area->building_id)) {
+            change_tiles_in_area(range, new_area, 1);
+            j++;
+        } else {
+            change_tiles_in_area(range, old_area, -1);
+            i++;
+        }
+    }
+    range_area_list list = range->current;
+    range->current = range->next;
+    range->next = list;
+    range->next.size = 0;
+}
+
+void map_water_supply_update_reservoir_fountain(void)
+{
+    int reservoirs_changed = update_reservoir_list();
+    if (!data.is_valid || data.terrain_version != map_terrain_water_supply_version()) {
+        clear_range(&data.reservoir_range);
+        clear_range(&data.fountain_range);
+        update_aqueducts();
+    } else if (reservoirs_changed) {
+        update_aqueducts();
+    }
     // mark reservoir ranges
     for (building *b = building_first_of_type(BUILDING_RESERVOIR); b; b = b->next_of_type) {
         if (b->state == BUILDING_STATE_IN_USE && b->has_water_access) {
-            map_terrain_add_with_radius(b->x, b->y, 3, map_water_supply_reservoir_radius(), TERRAIN_RESERVOIR_RANGE);
+            add_area(&data.reservoir_range, b, 3, map_water_supply_reservoir_radius());
         }
     }
 
     // Neptune GT module 2 bonus
     if (building_monument_gt_module_is_active(NEPTUNE_MODULE_2_CAPACITY_AND_WATER)) {
         building *b = building_get(building_monument_get_neptune_gt());
-        map_terrain_add_with_radius(b->x, b->y, 7, map_water_supply_reservoir_radius(), TERRAIN_RESERVOIR_RANGE);
+        add_area(&data.reservoir_range, b, 7, map_water_supply_reservoir_radius());
     }
+    apply_range_changes(&data.reservoir_range);
 
     // fountains
     for (building *b = building_first_of_type(BUILDING_FOUNTAIN); b; b = b->next_of_type) {
@@ -251,12 +435,12 @@ void map_water_supply_update_reservoir_fountain(void)
         map_building_tiles_add(b->id, b->x, b->y, 1, building_image_get(b), TERRAIN_BUILDING);
         if (map_terrain_is(b->grid_offset, TERRAIN_RESERVOIR_RANGE) && b->num_workers) {
             b->has_water_access = 1;
-            map_terrain_add_with_radius(b->x, b->y, 1,
-                map_water_supply_fountain_radius(), TERRAIN_FOUNTAIN_RANGE);
+            add_area(&data.fountain_range, b, 1, map_water_supply_fountain_radius());
         } else {
             b->has_water_access = 0;
         }
     }
+    apply_range_changes(&data.fountain_range);
     // Ponds
     static const building_type ponds[] = { BUILDING_SMALL_POND, BUILDING_LARGE_POND };
     for (int i = 0; i < 2; i++) {
@@ -295,6 +479,8 @@ void map_water_supply_update_reservoir_fountain(void)
             b->has_water_access = 0;
         }
     }
+    data.terrain_version = map_terrain_water_supply_version();
+    data.is_valid = 1;
 }
 
 int map_water_supply_has_aqueduct_access(int grid_offset)
@@ -7,6 +7,7 @@
 #include "core/log.h"
 #include "core/time.h"
 #include "game/game.h"
+#include "game/profiler.h"
 #include "game/settings.h"
 #include "game/system.h"
 #include "graphics/screen.h"
@@ -62,6 +63,8 @@ static struct {
     struct {
         int frame_count;
         int last_fps;
+        Uint32 frame_time;
+        Uint32 last_frame_time;
         Uint32 last_update_time;
     } fps;
     FILE *log_file;
@@ -196,6 +199,16 @@ uint64_t system_get_ticks(void)
 #endif
 }
 
+uint64_t system_get_microseconds(void)
+{
+    static uint64_t frequency;
+    if (!frequency) {
+        frequency = SDL_GetPerformanceFrequency();
+    }
+    uint64_t counter = SDL_GetPerformanceCounter();
+    return (counter / frequency) * 1000000 + (counter % frequency) * 1000000 / frequency;
+}
+
 #ifdef _WIN32
 #define PLATFORM_ENABLE_PER_FRAME_CALLBACK
 static void platform_per_frame_callback(void)
@@ -214,14 +227,20 @@ static void run_and_draw(void)
     Uint32 time_after_draw = system_get_ticks();
 
     data.fps.frame_count++;
+    data.fps.frame_time += time_after_draw - time_before_run;
     if (time_after_draw - data.fps.last_update_time > 1000) {
         data.fps.last_fps = data.fps.frame_count;
+        data.fps.last_frame_time = data.fps.frame_time / data.fps.frame_count;
         data.fps.last_update_time = time_after_draw;
         data.fps.frame_count = 0;
+        data.fps.frame_time = 0;
     }
 
     if (config_get(CONFIG_UI_DISPLAY_FPS)) {
-        game_display_fps(data.fps.last_fps);
+        game_display_fps(data.fps.last_fps, data.fps.last_frame_time);
+    }
+    if (game_profiler_is_enabled()) {
+        game_profiler_draw();
     }
 
     platform_renderer_render();
@@ -23,11 +23,21 @@
 #define HAS_YUV_TEXTURES 0
 #endif
 
+#if SDL_VERSION_ATLEAST(2, 0, 6)
+#define USE_CUSTOM_BLEND_MODE
+#define HAS_CUSTOM_BLEND_MODE (platform_sdl_version_at_least(2, 0, 6))
+#endif
+
 #if SDL_VERSION_ATLEAST(2, 0, 10)
 #define USE_RENDERCOPYF
 #define HAS_RENDERCOPYF (platform_sdl_version_at_least(2, 0, 10))
 #endif
 
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+#define USE_RENDER_GEOMETRY
+#define HAS_RENDER_GEOMETRY (platform_sdl_version_at_least(2, 0, 18))
+#endif
+
 #if SDL_VERSION_ATLEAST(2, 0, 12)
 #define USE_TEXTURE_SCALE_MODE
 #define HAS_TEXTURE_SCALE_MODE (platform_sdl_version_at_least(2, 0, 12))
@@ -37,6 +47,8 @@
 
 #define MAX_UNPACKED_IMAGES 20
 
+#define MAX_BATCHED_IMAGES 1024
+
 #define MAX_PACKED_IMAGE_SIZE 64000
 
 #if (defined(__ANDROID__) || defined(__EMSCRIPTEN__)) && !SDL_VERSION_ATLEAST(2, 24, 0)
@@ -91,6 +103,17 @@ static struct {
         int height;
         int opacity;
     } tooltip;
+    struct {
+        struct {
+            SDL_Texture *texture;
+            int width;
+            int height;
+        } layers[MAX_CITY_LAYERS];
+        SDL_Texture *former_target;
+        SDL_Rect former_viewport;
+        SDL_Rect former_clip;
+        int unsupported;
+    } city_layers;
     SDL_Texture **texture_lists[ATLAS_MAX];
     image_atlas_data atlas_data[ATLAS_MAX];
     struct {
@@ -113,6 +136,22 @@ static struct {
         time_millis last_used;
         SDL_Texture *texture;
     } unpacked_images[MAX_UNPACKED_IMAGES];
+#ifdef USE_RENDER_GEOMETRY
+    struct {
+        SDL_Texture *texture;
+        float texture_width;
+        float texture_height;
+        int num_images;
+        SDL_Vertex vertices[MAX_BATCHED_IMAGES * 4];
+        int indices[MAX_BATCHED_IMAGES * 6];
+    } batch;
+#endif
+    struct {
+        int draw_calls;
+        int batched_images;
+        int last_draw_calls;
+        int last_batched_images;
+    } statistics;
     graphics_renderer_interface renderer_interface;
     int supports_yuv_textures;
     float city_scale;
@@ -120,8 +159,28 @@ static struct {
     int disable_linear_filter;
 } data;
 
+static void flush_batch(void)
+{
+#ifdef USE_RENDER_GEOMETRY
+    if (!data.batch.num_images) {
+        return;
+    }
+    SDL_Texture *texture = data.batch.texture;
+    // The color of each image is stored in its vertices, so the texture itself must not tint them again
+    SDL_SetTextureColorMod(texture, 0xff, 0xff, 0xff);
+    SDL_SetTextureAlphaMod(texture, 0xff);
+    data.statistics.draw_calls++;
+    SDL_RenderGeometry(data.renderer, texture, data.batch.vertices, data.batch.num_images * 4,
+        data.batch.indices, data.batch.num_images * 6);
+    data.batch.num_images = 0;
+    // The texture may be destroyed after this point and its address reused by a new one
+    data.batch.texture = 0;
+#endif
+}
+
 static int save_screen_buffer(color_t *pixels, int x, int y, int width, int height, int row_width)
 {
+    flush_batch();
     if (data.paused) {
         return 0;
     }
@@ -132,6 +191,7 @@ static int save_screen_buffer(color_t *pixels, int x, int y, int width, int heig
 
 static void draw_line(int x_start, int x_end, int y_start, int y_end, color_t color)
 {
+    flush_batch();
     if (data.paused) {
         return;
     }
@@ -140,11 +200,13 @@ static void draw_line(int x_start, int x_end, int y_start, int y_end, color_t co
         (color & COLOR_CHANNEL_GREEN) >> COLOR_BITSHIFT_GREEN,
         (color & COLOR_CHANNEL_BLUE) >> COLOR_BITSHIFT_BLUE,
         (color & COLOR_CHANNEL_ALPHA) >> COLOR_BITSHIFT_ALPHA);
+    data.statistics.draw_calls++;
     SDL_RenderDrawLine(data.renderer, x_start, y_start, x_end, y_end);
 }
 
 static void draw_rect(int x_start, int x_end, int y_start, int y_end, color_t color)
 {
+    flush_batch();
     if (data.paused) {
         return;
     }
@@ -153,12 +215,14 @@ static void draw_rect(int x_start, int x_end, int y_start, int y_end, color_t co
         (color & COLOR_CHANNEL_GREEN) >> COLOR_BITSHIFT_GREEN,
         (color & COLOR_CHANNEL_BLUE) >> COLOR_BITSHIFT_BLUE,
         (color & COLOR_CHANNEL_ALPHA) >> COLOR_BITSHIFT_ALPHA);
+    data.statistics.draw_calls++;
     SDL_Rect rect = { x_start, y_start, x_end, y_end };
     SDL_RenderDrawRect(data.renderer, &rect);
 }
 
 static void fill_rect(int x_start, int x_end, int y_start, int y_end, color_t color)
 {
+    flush_batch();
     if (data.paused) {
         return;
     }
@@ -167,12 +231,14 @@ static void fill_rect(int x_start, int x_end, int y_start, int y_end, color_t co
         (color & COLOR_CHANNEL_GREEN) >> COLOR_BITSHIFT_GREEN,
         (color & COLOR_CHANNEL_BLUE) >> COLOR_BITSHIFT_BLUE,
         (color & COLOR_CHANNEL_ALPHA) >> COLOR_BITSHIFT_ALPHA);
+    data.statistics.draw_calls++;
     SDL_Rect rect = { x_start, y_start, x_end, y_end };
     SDL_RenderFillRect(data.renderer, &rect);
 }
 
 static void set_clip_rectangle(int x, int y, int width, int height)
 {
+    flush_batch();
     if (data.paused) {
         return;
     }
@@ -182,6 +248,7 @@ static void set_clip_rectangle(int x, int y, int width, int height)
 
 static void reset_clip_rectangle(void)
 {
+    flush_batch();
     if (data.paused) {
         return;
     }
@@ -190,6 +257,7 @@ static void reset_clip_rectangle(void)
 
 static void set_viewport(int x, int y, int width, int height)
 {
+    flush_batch();
     if (data.paused) {
         return;
     }
@@ -199,6 +267,7 @@ static void set_viewport(int x, int y, int width, int height)
 
 static void reset_viewport(void)
 {
+    flush_batch();
     if (data.paused) {
         return;
     }
@@ -208,6 +277,7 @@ static void reset_viewport(void)
 
 static void clear_screen(void)
 {
+    flush_batch();
     if (data.paused) {
         return;
     }
@@ -223,6 +293,7 @@ static void get_max_image_size(int *width, int *height)
 
 static void free_silhouettes(void)
 {
+    flush_batch();
     silhouette_texture *silhouette = data.silhouettes;
     while (silhouette) {
         silhouette_texture *current = silhouette;
@@ -235,6 +306,7 @@ static void free_silhouettes(void)
 
 static void free_unpacked_assets(void)
 {
+    flush_batch();
     for (int i = 0; i < MAX_UNPACKED_IMAGES; i++) {
         if (data.unpacked_images[i].texture) {
             SDL_DestroyTexture(data.unpacked_images[i].texture);
@@ -243,8 +315,22 @@ static void free_unpacked_assets(void)
     memset(data.unpacked_images, 0, sizeof(data.unpacked_images));
 }
 
+static void free_city_layers(void)
+{
+    flush_batch();
+    for (int i = 0; i < MAX_CITY_LAYERS; i++) {
+        if (data.city_layers.layers[i].texture) {
+            SDL_DestroyTexture(data.city_layers.layers[i].texture);
+        }
+    }
+    memset(data.city_layers.layers, 0, sizeof(data.city_layers.layers));
+}
+
 static void free_texture_atlas(atlas_type type)
 {
+    flush_batch();
+    // City layers are made of atlas images, so they can't be reused once an atlas changes
+    free_city_layers();
     if (!data.texture_lists[type]) {
         return;
     }
@@ -432,6 +518,7 @@ static void free_all_textures(void)
     }
 
     free_silhouettes();
+    free_city_layers();
 
     if (data.tooltip.texture) {
         SDL_DestroyTexture(data.tooltip.texture);
@@ -472,18 +559,8 @@ static SDL_Texture *get_texture(int texture_id)
     return data.texture_lists[type][texture_id & IMAGE_ATLAS_BIT_MASK];
 }
 
-static void set_texture_color_and_scale_mode(SDL_Texture *texture, color_t color, float scale)
+static void set_texture_scale_mode(SDL_Texture *texture, float scale)
 {
-    if (!color) {
-        color = COLOR_MASK_NONE;
-    }
-
-    SDL_SetTextureColorMod(texture,
-        (color & COLOR_CHANNEL_RED) >> COLOR_BITSHIFT_RED,
-        (color & COLOR_CHANNEL_GREEN) >> COLOR_BITSHIFT_GREEN,
-        (color & COLOR_CHANNEL_BLUE) >> COLOR_BITSHIFT_BLUE);
-    SDL_SetTextureAlphaMod(texture, (color & COLOR_CHANNEL_ALPHA) >> COLOR_BITSHIFT_ALPHA);
-
 #ifdef USE_TEXTURE_SCALE_MODE
     if (!HAS_TEXTURE_SCALE_MODE) {
         return;
@@ -498,11 +575,78 @@ static void set_texture_color_and_scale_mode(SDL_Texture *texture, color_t color
         desired_scale_mode = SDL_ScaleModeNearest;
     }
     if (current_scale_mode != desired_scale_mode) {
+        // Batched images of this texture must be drawn with the scale mode they were queued with
+        flush_batch();
         SDL_SetTextureScaleMode(texture, desired_scale_mode);
     }
 #endif
 }
 
+static void set_texture_color_and_scale_mode(SDL_Texture *texture, color_t color, float scale)
+{
+    if (!color) {
+        color = COLOR_MASK_NONE;
+    }
+
+    SDL_SetTextureColorMod(texture,
+        (color & COLOR_CHANNEL_RED) >> COLOR_BITSHIFT_RED,
+        (color & COLOR_CHANNEL_GREEN) >> COLOR_BITSHIFT_GREEN,
+        (color & COLOR_CHANNEL_BLUE) >> COLOR_BITSHIFT_BLUE);
+    SDL_SetTextureAlphaMod(texture, (color & COLOR_CHANNEL_ALPHA) >> COLOR_BITSHIFT_ALPHA);
+
+    set_texture_scale_mode(texture, scale);
+}
+
+#ifdef USE_RENDER_GEOMETRY
+static void add_to_batch(SDL_Texture *texture, const SDL_Rect *src, const SDL_FRect *dst, color_t color)
+{
+    if (texture != data.batch.texture || data.batch.num_images == MAX_BATCHED_IMAGES) {
+        flush_batch();
+        int width, height;
+        SDL_QueryTexture(texture, NULL, NULL, &width, &height);
+        data.batch.texture = texture;
+        data.batch.texture_width = (float) width;
+        data.batch.texture_height = (float) height;
+    }
+    if (!color) {
+        color = COLOR_MASK_NONE;
+    }
+    SDL_Color vertex_color = {
+        (color & COLOR_CHANNEL_RED) >> COLOR_BITSHIFT_RED,
+        (color & COLOR_CHANNEL_GREEN) >> COLOR_BITSHIFT_GREEN,
+        (color & COLOR_CHANNEL_BLUE) >> COLOR_BITSHIFT_BLUE,
+        (color & COLOR_CHANNEL_ALPHA) >> COLOR_BITSHIFT_ALPHA
+    };
+    float tex_left = src->x / data.batch.texture_width;
+    float tex_top = src->y / data.batch.texture_height;
+    float tex_right = (src->x + src->w) / data.batch.texture_width;
+    float tex_bottom = (src->y + src->h) / data.batch.texture_height;
+
+    SDL_Vertex *vertex = &data.batch.vertices[data.batch.num_images * 4];
+    vertex[0].position.x = dst->x;
+    vertex[0].position.y = dst->y;
+    vertex[0].tex_coord.x = tex_left;
+    vertex[0].tex_coord.y = tex_top;
+    vertex[1].position.x = dst->x + dst->w;
+    vertex[1].position.y = dst->y;
+    vertex[1].tex_coord.x = tex_right;
+    vertex[1].tex_coord.y = tex_top;
+    vertex[2].position.x = dst->x + dst->w;
+    vertex[2].position.y = dst->y + dst->h;
+    vertex[2].tex_coord.x = tex_right;
+    vertex[2].tex_coord.y = tex_bottom;
+    vertex[3].position.x = dst->x;
+    vertex[3].position.y = dst->y + dst->h;
+    vertex[3].tex_coord.x = tex_left;
+    vertex[3].tex_coord.y = tex_bottom;
+    for (int i = 0; i < 4; i++) {
+        vertex[i].color = vertex_color;
+    }
+    data.batch.num_images++;
+    data.statistics.batched_images++;
+}
+#endif
+
 static void draw_texture_advanced(const image *img, float x, float y, color_t color,
     float scale_x, float scale_y, double angle, int disable_coord_scaling)
 {
@@ -518,8 +662,6 @@ static void draw_texture_advanced(const image *img, float x, float y, color_t co
 
     float scale = scale_x == scale_y ? scale_x : 0.0f;
 
-    set_texture_color_and_scale_mode(texture, color, scale);
-
     x += img->x_offset;
     y += img->y_offset;
 
@@ -536,6 +678,25 @@ static void draw_texture_advanced(const image *img, float x, float y, color_t co
     float coord_scale_x = disable_coord_scaling ? 1.0f : scale_x;
     float coord_scale_y = disable_coord_scaling ? 1.0f : scale_y;
 
+#ifdef USE_RENDER_GEOMETRY
+    // Consecutive images from the same texture are drawn with a single call, which keeps the drawing order
+    if (HAS_RENDER_GEOMETRY && angle == 0.0) {
+        SDL_FRect dst_coords = {
+            (x + grid_correction) / coord_scale_x,
+            (y + grid_correction) / coord_scale_y,
+            (img->width - grid_correction) / scale_x,
+            (img->height - grid_correction) / scale_y
+        };
+        set_texture_scale_mode(texture, scale);
+        add_to_batch(texture, &src_coords, &dst_coords, color);
+        return;
+    }
+#endif
+
+    flush_batch();
+    set_texture_color_and_scale_mode(texture, color, scale);
+    data.statistics.draw_calls++;
+
 #ifdef USE_RENDERCOPYF
     if (HAS_RENDERCOPYF) {
         SDL_FRect dst_coords = {
@@ -565,6 +726,7 @@ static void draw_texture(const image *img, int x, int y, color_t color, float sc
 
 static void create_custom_texture(custom_image_type type, int width, int height, int is_yuv)
 {
+    flush_batch();
     if (data.paused) {
         return;
     }
@@ -591,6 +753,7 @@ static void create_custom_texture(custom_image_type type, int width, int height,
 
 static color_t *get_custom_texture_buffer(custom_image_type type, int *actual_texture_width)
 {
+    flush_batch();
     if (data.paused || !data.custom_textures[type].texture) {
         return 0;
     }
@@ -629,6 +792,7 @@ static void release_custom_texture_buffer(custom_image_type type)
 
 static void update_custom_texture(custom_image_type type)
 {
+    flush_batch();
 #ifndef __vita__
     if (data.paused || !data.custom_textures[type].texture || !data.custom_textures[type].buffer) {
         return;
@@ -643,6 +807,7 @@ static void update_custom_texture(custom_image_type type)
 static void update_custom_texture_from(custom_image_type type, const color_t *buffer,
     int x_offset, int y_offset, int width, int height)
 {
+    flush_batch();
     if (data.paused || !data.custom_textures[type].texture) {
         return;
     }
@@ -670,6 +835,7 @@ static void update_custom_texture_from(custom_image_type type, const color_t *bu
 static void update_custom_texture_yuv(custom_image_type type, const uint8_t *y_data, int y_width,
     const uint8_t *cb_data, int cb_width, const uint8_t *cr_data, int cr_width)
 {
+    flush_batch();
 #ifdef USE_YUV_TEXTURES
     if (data.paused || !data.supports_yuv_textures || !data.custom_textures[type].texture) {
         return;
@@ -688,6 +854,7 @@ static void update_custom_texture_yuv(custom_image_type type, const uint8_t *y_d
 
 static int start_tooltip_creation(int width, int height)
 {
+    flush_batch();
     if (data.paused) {
         return 0;
     }
@@ -725,6 +892,7 @@ static int start_tooltip_creation(int width, int height)
 
 static void finish_tooltip_creation(void)
 {
+    flush_batch();
     if (data.paused) {
         return;
     }
@@ -748,6 +916,118 @@ static void set_tooltip_opacity(int opacity)
     data.tooltip.opacity = calc_adjust_with_percentage(255, opacity);
 }
 
+static int supports_city_layers(void)
+{
+#ifdef USE_CUSTOM_BLEND_MODE
+    return HAS_CUSTOM_BLEND_MODE && !data.city_layers.unsupported && SDL_RenderTargetSupported(data.renderer);
+#else
+    return 0;
+#endif
+}
+
+static int start_city_layer_creation(int layer_id, int width, int height)
+{
+    flush_batch();
+#ifdef USE_CUSTOM_BLEND_MODE
+    if (data.paused || !supports_city_layers() || layer_id < 0 || layer_id >= MAX_CITY_LAYERS ||
+        width > data.max_texture_size.width || height > data.max_texture_size.height) {
+        return 0;
+    }
+    SDL_Texture *former_target = SDL_GetRenderTarget(data.renderer);
+    if (!former_target) {
+        return 0;
+    }
+    SDL_Texture **texture = &data.city_layers.layers[layer_id].texture;
+    if (*texture &&
+        (data.city_layers.layers[layer_id].width != width || data.city_layers.layers[layer_id].height != height)) {
+        SDL_DestroyTexture(*texture);
+        *texture = 0;
+    }
+    if (!*texture) {
+        *texture = SDL_CreateTexture(data.renderer, SDL_PIXELFORMAT_ABGR8888, SDL_TEXTUREACCESS_TARGET, width, height);
+        if (!*texture) {
+            return 0;
+        }
+        // The layer is drawn with regular alpha blending, which leaves its colors premultiplied by alpha
+        SDL_BlendMode premultiplied_blend_mode = SDL_ComposeCustomBlendMode(
+            SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD,
+            SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+        if (SDL_SetTextureBlendMode(*texture, premultiplied_blend_mode) != 0) {
+            SDL_Log("Custom blend modes are not supported, city layers will not be cached");
+            SDL_DestroyTexture(*texture);
+            *texture = 0;
+            data.city_layers.unsupported = 1;
+            return 0;
+        }
+#ifdef USE_TEXTURE_SCALE_MODE
+        if (HAS_TEXTURE_SCALE_MODE) {
+            SDL_SetTextureScaleMode(*texture, SDL_ScaleModeNearest);
+        }
+#endif
+        data.city_layers.layers[layer_id].width = width;
+        data.city_layers.layers[layer_id].height = height;
+    }
+    data.city_layers.former_target = former_target;
+    SDL_RenderGetViewport(data.renderer, &data.city_layers.former_viewport);
+    SDL_RenderGetClipRect(data.renderer, &data.city_layers.former_clip);
+
+    if (SDL_SetRenderTarget(data.renderer, *texture) != 0) {
+        SDL_DestroyTexture(*texture);
+        *texture = 0;
+        SDL_SetRenderTarget(data.renderer, former_target);
+        SDL_RenderSetViewport(data.renderer, &data.city_layers.former_viewport);
+        return 0;
+    }
+    SDL_SetRenderDrawColor(data.renderer, 0, 0, 0, 0);
+    SDL_RenderClear(data.renderer);
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+static void finish_city_layer_creation(void)
+{
+    flush_batch();
+    if (data.paused || !data.city_layers.former_target) {
+        return;
+    }
+    SDL_SetRenderTarget(data.renderer, data.city_layers.former_target);
+    SDL_RenderSetViewport(data.renderer, &data.city_layers.former_viewport);
+    if (data.city_layers.former_clip.w && data.city_layers.former_clip.h) {
+        SDL_RenderSetClipRect(data.renderer, &data.city_layers.former_clip);
+    } else {
+        SDL_RenderSetClipRect(data.renderer, NULL);
+    }
+    data.city_layers.former_target = 0;
+}
+
+static int has_city_layer(int layer_id)
+{
+    return layer_id >= 0 && layer_id < MAX_CITY_LAYERS && data.city_layers.layers[layer_id].texture != 0;
+}
+
+static void draw_city_layer(int layer_id, int x, int y, float scale)
+{
+    flush_batch();
+    if (data.paused || !has_city_layer(layer_id)) {
+        return;
+    }
+    SDL_Texture *texture = data.city_layers.layers[layer_id].texture;
+    int width = data.city_layers.layers[layer_id].width;
+    int height = data.city_layers.layers[layer_id].height;
+    data.statistics.draw_calls++;
+#ifdef USE_RENDERCOPYF
+    if (HAS_RENDERCOPYF) {
+        SDL_FRect dst_coords = { x / scale, y / scale, (float) width, (float) height };
+        SDL_RenderCopyF(data.renderer, texture, NULL, &dst_coords);
+        return;
+    }
+#endif
+    SDL_Rect dst_coords = { (int) round(x / scale), (int) round(y / scale), width, height };
+    SDL_RenderCopy(data.renderer, texture, NULL, &dst_coords);
+}
+
 static buffer_texture *get_saved_texture_info(int texture_id)
 {
     if (!texture_id || !data.texture_buffers.first) {
@@ -763,6 +1043,7 @@ static buffer_texture *get_saved_texture_info(int texture_id)
 
 static int save_to_texture(int texture_id, int x, int y, int width, int height)
 {
+    flush_batch();
     if (data.paused) {
         return 0;
     }
@@ -838,6 +1119,7 @@ static int save_to_texture(int texture_id, int x, int y, int width, int height)
 
 static void draw_saved_texture(int texture_id, int x, int y)
 {
+    flush_batch();
     if (data.paused) {
         return;
     }
@@ -845,6 +1127,7 @@ static void draw_saved_texture(int texture_id, int x, int y)
     if (!texture_info) {
         return;
     }
+    data.statistics.draw_calls++;
     SDL_Rect src_coords = { 0, 0, texture_info->width, texture_info->height };
     SDL_Rect dst_coords = { x, y, texture_info->width, texture_info->height };
     SDL_RenderCopy(data.renderer, texture_info->texture, &src_coords, &dst_coords);
@@ -852,6 +1135,7 @@ static void draw_saved_texture(int texture_id, int x, int y)
 
 static void create_blend_texture(custom_image_type type)
 {
+    flush_batch();
     SDL_Texture *texture = SDL_CreateTexture(data.renderer, SDL_PIXELFORMAT_ABGR8888, SDL_TEXTUREACCESS_TARGET, 58, 30);
     if (!texture) {
         return;
@@ -897,6 +1181,7 @@ static void create_blend_texture(custom_image_type type)
 
 static SDL_Texture *get_silhouette_texture(const image *img)
 {
+    flush_batch();
     if (data.paused) {
         return 0;
     }
@@ -1008,6 +1293,8 @@ static void draw_silhouetted_texture(const image *img, int x, int y, color_t col
     int grid_correction = (img->is_isometric && config_get(CONFIG_UI_SHOW_GRID) && data.city_scale > 2.0f) ? 2 :
         -src_correction;
 
+    data.statistics.draw_calls++;
+
 #ifdef USE_RENDERCOPYF
     if (HAS_RENDERCOPYF) {
         SDL_FRect dst_coords = { (x + grid_correction) / scale, (y + grid_correction) / scale,
@@ -1044,6 +1331,7 @@ static int has_custom_texture(custom_image_type type)
 
 static void load_unpacked_image(const image *img, const color_t *pixels)
 {
+    flush_batch();
     if (data.paused) {
         return;
     }
@@ -1105,8 +1393,20 @@ static void load_unpacked_image(const image *img, const color_t *pixels)
     SDL_FreeSurface(surface);
 }
 
+static int has_unpacked_image(const image *img)
+{
+    int unpacked_image_id = img->atlas.id & IMAGE_ATLAS_BIT_MASK;
+    for (int i = 0; i < MAX_UNPACKED_IMAGES; i++) {
+        if (data.unpacked_images[i].id == unpacked_image_id && data.unpacked_images[i].texture) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
 static void free_unpacked_image(const image *img)
 {
+    flush_batch();
     int unpacked_image_id = img->atlas.id & IMAGE_ATLAS_BIT_MASK;
     int found_id = -1;
     for (int i = 0; i < MAX_UNPACKED_IMAGES; i++) {
@@ -1137,6 +1437,12 @@ static void update_scale(int city_scale)
     data.city_scale = city_scale / 100.0f;
 }
 
+static void get_draw_statistics(int *draw_calls, int *batched_images)
+{
+    *draw_calls = data.statistics.last_draw_calls;
+    *batched_images = data.statistics.last_batched_images;
+}
+
 static int supports_yuv_texture(void)
 {
     return data.supports_yuv_textures;
@@ -1169,6 +1475,11 @@ static void create_renderer_interface(void)
     data.renderer_interface.set_tooltip_position = set_tooltip_position;
     data.renderer_interface.set_tooltip_opacity = set_tooltip_opacity;
     data.renderer_interface.has_tooltip = has_tooltip;
+    data.renderer_interface.supports_city_layers = supports_city_layers;
+    data.renderer_interface.start_city_layer_creation = start_city_layer_creation;
+    data.renderer_interface.finish_city_layer_creation = finish_city_layer_creation;
+    data.renderer_interface.has_city_layer = has_city_layer;
+    data.renderer_interface.draw_city_layer = draw_city_layer;
     data.renderer_interface.save_image_from_screen = save_to_texture;
     data.renderer_interface.draw_image_to_screen = draw_saved_texture;
     data.renderer_interface.save_screen_buffer = save_screen_buffer;
@@ -1179,9 +1490,11 @@ static void create_renderer_interface(void)
     data.renderer_interface.has_image_atlas = has_texture_atlas;
     data.renderer_interface.free_image_atlas = free_texture_atlas_and_data;
     data.renderer_interface.load_unpacked_image = load_unpacked_image;
+    data.renderer_interface.has_unpacked_image = has_unpacked_image;
     data.renderer_interface.free_unpacked_image = free_unpacked_image;
     data.renderer_interface.should_pack_image = should_pack_image;
     data.renderer_interface.update_scale = update_scale;
+    data.renderer_interface.get_draw_statistics = get_draw_statistics;
 
     graphics_renderer_set_interface(&data.renderer_interface);
 }
@@ -1244,6 +1557,19 @@ int platform_renderer_init(SDL_Window *window)
 
     SDL_SetRenderDrawColor(data.renderer, 0, 0, 0, 0xff);
 
+#ifdef USE_RENDER_GEOMETRY
+    for (int i = 0; i < MAX_BATCHED_IMAGES; i++) {
+        int *indices = &data.batch.indices[i * 6];
+        int first_vertex = i * 4;
+        indices[0] = first_vertex;
+        indices[1] = first_vertex + 1;
+        indices[2] = first_vertex + 2;
+        indices[3] = first_vertex;
+        indices[4] = first_vertex + 2;
+        indices[5] = first_vertex + 3;
+    }
+#endif
+
     create_renderer_interface();
 
     return 1;
@@ -1251,6 +1577,7 @@ int platform_renderer_init(SDL_Window *window)
 
 static void destroy_render_texture(void)
 {
+    flush_batch();
     if (data.render_texture) {
         SDL_DestroyTexture(data.render_texture);
         data.render_texture = 0;
@@ -1323,6 +1650,7 @@ int platform_renderer_lost_render_texture(void)
 
 void platform_renderer_invalidate_target_textures(void)
 {
+    flush_batch();
     if (data.custom_textures[CUSTOM_IMAGE_RED_FOOTPRINT].texture) {
         SDL_DestroyTexture(data.custom_textures[CUSTOM_IMAGE_RED_FOOTPRINT].texture);
         data.custom_textures[CUSTOM_IMAGE_RED_FOOTPRINT].texture = 0;
@@ -1337,6 +1665,7 @@ void platform_renderer_invalidate_target_textures(void)
         SDL_DestroyTexture(data.tooltip.texture);
         data.tooltip.texture = 0;
     }
+    free_city_layers();
 }
 
 void platform_renderer_clear(void)
@@ -1389,6 +1718,11 @@ static void draw_software_mouse_cursor(void)
 
 void platform_renderer_render(void)
 {
+    flush_batch();
+    data.statistics.last_draw_calls = data.statistics.draw_calls;
+    data.statistics.last_batched_images = data.statistics.batched_images;
+    data.statistics.draw_calls = 0;
+    data.statistics.batched_images = 0;
     if (data.paused) {
         return;
     }
@@ -1427,6 +1761,7 @@ void platform_renderer_generate_mouse_cursor_texture(int cursor_id, int size, co
 
 void platform_renderer_pause(void)
 {
+    flush_batch();
     SDL_SetRenderTarget(data.renderer, NULL);
     data.paused = 1;
 }
@@ -0,0 +1,125 @@
+#include "game/system.h"
+
+#include "core/log.h"
+
+#include "SDL.h"
+
+#include <stdint.h>
+
+#define MAX_WORKERS 16
+
+static struct {
+    int initialized;
+    int num_workers;
+    SDL_sem *start[MAX_WORKERS];
+    SDL_sem *finished;
+    void (*task)(int worker_id, void *userdata);
+    void *userdata;
+    struct {
+        SDL_Thread *thread;
+        void (*task)(void *userdata);
+        void (*finished)(void *userdata);
+        void *userdata;
+    } background;
+} data;
+
+static int run_worker(void *arg)
+{
+    int worker_id = (int) (intptr_t) arg;
+    while (1) {
+        SDL_SemWait(data.start[worker_id]);
+        data.task(worker_id, data.userdata);
+        SDL_SemPost(data.finished);
+    }
+    return 0;
+}
+
+static void init(void)
+{
+    data.initialized = 1;
+    data.num_workers = 1;
+    int num_cpus = SDL_GetCPUCount();
+    if (num_cpus > MAX_WORKERS) {
+        num_cpus = MAX_WORKERS;
+    }
+    if (num_cpus <= 1 || !(data.finished = SDL_CreateSemaphore(0))) {
+        return;
+    }
+    for (int i = 1; i < num_cpus; i++) {
+        data.start[i] = SDL_CreateSemaphore(0);
+        if (!data.start[i]) {
+            break;
+        }
+        SDL_Thread *thread = SDL_CreateThread(run_worker, "worker", (void *) (intptr_t) i);
+        if (!thread) {
+            SDL_DestroySemaphore(data.start[i]);
+            break;
+        }
+        SDL_DetachThread(thread);
+        data.num_workers++;
+    }
+    if (data.num_workers > 1) {
+        log_info("Number of worker threads:", 0, data.num_workers);
+    }
+}
+
+int system_get_num_workers(void)
+{
+    if (!data.initialized) {
+        init();
+    }
+    return data.num_workers;
+}
+
+void system_run_on_workers(void (*task)(int worker_id, void *userdata), void *userdata)
+{
+    if (!data.initialized) {
+        init();
+    }
+    data.task = task;
+    data.userdata = userdata;
+    for (int i = 1; i < data.num_workers; i++) {
+        SDL_SemPost(data.start[i]);
+    }
+    task(0, userdata);
+    for (int i = 1; i < data.num_workers; i++) {
+        SDL_SemWait(data.finished);
+    }
+}
+
+static int run_background_task(void *arg)
+{
+    data.background.task(data.background.userdata);
+    return 0;
+}
+
+static void finish_background_task(void)
+{
+    void (*finished)(void *userdata) = data.background.finished;
+    data.background.finished = 0;
+    if (finished) {
+        finished(data.background.userdata);
+    }
+}
+
+void system_run_in_background(void (*task)(void *userdata), void (*finished)(void *userdata), void *userdata)
+{
+    system_wait_for_background_task();
+    data.background.task = task;
+    data.background.finished = finished;
+    data.background.userdata = userdata;
+    data.background.thread = SDL_CreateThread(run_background_task, "background", 0);
+    if (!data.background.thread) {
+        task(userdata);
+        finish_background_task();
+    }
+}
+
+void system_wait_for_background_task(void)
+{
+    if (data.background.thread) {
+        SDL_WaitThread(data.background.thread, 0);
+        data.background.thread = 0;
+    }
+    finish_background_task();
+}
@@ -1721,6 +1721,8 @@ static translation_string all_strings[] = {
     {TR_CONFIG_CLEAR_WARNINGS_RIGHTCLICK,"Right click to clear warnings in city view"},
     {TR_CONFIG_GP_CH_STORAGE_REQUESTS_RESPECT_MAINTAIN, "Caesar's requests respect 'Maintaining'"},
     {TR_CONFIG_ENABLE_MARKET_RANGE, "Enable market range"},
+    {TR_CONFIG_GOAL_DIRECTED_ROUTING, "Faster route search for walkers"},
+    {TR_CONFIG_FAST_SAVE_FORMAT, "Fast save format (saves cannot be loaded by older versions)"},
     {TR_OVERLAY_HOUSING_TENTS, "Tents"},
     {TR_OVERLAY_HOUSING_SHACKS, "Shacks"},
     {TR_OVERLAY_HOUSING_HOVELS, "Hovels"},
@@ -1715,6 +1715,8 @@ typedef enum {
     TR_CONFIG_CLEAR_WARNINGS_RIGHTCLICK,
     TR_CONFIG_GP_CH_STORAGE_REQUESTS_RESPECT_MAINTAIN,
     TR_CONFIG_ENABLE_MARKET_RANGE,
+    TR_CONFIG_GOAL_DIRECTED_ROUTING,
+    TR_CONFIG_FAST_SAVE_FORMAT,
     TR_OVERLAY_HOUSING_TENTS,
     TR_OVERLAY_HOUSING_SHACKS,
     TR_OVERLAY_HOUSING_HOVELS,
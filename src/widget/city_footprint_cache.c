@@ -0,0 +1,369 @@
+#include "city_footprint_cache.h"
+
+#include "core/log.h"
+#include "graphics/renderer.h"
+#include "map/property.h"
+
+#include <stdlib.h>
+
+#define TILE_WIDTH_PIXELS 60
+#define HALF_TILE_WIDTH_PIXELS 30
+#define HALF_TILE_HEIGHT_PIXELS 15
+
+#define CHUNK_WIDTH_TILES 16
+#define CHUNK_HEIGHT_TILES 32
+#define CHUNKS_PER_ROW ((VIEW_X_MAX + CHUNK_WIDTH_TILES - 1) / CHUNK_WIDTH_TILES)
+#define CHUNKS_PER_COLUMN ((VIEW_Y_MAX + CHUNK_HEIGHT_TILES - 1) / CHUNK_HEIGHT_TILES)
+
+// Bigger footprints would spill out of the chunk margins, so they are drawn every frame
+#define MAX_CACHED_FOOTPRINT_SIZE 3
+
+#define CHUNK_MARGIN_LEFT HALF_TILE_WIDTH_PIXELS
+#define CHUNK_MARGIN_TOP (HALF_TILE_HEIGHT_PIXELS * (MAX_CACHED_FOOTPRINT_SIZE - 1))
+// The first row of a chunk can be shifted left by half a tile, so there is room for that on both sides
+#define CHUNK_WIDTH_PIXELS (CHUNK_MARGIN_LEFT + TILE_WIDTH_PIXELS * (CHUNK_WIDTH_TILES - 1 + \
+    MAX_CACHED_FOOTPRINT_SIZE) + HALF_TILE_WIDTH_PIXELS + 2)
+#define CHUNK_HEIGHT_PIXELS (CHUNK_MARGIN_TOP + HALF_TILE_HEIGHT_PIXELS * (CHUNK_HEIGHT_TILES + \
+    MAX_CACHED_FOOTPRINT_SIZE) + 2)
+
+#ifdef CHECK_FOOTPRINT_CACHE
+// The last layer is kept for drawing the reused chunks again, to compare them with the cached ones
+#define MAX_CHUNKS (MAX_CITY_LAYERS - 1)
+#define CHECK_LAYER (MAX_CITY_LAYERS - 1)
+#else
+#define MAX_CHUNKS MAX_CITY_LAYERS
+#endif
+
+#define SIGNATURE_START 0xcbf29ce484222325ULL
+#define SIGNATURE_PRIME 0x100000001b3ULL
+
+typedef struct {
+    int in_use;
+    int x;
+    int y;
+    int orientation;
+    int scale;
+    int offset_x;
+    int offset_y;
+    int second_row_x;
+    uint64_t signature;
+    unsigned int last_used_frame;
+} chunk;
+
+typedef struct {
+    int x;
+    int y;
+    int grid_offset;
+} uncached_tile;
+
+static struct {
+    chunk chunks[MAX_CHUNKS];
+    unsigned int frame;
+    footprint_signature_callback *signature;
+    map_callback *draw_footprint;
+    uint64_t current_signature;
+    uncached_tile uncached_tiles[CHUNK_WIDTH_TILES * CHUNK_HEIGHT_TILES];
+    int num_uncached_tiles;
+} data;
+
+static uint64_t get_tile_signature(int grid_offset)
+{
+    if (!map_property_is_draw_tile(grid_offset) ||
+        map_property_multi_tile_size(grid_offset) > MAX_CACHED_FOOTPRINT_SIZE) {
+        return 0;
+    }
+    return data.signature(grid_offset);
+}
+
+static uint64_t add_to_signature(uint64_t signature, uint64_t value)
+{
+    for (int i = 0; i < 8; i++) {
+        signature ^= value & 0xff;
+        signature *= SIGNATURE_PRIME;
+        value >>= 8;
+    }
+    return signature;
+}
+
+static void add_tile_to_chunk(int x, int y, int grid_offset)
+{
+    if (!map_property_is_draw_tile(grid_offset)) {
+        return;
+    }
+    uint64_t signature = get_tile_signature(grid_offset);
+    if (!signature) {
+        uncached_tile *tile = &data.uncached_tiles[data.num_uncached_tiles++];
+        tile->x = x;
+        tile->y = y;
+        tile->grid_offset = grid_offset;
+    }
+    data.current_signature = add_to_signature(data.current_signature, (uint64_t) grid_offset);
+    data.current_signature = add_to_signature(data.current_signature, signature);
+}
+
+static void draw_cached_tile(int x, int y, int grid_offset)
+{
+    if (get_tile_signature(grid_offset)) {
+        data.draw_footprint(x, y, grid_offset);
+    }
+}
+
+static void draw_all_tiles(int x, int y, int grid_offset)
+{
+    data.draw_footprint(x, y, grid_offset);
+}
+
+// Only city positions that are a multiple of the returned step fall on a whole screen pixel
+static int get_pixel_step(int scale)
+{
+    int a = scale;
+    int b = 100;
+    while (b) {
+        int remainder = a % b;
+        a = b;
+        b = remainder;
+    }
+    return scale / a;
+}
+
+// Moves the chunk origin back to a whole screen pixel, so that at any zoom the tiles in the chunk texture land on
+// the same screen pixels as when they are drawn directly. The offset of the first tile is stored in *offset.
+static int align_chunk_origin(int position, int margin, int step, int *offset)
+{
+    int origin = position - margin;
+    int remainder = origin % step;
+    if (remainder < 0) {
+        remainder += step;
+    }
+    origin -= remainder;
+    *offset = position - origin;
+    return origin;
+}
+
+static int find_chunk(int x, int y, int orientation, int scale)
+{
+    for (int i = 0; i < MAX_CHUNKS; i++) {
+        const chunk *c = &data.chunks[i];
+        if (c->in_use && c->x == x && c->y == y && c->orientation == orientation && c->scale == scale) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int get_free_chunk(void)
+{
+    int oldest = -1;
+    for (int i = 0; i < MAX_CHUNKS; i++) {
+        const chunk *c = &data.chunks[i];
+        if (!c->in_use) {
+            return i;
+        }
+        if (c->last_used_frame != data.frame &&
+            (oldest == -1 || c->last_used_frame < data.chunks[oldest].last_used_frame)) {
+            oldest = i;
+        }
+    }
+    return oldest;
+}
+
+static void get_chunk_texture_size(int scale, int *width, int *height)
+{
+    int step = get_pixel_step(scale);
+    *width = (CHUNK_WIDTH_PIXELS + step - 1) * 100 / scale + 1;
+    *height = (CHUNK_HEIGHT_PIXELS + step - 1) * 100 / scale + 1;
+}
+
+static int render_chunk(int index, int x_view, int y_view, int offset_x, int offset_y, int scale)
+{
+    const graphics_renderer_interface *renderer = graphics_renderer();
+    int width, height;
+    get_chunk_texture_size(scale, &width, &height);
+    if (!renderer->start_city_layer_creation(index, width, height)) {
+        return 0;
+    }
+    city_view_foreach_valid_map_tile_in_view_area(x_view, y_view, CHUNK_WIDTH_TILES, CHUNK_HEIGHT_TILES,
+        offset_x, offset_y, draw_cached_tile);
+    renderer->finish_city_layer_creation();
+    return 1;
+}
+
+#ifdef CHECK_FOOTPRINT_CACHE
+// Draws the cached chunk, or the chunk's tiles when index is -1, and reads back the result
+static int read_chunk_pixels(int index, int x_view, int y_view, int offset_x, int offset_y,
+    color_t *pixels, int width, int height)
+{
+    const graphics_renderer_interface *renderer = graphics_renderer();
+    if (!renderer->start_city_layer_creation(CHECK_LAYER, width, height)) {
+        return 0;
+    }
+    if (index >= 0) {
+        renderer->draw_city_layer(index, 0, 0, 1.0f);
+    } else {
+        city_view_foreach_valid_map_tile_in_view_area(x_view, y_view, CHUNK_WIDTH_TILES, CHUNK_HEIGHT_TILES,
+            offset_x, offset_y, draw_cached_tile);
+    }
+    int result = renderer->save_screen_buffer(pixels, 0, 0, width, height, width);
+    renderer->finish_city_layer_creation();
+    return result;
+}
+
+static void check_cached_chunk(int index, int x_view, int y_view, int offset_x, int offset_y, int scale)
+{
+    int width, height;
+    get_chunk_texture_size(scale, &width, &height);
+    color_t *cached = malloc(sizeof(color_t) * width * height);
+    color_t *direct = malloc(sizeof(color_t) * width * height);
+    if (cached && direct &&
+        read_chunk_pixels(index, x_view, y_view, offset_x, offset_y, cached, width, height) &&
+        read_chunk_pixels(-1, x_view, y_view, offset_x, offset_y, direct, width, height)) {
+        int mismatches = 0;
+        for (int i = 0; i < width * height; i++) {
+            if (cached[i] != direct[i]) {
+                if (!mismatches) {
+                    log_error("Cached footprint chunk differs from drawing it again, at view x", 0, x_view);
+                    log_error("Cached footprint chunk differs from drawing it again, at view y", 0, y_view);
+                }
+                mismatches++;
+            }
+        }
+        if (mismatches) {
+            log_error("Number of wrong pixels in the cached footprint chunk:", 0, mismatches);
+        }
+    }
+    free(cached);
+    free(direct);
+}
+#endif
+
+static void draw_chunk(int chunk_x, int chunk_y, int orientation, int scale)
+{
+    int x_view = chunk_x * CHUNK_WIDTH_TILES;
+    int y_view = chunk_y * CHUNK_HEIGHT_TILES;
+    int x, y;
+    city_view_view_tile_to_draw_position(x_view, y_view, &x, &y);
+    // Which rows are shifted by half a tile depends on the camera
+    int second_row_x, second_row_y;
+    city_view_view_tile_to_draw_position(x_view, y_view + 1, &second_row_x, &second_row_y);
+    second_row_x -= x;
+
+    int index = find_chunk(chunk_x, chunk_y, orientation, scale);
+    if (index < 0) {
+        index = get_free_chunk();
+    }
+    if (index < 0) {
+        // More chunks are visible than can be cached, so this one is drawn directly
+        city_view_foreach_valid_map_tile_in_view_area(x_view, y_view, CHUNK_WIDTH_TILES, CHUNK_HEIGHT_TILES,
+            x, y, draw_all_tiles);
+        return;
+    }
+
+    int step = get_pixel_step(scale);
+    int offset_x, offset_y;
+    int origin_x = align_chunk_origin(x, CHUNK_MARGIN_LEFT, step, &offset_x);
+    int origin_y = align_chunk_origin(y, CHUNK_MARGIN_TOP, step, &offset_y);
+
+    data.current_signature = SIGNATURE_START;
+    data.num_uncached_tiles = 0;
+    city_view_foreach_valid_map_tile_in_view_area(x_view, y_view, CHUNK_WIDTH_TILES, CHUNK_HEIGHT_TILES,
+        x, y, add_tile_to_chunk);
+
+    const graphics_renderer_interface *renderer = graphics_renderer();
+    chunk *c = &data.chunks[index];
+    int needs_render = !c->in_use || c->x != chunk_x || c->y != chunk_y || c->orientation != orientation ||
+        c->scale != scale || c->offset_x != offset_x || c->offset_y != offset_y || c->second_row_x != second_row_x ||
+        c->signature != data.current_signature || !renderer->has_city_layer(index);
+    if (needs_render) {
+        c->in_use = 0;
+        if (!render_chunk(index, x_view, y_view, offset_x, offset_y, scale)) {
+            city_view_foreach_valid_map_tile_in_view_area(x_view, y_view, CHUNK_WIDTH_TILES, CHUNK_HEIGHT_TILES,
+                x, y, draw_all_tiles);
+            return;
+        }
+        c->in_use = 1;
+        c->x = chunk_x;
+        c->y = chunk_y;
+        c->orientation = orientation;
+        c->scale = scale;
+        c->offset_x = offset_x;
+        c->offset_y = offset_y;
+        c->second_row_x = second_row_x;
+        c->signature = data.current_signature;
+    }
+#ifdef CHECK_FOOTPRINT_CACHE
+    if (!needs_render) {
+        check_cached_chunk(index, x_view, y_view, offset_x, offset_y, scale);
+    }
+#endif
+    c->last_used_frame = data.frame;
+    renderer->draw_city_layer(index, origin_x * 100 / scale, origin_y * 100 / scale, 1.0f);
+    for (int i = 0; i < data.num_uncached_tiles; i++) {
+        const uncached_tile *tile = &data.uncached_tiles[i];
+        data.draw_footprint(tile->x, tile->y, tile->grid_offset);
+    }
+}
+
+static void keep_chunk(int chunk_x, int chunk_y, int orientation, int scale)
+{
+    int index = find_chunk(chunk_x, chunk_y, orientation, scale);
+    if (index >= 0) {
+        data.chunks[index].last_used_frame = data.frame;
+    }
+}
+
+static int chunk_is_visible(int chunk_x, int chunk_y, int scale)
+{
+    int x, y;
+    city_view_view_tile_to_draw_position(chunk_x * CHUNK_WIDTH_TILES, chunk_y * CHUNK_HEIGHT_TILES, &x, &y);
+    int step = get_pixel_step(scale);
+    x -= CHUNK_MARGIN_LEFT + step - 1;
+    y -= CHUNK_MARGIN_TOP + step - 1;
+    int width = CHUNK_WIDTH_PIXELS + step - 1;
+    int height = CHUNK_HEIGHT_PIXELS + step - 1;
+    int viewport_x, viewport_y, viewport_width, viewport_height;
+    city_view_get_viewport(&viewport_x, &viewport_y, &viewport_width, &viewport_height);
+    return x * 100 < (viewport_x + viewport_width) * scale && (x + width) * 100 > viewport_x * scale &&
+        y * 100 < (viewport_y + viewport_height) * scale && (y + height) * 100 > viewport_y * scale;
+}
+
+int city_footprint_cache_draw(footprint_signature_callback *signature, map_callback *draw_footprint)
+{
+    const graphics_renderer_interface *renderer = graphics_renderer();
+    if (!renderer->supports_city_layers || !renderer->supports_city_layers()) {
+        return 0;
+    }
+    data.signature = signature;
+    data.draw_footprint = draw_footprint;
+    data.frame++;
+
+    int x_view, y_view, width, height;
+    city_view_get_visible_view_area(&x_view, &y_view, &width, &height);
+    int first_chunk_x = (x_view < 0 ? 0 : x_view) / CHUNK_WIDTH_TILES;
+    int first_chunk_y = (y_view < 0 ? 0 : y_view) / CHUNK_HEIGHT_TILES;
+    int last_chunk_x = (x_view + width - 1) / CHUNK_WIDTH_TILES;
+    int last_chunk_y = (y_view + height - 1) / CHUNK_HEIGHT_TILES;
+    if (last_chunk_x >= CHUNKS_PER_ROW) {
+        last_chunk_x = CHUNKS_PER_ROW - 1;
+    }
+    if (last_chunk_y >= CHUNKS_PER_COLUMN) {
+        last_chunk_y = CHUNKS_PER_COLUMN - 1;
+    }
+    int orientation = city_view_orientation();
+    int scale = city_view_get_scale();
+    // Claim the cached chunks that are still visible first, so that the new ones never replace them
+    for (int chunk_y = first_chunk_y; chunk_y <= last_chunk_y; chunk_y++) {
+        for (int chunk_x = first_chunk_x; chunk_x <= last_chunk_x; chunk_x++) {
+            if (chunk_is_visible(chunk_x, chunk_y, scale)) {
+                keep_chunk(chunk_x, chunk_y, orientation, scale);
+            }
+        }
+    }
+    for (int chunk_y = first_chunk_y; chunk_y <= last_chunk_y; chunk_y++) {
+        for (int chunk_x = first_chunk_x; chunk_x <= last_chunk_x; chunk_x++) {
+            if (chunk_is_visible(chunk_x, chunk_y, scale)) {
+                draw_chunk(chunk_x, chunk_y, orientation, scale);
+            }
+        }
+    }
+    return 1;
+}
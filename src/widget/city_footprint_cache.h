@@ -0,0 +1,26 @@
+#ifndef WIDGET_CITY_FOOTPRINT_CACHE_H
+#define WIDGET_CITY_FOOTPRINT_CACHE_H
+
+#include "city/view.h"
+
+#include <stdint.h>
+
+/**
+ * Returns a value that changes whenever the footprint drawn for the tile changes,
+ * or 0 when the tile changes too often to be cached and should be drawn every frame.
+ * It has to cover every value the draw callback reads for the tile, except the tile's position,
+ * the zoom and the orientation, which the cache tracks itself.
+ * Build with CHECK_FOOTPRINT_CACHE to compare every reused chunk with drawing it again.
+ */
+typedef uint64_t (footprint_signature_callback)(int grid_offset);
+
+/**
+ * Draws the footprints of all visible tiles, reusing the footprints drawn in previous frames
+ * for the parts of the city that did not change.
+ * @param signature Callback that describes what is drawn on a tile
+ * @param draw_footprint Callback that draws the footprint of a tile, without any side effects
+ * @return 1 if the footprints were drawn, 0 if the renderer can't cache them
+ */
+int city_footprint_cache_draw(footprint_signature_callback *signature, map_callback *draw_footprint);
+
+#endif // WIDGET_CITY_FOOTPRINT_CACHE_H
@@ -835,20 +835,19 @@ static void draw_animation(int x, int y, int grid_offset)
 
 static void draw_figures(int x, int y, int grid_offset)
 {
-    int figure_id = map_figure_at(grid_offset);
-    while (figure_id) {
+    int figure_id;
+    for (int i = 0; (figure_id = map_figure_at_index(grid_offset, i)) != 0; i++) {
         figure *f = figure_get(figure_id);
         if (!f->is_ghost && overlay->show_figure(f)) {
             city_draw_figure(f, x, y, scale, 0);
         }
-        figure_id = f->next_figure_id_on_same_tile;
     }
 }
 
 static void draw_elevated_figures(int x, int y, int grid_offset)
 {
-    int figure_id = map_figure_at(grid_offset);
-    while (figure_id > 0) {
+    int figure_id;
+    for (int i = 0; (figure_id = map_figure_at_index(grid_offset, i)) != 0; i++) {
         figure *f = figure_get(figure_id);
         if (((f->use_cross_country && !f->is_ghost && !f->dont_draw_elevated) || f->height_adjusted_ticks) && overlay->show_figure(f)) {
             city_draw_figure(f, x, y, scale, 0);
@@ -862,7 +861,6 @@ static void draw_elevated_figures(int x, int y, int grid_offset)
             }
 
         }
-        figure_id = f->next_figure_id_on_same_tile;
     }
 }
 
@@ -47,6 +47,7 @@
 #include "widget/city_building_ghost.h"
 #include "widget/city_figure.h"
 #include "widget/city_draw_highway.h"
+#include "widget/city_footprint_cache.h"
 
 #define OFFSET(x,y) (x + GRID_SIZE * y)
 
@@ -182,23 +183,54 @@ static int is_building_selected(const building *b)
 
 }
 
-static void draw_footprint(int x, int y, int grid_offset)
+static color_t get_footprint_color_mask(int building_id)
+{
+    if (!building_id) {
+        return 0;
+    }
+    building *b = building_get(building_id);
+    if (draw_building_as_deleted(b)) {
+        return COLOR_MASK_RED;
+    } else if (is_building_selected(b)) {
+        return get_building_color_mask(b);
+    }
+    return 0;
+}
+
+static int get_footprint_image_id(int grid_offset)
+{
+    if (map_property_is_constructing(grid_offset)) { //&&
+        //  !building_is_connectable(building_construction_type())) {
+        return image_group(GROUP_TERRAIN_OVERLAY);
+    }
+    return map_image_at(grid_offset);
+}
+
+static int is_animated_water(int image_id)
+{
+    return image_id >= draw_context.image_id_water_first && image_id <= draw_context.image_id_water_last;
+}
+
+static int has_highway_footprint(int grid_offset)
+{
+    return map_terrain_is(grid_offset, TERRAIN_HIGHWAY) && !map_terrain_is(grid_offset, TERRAIN_GATEHOUSE);
+}
+
+static int has_grid_overlay(int building_id)
+{
+    return !building_id && config_get(CONFIG_UI_SHOW_GRID) && draw_context.scale <= 2.0f;
+}
+
+static void update_footprint(int x, int y, int grid_offset)
 {
     sound_city_progress_ambient();
     building_construction_record_view_position(x, y, grid_offset);
     if (grid_offset < 0 || !map_property_is_draw_tile(grid_offset)) {
         return;
     }
-    // Valid grid_offset and leftmost tile -> draw
     int building_id = map_building_at(grid_offset);
-    color_t color_mask = 0;
     if (building_id) {
         building *b = building_get(building_id);
-        if (draw_building_as_deleted(b)) {
-            color_mask = COLOR_MASK_RED;
-        } else if (is_building_selected(b)) {
-            color_mask = get_building_color_mask(b);
-        }
         int view_x, view_y, view_width, view_height;
         city_view_get_viewport(&view_x, &view_y, &view_width, &view_height);
 
@@ -221,26 +253,47 @@ static void draw_footprint(int x, int y, int grid_offset)
     if (map_terrain_is(grid_offset, TERRAIN_GARDEN)) {
         sound_city_mark_building_view(BUILDING_GARDENS, 0, SOUND_DIRECTION_CENTER);
     }
-    int image_id = map_image_at(grid_offset);
-    if (map_property_is_constructing(grid_offset)) { //&&
-        //  !building_is_connectable(building_construction_type())) {
-        image_id = image_group(GROUP_TERRAIN_OVERLAY);
-    }
-    if (draw_context.advance_water_animation &&
-        image_id >= draw_context.image_id_water_first &&
-        image_id <= draw_context.image_id_water_last) {
+    int image_id = get_footprint_image_id(grid_offset);
+    if (draw_context.advance_water_animation && is_animated_water(image_id)) {
         image_id++;
         if (image_id > draw_context.image_id_water_last) {
             image_id = draw_context.image_id_water_first;
         }
         map_image_set(grid_offset, image_id);
     }
-    if (map_terrain_is(grid_offset, TERRAIN_HIGHWAY) && !map_terrain_is(grid_offset, TERRAIN_GATEHOUSE)) {
+}
+
+// Has to change whenever draw_footprint would draw the tile differently. It covers the footprint image,
+// including the construction overlay, the building's color mask and the grid overlay.
+// Tiles that draw_footprint draws in other ways, like highways or roamer previews, are never cached.
+static uint64_t get_footprint_signature(int grid_offset)
+{
+    int image_id = get_footprint_image_id(grid_offset);
+    // Water animates a few times per second and roamer previews use blend modes that can't be cached
+    if (is_animated_water(image_id) || has_highway_footprint(grid_offset) ||
+        figure_roamer_preview_get_frequency(grid_offset)) {
+        return 0;
+    }
+    int building_id = map_building_at(grid_offset);
+    return ((uint64_t) get_footprint_color_mask(building_id) << 32) | ((uint64_t) (image_id + 1) << 2) |
+        (has_grid_overlay(building_id) << 1) | config_get(CONFIG_UI_SHOW_GRID);
+}
+
+static void draw_footprint(int x, int y, int grid_offset)
+{
+    if (grid_offset < 0 || !map_property_is_draw_tile(grid_offset)) {
+        return;
+    }
+    // Valid grid_offset and leftmost tile -> draw
+    int building_id = map_building_at(grid_offset);
+    color_t color_mask = get_footprint_color_mask(building_id);
+    if (has_highway_footprint(grid_offset)) {
         city_draw_highway_footprint(x, y, draw_context.scale, grid_offset);
     } else {
-        image_draw_isometric_footprint_from_draw_tile(image_id, x, y, color_mask, draw_context.scale);
+        image_draw_isometric_footprint_from_draw_tile(get_footprint_image_id(grid_offset), x, y, color_mask,
+            draw_context.scale);
     }
-    if (!building_id && config_get(CONFIG_UI_SHOW_GRID) && draw_context.scale <= 2.0f) {
+    if (has_grid_overlay(building_id)) {
         //grid is drawn by the renderer directly at zoom > 200%
         static int grid_id = 0;
         if (!grid_id) {
@@ -504,8 +557,8 @@ static void draw_top(int x, int y, int grid_offset)
 
 static void draw_figures(int x, int y, int grid_offset)
 {
-    int figure_id = map_figure_at(grid_offset);
-    while (figure_id) {
+    int figure_id;
+    for (int i = 0; (figure_id = map_figure_at_index(grid_offset, i)) != 0; i++) {
         figure *f = figure_get(figure_id);
         if (figure_id == draw_context.selected_figure_id) {
             if (!f->is_ghost || f->height_adjusted_ticks) {
@@ -515,7 +568,6 @@ static void draw_figures(int x, int y, int grid_offset)
             int highlight = f->formation_id > 0 && f->formation_id == draw_context.highlighted_formation;
             city_draw_figure(f, x, y, draw_context.scale, highlight);
         }
-        figure_id = f->next_figure_id_on_same_tile;
     }
 }
 
@@ -891,10 +943,8 @@ static void draw_animation(int x, int y, int grid_offset)
 
 static void draw_elevated_figures(int x, int y, int grid_offset)
 {
-    int figure_id = map_figure_at(grid_offset);
-
-
-    while (figure_id > 0) {
+    int figure_id;
+    for (int i = 0; (figure_id = map_figure_at_index(grid_offset, i)) != 0; i++) {
         figure *f = figure_get(figure_id);
 
         if ((f->use_cross_country && !f->is_ghost && !f->dont_draw_elevated) || f->height_adjusted_ticks) {
@@ -910,7 +960,6 @@ static void draw_elevated_figures(int x, int y, int grid_offset)
             }
 
         }
-        figure_id = f->next_figure_id_on_same_tile;
     }
 }
 
@@ -1100,7 +1149,10 @@ void city_without_overlay_draw(int selected_figure_id, pixel_coordinate *figure_
     city_view_get_viewport(&x, &y, &width, &height);
     graphics_fill_rect(x, y, width, height, COLOR_BLACK);
     int should_mark_deleting = city_building_ghost_mark_deleting(tile);
-    city_view_foreach_valid_map_tile(draw_footprint);
+    city_view_foreach_valid_map_tile(update_footprint);
+    if (!city_footprint_cache_draw(get_footprint_signature, draw_footprint)) {
+        city_view_foreach_valid_map_tile(draw_footprint);
+    }
     if (!should_mark_deleting) {
         city_view_foreach_valid_map_tile_row(
             draw_top,
@@ -98,13 +98,12 @@ static void draw_top(int x, int y, int grid_offset)
 
 static void draw_flags(int x, int y, int grid_offset)
 {
-    int figure_id = map_figure_at(grid_offset);
-    while (figure_id) {
+    int figure_id;
+    for (int i = 0; (figure_id = map_figure_at_index(grid_offset, i)) != 0; i++) {
         figure *f = figure_get(figure_id);
         if (!f->is_ghost) {
             city_draw_figure(f, x, y, draw_context.scale, 0);
         }
-        figure_id = f->next_figure_id_on_same_tile;
     }
 }
 
@@ -463,8 +463,9 @@ static void init(int grid_offset)
         OFFSET(-1,-1), OFFSET(1,-1), OFFSET(-1,1), OFFSET(1,1)
     };
     for (int i = 0; i < 9 && context.figure.count < 7; i++) {
-        int figure_id = map_figure_at(grid_offset + FIGURE_OFFSETS[i]);
-        while (figure_id > 0 && context.figure.count < 7) {
+        int figure_id;
+        for (int j = 0; context.figure.count < 7 &&
+            (figure_id = map_figure_at_index(grid_offset + FIGURE_OFFSETS[i], j)) != 0; j++) {
             figure *f = figure_get(figure_id);
             if (f->state != FIGURE_STATE_DEAD &&
                 f->action_state != FIGURE_ACTION_149_CORPSE) {
@@ -491,7 +492,6 @@ static void init(int grid_offset)
                         break;
                 }
             }
-            figure_id = f->next_figure_id_on_same_tile;
         }
     }
     // check for legion figures
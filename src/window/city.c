@@ -19,6 +19,7 @@
 #include "figure/formation.h"
 #include "figure/formation_legion.h"
 #include "figure/roamer_preview.h"
+#include "game/game.h"
 #include "game/orientation.h"
 #include "game/settings.h"
 #include "game/state.h"
@@ -185,7 +186,8 @@ static void draw_custom_variables_text_display(void)
 static void draw_time_left(void)
 {
 
-    int fps_offset = config_get(CONFIG_UI_DISPLAY_FPS) * 2 * BLOCK_SIZE; // shift to the right if FPS is displayed
+    // shift to the right if FPS is displayed
+    int fps_offset = config_get(CONFIG_UI_DISPLAY_FPS) * game_fps_display_width();
     time_left_label_shown = fps_offset > 0; // if fps is shown skip first row anyway
     if ((scenario_criteria_time_limit_enabled() || scenario_criteria_survival_enabled()) && !city_victory_has_won()) {
         time_left_label_shown = 1;
@@ -563,7 +563,8 @@ static void confirm_save_file(int accepted, int checked)
         config_set(CONFIG_UI_ASK_CONFIRMATION_ON_FILE_OVERWRITE, 0);
     }
     if (data.type == FILE_TYPE_SAVED_GAME) {
-        if (!game_file_write_saved_game(filename)) {
+        // the file is written in the background, so wait for it to be able to report disk errors
+        if (!game_file_write_saved_game(filename) || !game_file_io_finish_writing_saved_game()) {
             window_plain_message_dialog_show(TR_SAVEGAME_NOT_ABLE_TO_SAVE_TITLE,
                 TR_SAVEGAME_NOT_ABLE_TO_SAVE_MESSAGE, 1);
             return;